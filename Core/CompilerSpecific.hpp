@@ -42,6 +42,12 @@
 
     #include <intrin.h>
 
+	#if defined(_M_IX86) || defined(_M_X64)
+		#define CPU_PAUSE() _mm_pause()
+	#elif defined(_M_ARM) || defined(_M_ARM64)
+		#define CPU_PAUSE() __yield()
+	#endif
+
 	using _IndexOfSignificantBitResultType = unsigned long;
 	using _IndexOfSignificantBitInputType = unsigned long;
     #define _MSNZB32(tosearch, result) _BitScanReverse(result, tosearch)
@@ -133,6 +139,12 @@
 
     #define _ASSUME(condition) do { if (!(condition)) { __builtin_unreachable(); } } while(0)
 
+	#if defined(__i386__) || defined(__x86_64__)
+		#define CPU_PAUSE() __builtin_ia32_pause()
+	#elif defined(__arm__) || defined(__aarch64__)
+		#define CPU_PAUSE() __asm__ __volatile__("yield")
+	#endif
+
 	#ifndef STDLIB_DISABLE_DIAGNOSTIC_OVERRIDES
 		#ifdef __clang__
 			#pragma clang diagnostic error "-Wswitch"
@@ -235,6 +247,11 @@ inline bool __BitTestAndSet64(long long *value, long long position)
     return isSet;
 }
 
+// tells the CPU that the thread is spin-waiting, a no-op where there's no such instruction
+#ifndef CPU_PAUSE
+	#define CPU_PAUSE() do {} while (0)
+#endif
+
 #if !defined(_ROTATE64R) || !defined(_ROTATE64L)
 	using _RotateBitsInput64 = unsigned long long;
     #define _ROTATE64R(val, shift) ((val >> shift) | (val << (64 - shift)))
@@ -327,4 +344,15 @@ inline bool __BitTestAndSet64(long long *value, long long position)
 #endif
 #ifndef _BITTESTANDSET64
     #define _BITTESTANDSET64(value, position) __BitTestAndSet64(value, position)
+#endif
+
+// instruction sets available at compile time, used to pick SIMD code paths
+#if defined(__AVX2__)
+	#define SIMD_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_SSE2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM) || defined(_M_ARM64)
+	#define SIMD_NEON
 #endif
\ No newline at end of file
@@ -1,26 +1,54 @@
 #include "_PreHeader.hpp"
 #include "DIWRSpinLock.hpp"
 #include "GenericFuncs.hpp"
+#include "Futex.hpp"
+#include <chrono>
 
 using namespace StdLib;
 
 // TODO: optimize memory_order
 
-DIWRSpinLock::DIWRSpinLock(DIWRSpinLock &&source) noexcept
+namespace
+{
+    constexpr ui32 BlockingSpinAttempts = 64; // how many times a waiter in the blocking mode retries before going to sleep
+}
+
+DIWRSpinLock::DIWRSpinLock(Mode mode) noexcept : _mode(mode)
+{}
+
+DIWRSpinLock::DIWRSpinLock(DIWRSpinLock &&source) noexcept : _mode(source._mode)
 {
     ASSUME(source._users.load() == 0 && _users.load() == 0); // can't move while locked
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+    LockProfiler::NameSet(_profile, LockProfiler::NameGet(source._profile)); // the stats stay with the source
+#endif
 }
 
 DIWRSpinLock &DIWRSpinLock::operator = (DIWRSpinLock &&source) noexcept
 {
     ASSUME(this != &source);
     ASSUME(source._users.load() == 0); // can't move while locked
+    ASSUME(_sleepers.load() == 0 && _writerTicketNext.load() == _writerTicketServing.load());
     _users.store(0);
+    _mode = source._mode;
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+    LockProfiler::NameSet(_profile, LockProfiler::NameGet(source._profile));
+#endif
     return *this;
 }
 
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+DIWRSpinLock::~DIWRSpinLock()
+{
+    LockProfiler::Unregister(_profile);
+}
+#endif
+
 auto DIWRSpinLock::Lock(LockType type) const -> Unlocker
 {
+    ui32 attempt = 0;
+    auto acquisition = ProfileAcquisition();
+
     switch (type)
     {
     case DIWRSpinLock::LockType::Read: // exclusive and pending exclusive must be 0, inclusive and read don't matter
@@ -32,10 +60,19 @@ auto DIWRSpinLock::Lock(LockType type) const -> Unlocker
             {
                 break;
             }
+            acquisition.Failed();
+            if (oldLock & (ExclusiveMask | PendingExclusiveMask))
+            {
+                WaitForChange(oldLock, attempt);
+            }
         }
         break;
     case DIWRSpinLock::LockType::Exclusive: // inclusive, exclusive and read must be 0, pending exclusive doesn't matter
         _users.fetch_add(ReadersMask + 1);
+        if (_mode == Mode::Blocking)
+        {
+            AcquireWriterTicket(acquisition);
+        }
         for (auto oldLock = _users.load();;)
         {
             oldLock &= PendingExclusiveMask;
@@ -44,7 +81,13 @@ auto DIWRSpinLock::Lock(LockType type) const -> Unlocker
             {
                 break;
             }
+            acquisition.Failed();
+            if (oldLock & ~PendingExclusiveMask)
+            {
+                WaitForChange(oldLock, attempt);
+            }
         }
+        _isExclusiveTicketOwner = _mode == Mode::Blocking;
         break;
     case DIWRSpinLock::LockType::Inclusive: // inclusive, exclusive and pending exclusive must be 0, read doesn't matter
         for (auto oldLock = _users.load();;)
@@ -55,10 +98,16 @@ auto DIWRSpinLock::Lock(LockType type) const -> Unlocker
             {
                 break;
             }
+            acquisition.Failed();
+            if (oldLock & ~ReadersMask)
+            {
+                WaitForChange(oldLock, attempt);
+            }
         }
         break;
     }
 
+    acquisition.Acquired();
     return Unlocker(*this, type);
 }
 
@@ -74,16 +123,33 @@ auto DIWRSpinLock::TryLock(LockType type) const -> std::optional<Unlocker>
         newLock = oldLock + 1;
         if (_users.compare_exchange_strong(oldLock, newLock))
         {
+            ProfileAcquisition().Acquired();
             return Unlocker(*this, type);
         }
         break;
     case DIWRSpinLock::LockType::Exclusive: // inclusive, exclusive, read and pending exclusive must be 0
+        if (_mode == Mode::Blocking)
+        {
+            // succeeds only if there are no queued writers, the ticket makes writers that come after it queue up
+            auto serving = _writerTicketServing.load();
+            auto expectedNext = serving;
+            if (!_writerTicketNext.compare_exchange_strong(expectedNext, serving + 1))
+            {
+                break;
+            }
+        }
         oldLock = 0;
         newLock = ExclusiveMask | (ReadersMask + 1);
         if (_users.compare_exchange_strong(oldLock, newLock))
         {
+            _isExclusiveTicketOwner = _mode == Mode::Blocking;
+            ProfileAcquisition().Acquired();
             return Unlocker(*this, type);
         }
+        if (_mode == Mode::Blocking)
+        {
+            ReleaseWriterTicket();
+        }
         break;
     case DIWRSpinLock::LockType::Inclusive: // inclusive, exclusive and pending exclusive must be 0, read doesn't matter
         oldLock = _users.load();
@@ -91,6 +157,7 @@ auto DIWRSpinLock::TryLock(LockType type) const -> std::optional<Unlocker>
         newLock = InclusiveMask | oldLock;
         if (_users.compare_exchange_strong(oldLock, newLock))
         {
+            ProfileAcquisition().Acquired();
             return Unlocker(*this, type);
         }
         break;
@@ -99,8 +166,46 @@ auto DIWRSpinLock::TryLock(LockType type) const -> std::optional<Unlocker>
     return std::nullopt;
 }
 
+auto DIWRSpinLock::TryLockFor(LockType type, i64 timeoutUSec) const -> std::optional<Unlocker>
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutUSec);
+    for (;;)
+    {
+        auto observed = _users.load();
+        if (auto unlocker = TryLock(type))
+        {
+            return unlocker;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return std::nullopt;
+        }
+
+        if (_mode == Mode::Blocking)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+            _sleepers.fetch_add(1);
+            Futex::WaitFor(_users, observed, static_cast<ui64>(std::max<i64>(left, 1)));
+            _sleepers.fetch_sub(1);
+        }
+        else
+        {
+            CPU_PAUSE();
+        }
+    }
+}
+
+auto DIWRSpinLock::LockMode() const -> Mode
+{
+    return _mode;
+}
+
 void DIWRSpinLock::Unlock(LockType type) const
 {
+    bool isReleasingTicket = false;
+
     switch (type)
     {
     case DIWRSpinLock::LockType::Read:
@@ -113,6 +218,7 @@ void DIWRSpinLock::Unlock(LockType type) const
         ASSUME(!Funcs::IsBitSet(_users.load(), InclusiveBitIndex));
         ASSUME((_users.load() & ReadersMask) == 0);
         ASSUME((_users.load() & PendingExclusiveMask) > 0);
+        isReleasingTicket = _isExclusiveTicketOwner; // must be read before the lock is released
         _users.fetch_sub((ReadersMask + 1) | ExclusiveMask); // remove exclusive flag, decrement pending exclusive counter
         break;
     case DIWRSpinLock::LockType::Inclusive:
@@ -121,10 +227,23 @@ void DIWRSpinLock::Unlock(LockType type) const
         _users.fetch_sub(InclusiveMask); // remove inclusive flag
         break;
     }
+
+    if (_mode == Mode::Blocking)
+    {
+        if (isReleasingTicket)
+        {
+            ReleaseWriterTicket();
+        }
+        WakeSleepers();
+    }
 }
 
 void DIWRSpinLock::Transition(LockType current, LockType target) const
 {
+    ui32 attempt = 0;
+    auto acquisition = ProfileAcquisition(); // used only by the transitions that can wait
+    bool isReleasingTicket = false;
+
     switch (current)
     {
     case LockType::Exclusive:
@@ -139,9 +258,11 @@ void DIWRSpinLock::Transition(LockType current, LockType target) const
             SOFTBREAK;
             break;
         case LockType::Inclusive:
+            isReleasingTicket = _isExclusiveTicketOwner;
             _users.fetch_add(InclusiveMask - ((ReadersMask + 1) | ExclusiveMask)); // remove exclusive flag, decrement pending exclusive counter, set inclusive flag
             break;
         case LockType::Read:
+            isReleasingTicket = _isExclusiveTicketOwner;
             _users.fetch_add(1 - ((ReadersMask + 1) | ExclusiveMask)); // remove exclusive flag, decrement pending exclusive counter, increment readers counter
             break;
         }
@@ -161,9 +282,16 @@ void DIWRSpinLock::Transition(LockType current, LockType target) const
                 oldLock |= InclusiveMask;
                 if (_users.compare_exchange_weak(oldLock, newLock))
                 {
+                    acquisition.Acquired();
                     break;
                 }
+                acquisition.Failed();
+                if (oldLock & ReadersMask)
+                {
+                    WaitForChange(oldLock, attempt);
+                }
             }
+            _isExclusiveTicketOwner = false; // upgrades skip the writers queue, they already hold the lock and waiting would deadlock
             break;
         case LockType::Inclusive:
             SOFTBREAK;
@@ -188,9 +316,16 @@ void DIWRSpinLock::Transition(LockType current, LockType target) const
                 oldLock |= 1;
                 if (_users.compare_exchange_weak(oldLock, newLock))
                 {
+                    acquisition.Acquired();
                     break;
                 }
+                acquisition.Failed();
+                if ((oldLock & ReadersMask) > 1 || (oldLock & InclusiveMask))
+                {
+                    WaitForChange(oldLock, attempt);
+                }
             }
+            _isExclusiveTicketOwner = false; // upgrades skip the writers queue, they already hold the lock and waiting would deadlock
             break;
         case LockType::Inclusive:
             for (auto oldLock = _users.load();;)
@@ -199,8 +334,14 @@ void DIWRSpinLock::Transition(LockType current, LockType target) const
                 auto newLock = InclusiveMask | (oldLock - 1);
                 if (_users.compare_exchange_weak(oldLock, newLock))
                 {
+                    acquisition.Acquired();
                     break;
                 }
+                acquisition.Failed();
+                if (oldLock & ~ReadersMask)
+                {
+                    WaitForChange(oldLock, attempt);
+                }
             }
             break;
         case LockType::Read:
@@ -209,6 +350,70 @@ void DIWRSpinLock::Transition(LockType current, LockType target) const
         }
 		break;
     }
+
+    if (_mode == Mode::Blocking)
+    {
+        if (isReleasingTicket)
+        {
+            ReleaseWriterTicket();
+        }
+        WakeSleepers();
+    }
+}
+
+void DIWRSpinLock::WaitForChange(atomicType observed, ui32 &attempt) const
+{
+    if (_mode == Mode::Spin || attempt < BlockingSpinAttempts)
+    {
+        attempt += _mode == Mode::Blocking;
+        CPU_PAUSE();
+        return;
+    }
+
+    // the sleepers counter is incremented before the futex re-checks the value and the wakers modify the value before
+    // checking the counter, so either the waker sees the sleeper or the futex sees the modified value
+    _sleepers.fetch_add(1);
+    Futex::Wait(_users, observed);
+    _sleepers.fetch_sub(1);
+}
+
+void DIWRSpinLock::WakeSleepers() const
+{
+    if (_sleepers.load() != 0)
+    {
+        Futex::WakeAll(_users);
+    }
+}
+
+void DIWRSpinLock::AcquireWriterTicket(LockProfiler::Acquisition &acquisition) const
+{
+    auto ticket = _writerTicketNext.fetch_add(1);
+    for (ui32 attempt = 0;; ++attempt)
+    {
+        auto serving = _writerTicketServing.load();
+        if (serving == ticket)
+        {
+            break;
+        }
+        acquisition.Failed();
+        if (attempt < BlockingSpinAttempts)
+        {
+            CPU_PAUSE();
+        }
+        else
+        {
+            Futex::Wait(_writerTicketServing, serving);
+        }
+    }
+}
+
+void DIWRSpinLock::ReleaseWriterTicket() const
+{
+    auto serving = _writerTicketServing.fetch_add(1) + 1;
+    if (_writerTicketNext.load() != serving) // somebody is waiting for their turn
+    {
+        Futex::WakeAll(_writerTicketServing);
+    }
 }
 
 DIWRSpinLock::Unlocker::Unlocker(const DIWRSpinLock &lock, DIWRSpinLock::LockType lockType) noexcept : _lock(&lock), _lockType(lockType)
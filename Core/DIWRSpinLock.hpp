@@ -1,5 +1,7 @@
 #pragma once
 
+#include "LockProfiler.hpp"
+
 namespace StdLib
 {
 	/* This lock supports 3 types of locking:
@@ -22,10 +24,29 @@ namespace StdLib
         static constexpr atomicType PendingExclusiveMask = 0x3FFF'0000;
         static constexpr atomicType ReadersMask = 0xFFFF;
 
+    public:
+        enum class LockType { Read, Exclusive, Inclusive };
+
+        // Spin: waiting threads spin, the lowest latency for locks that are held for a short time
+        // Blocking: waiting threads spin for a bit and then sleep on a futex, writers are admitted in the order of their arrival,
+        //   use it if locks can be held for a long time or if there can be more threads than cores
+        enum class Mode : ui8 { Spin, Blocking };
+
+    private:
 		alignas(64) mutable std::atomic<atomicType> _users{0};
+        Mode _mode = Mode::Spin;
+        mutable bool _isExclusiveTicketOwner = false; // accessed only by the exclusive owner, false if it got there through a transition
+
+        // used only by the blocking mode
+        alignas(64) mutable std::atomic<ui32> _sleepers{0}; // threads that are waiting on _users
+        mutable std::atomic<ui32> _writerTicketNext{0};
+        mutable std::atomic<ui32> _writerTicketServing{0};
+
+    #ifdef STDLIB_ENABLE_LOCK_PROFILING
+        LockProfiler::Record *_profile = LockProfiler::Register(this);
+    #endif
 
     public:
-        enum class LockType { Read, Exclusive, Inclusive };
 
         class Unlocker
         {
@@ -47,14 +68,57 @@ namespace StdLib
         };
 
         DIWRSpinLock() noexcept = default;
+        explicit DIWRSpinLock(Mode mode) noexcept;
         DIWRSpinLock(DIWRSpinLock &&source) noexcept;
         DIWRSpinLock &operator = (DIWRSpinLock &&source) noexcept;
+    #ifdef STDLIB_ENABLE_LOCK_PROFILING
+        ~DIWRSpinLock();
+    #endif
 
         [[nodiscard]] Unlocker Lock(LockType type) const;
         [[nodiscard]] std::optional<Unlocker> TryLock(LockType type) const; // avoid using it with LockType::Exclusive, there may always be some read/inclusive locks that will prevent it from ever succeeding
 
+        // keeps trying until the timeout expires, in the blocking mode the thread sleeps between the attempts (spins where Futex::WaitFor can't sleep),
+        // exclusive attempts don't take a place in the writers queue, so they give up if the queue isn't empty
+        // TimeDifference is a Platform type, it is accepted as a template to keep Core independent of Platform
+        template <typename TimeDifference> [[nodiscard]] std::optional<Unlocker> TryLock(LockType type, TimeDifference timeout) const
+        {
+            return TryLockFor(type, timeout.ToUSec_i64());
+        }
+
+        [[nodiscard]] Mode LockMode() const;
+
+        // the name the lock is reported with by LockProfiler, does nothing if the profiling is disabled
+        void ProfilingNameSet([[maybe_unused]] std::string_view name)
+        {
+        #ifdef STDLIB_ENABLE_LOCK_PROFILING
+            LockProfiler::NameSet(_profile, name);
+        #endif
+        }
+
+    #ifdef STDLIB_ENABLE_LOCK_PROFILING
+        [[nodiscard]] LockProfiler::Stats ProfilingStatsGet() const
+        {
+            return _profile->StatsGet();
+        }
+    #endif
+
     private:
+        [[nodiscard]] LockProfiler::Acquisition ProfileAcquisition() const
+        {
+        #ifdef STDLIB_ENABLE_LOCK_PROFILING
+            return LockProfiler::Acquisition(_profile);
+        #else
+            return {};
+        #endif
+        }
+
+        [[nodiscard]] std::optional<Unlocker> TryLockFor(LockType type, i64 timeoutUSec) const;
         void Unlock(LockType type) const;
         void Transition(LockType current, LockType target) const;
+        void WaitForChange(atomicType observed, ui32 &attempt) const;
+        void WakeSleepers() const;
+        void AcquireWriterTicket(LockProfiler::Acquisition &acquisition) const;
+        void ReleaseWriterTicket() const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,328 @@
+#include "_PreHeader.hpp"
+#include "DIWRSpinLockDistributed.hpp"
+#include "GenericFuncs.hpp"
+
+using namespace StdLib;
+
+// all operations use sequentially consistent ordering, a reader publishes itself in its slot and then checks
+// the writers' state, a writer publishes itself in the writers' state and then checks the slots, so at least one
+// of them is guaranteed to see the other, acquire/release isn't enough for that
+
+namespace
+{
+	std::atomic<ui32> NextReaderSlot{0};
+}
+
+DIWRSpinLockDistributed::DIWRSpinLockDistributed(DIWRSpinLockDistributed &&source) noexcept
+{
+	ASSUME(source._users.load() == 0 && source.CountReaders() == 0); // can't move while locked
+}
+
+DIWRSpinLockDistributed &DIWRSpinLockDistributed::operator = (DIWRSpinLockDistributed &&source) noexcept
+{
+	ASSUME(this != &source);
+	ASSUME(source._users.load() == 0 && source.CountReaders() == 0); // can't move while locked
+	ASSUME(_users.load() == 0 && CountReaders() == 0);
+	return *this;
+}
+
+auto DIWRSpinLockDistributed::Lock(LockType type) const -> Unlocker
+{
+	ui32 readerSlot = 0;
+
+	switch (type)
+	{
+	case LockType::Read: // exclusive and pending exclusive must be 0, inclusive doesn't matter
+		readerSlot = CurrentThreadReaderSlot();
+		for (;;)
+		{
+			if ((_users.load() & (ExclusiveMask | PendingExclusiveMask)) == 0 && TryAddReader(readerSlot))
+			{
+				break;
+			}
+			CPU_PAUSE();
+		}
+		break;
+	case LockType::Exclusive: // inclusive, exclusive and readers must be 0, pending exclusive doesn't matter
+		_users.fetch_add(PendingExclusiveIncrement); // stops new readers from coming in
+		for (;;)
+		{
+			WaitForNoReaders();
+			auto oldLock = _users.load() & PendingExclusiveMask;
+			if (_users.compare_exchange_strong(oldLock, oldLock | ExclusiveMask))
+			{
+				// a reader could've come in from an inclusive lock transition after the slots were checked
+				if (CountReaders() == 0)
+				{
+					break;
+				}
+				_users.fetch_sub(ExclusiveMask);
+			}
+			CPU_PAUSE();
+		}
+		break;
+	case LockType::Inclusive: // inclusive, exclusive and pending exclusive must be 0, readers don't matter
+		for (;;)
+		{
+			atomicType oldLock = 0;
+			if (_users.compare_exchange_weak(oldLock, InclusiveMask))
+			{
+				break;
+			}
+			CPU_PAUSE();
+		}
+		break;
+	}
+
+	return Unlocker(*this, type, readerSlot);
+}
+
+auto DIWRSpinLockDistributed::TryLock(LockType type) const -> std::optional<Unlocker>
+{
+	atomicType oldLock = 0;
+	ui32 readerSlot = 0;
+
+	switch (type)
+	{
+	case LockType::Read: // exclusive and pending exclusive must be 0, inclusive doesn't matter
+		readerSlot = CurrentThreadReaderSlot();
+		if ((_users.load() & (ExclusiveMask | PendingExclusiveMask)) == 0 && TryAddReader(readerSlot))
+		{
+			return Unlocker(*this, type, readerSlot);
+		}
+		break;
+	case LockType::Exclusive: // inclusive, exclusive, readers and pending exclusive must be 0
+		if (_users.compare_exchange_strong(oldLock, ExclusiveMask | PendingExclusiveIncrement))
+		{
+			if (CountReaders() == 0)
+			{
+				return Unlocker(*this, type, readerSlot);
+			}
+			_users.fetch_sub(ExclusiveMask | PendingExclusiveIncrement);
+		}
+		break;
+	case LockType::Inclusive: // inclusive, exclusive and pending exclusive must be 0, readers don't matter
+		if (_users.compare_exchange_strong(oldLock, InclusiveMask))
+		{
+			return Unlocker(*this, type, readerSlot);
+		}
+		break;
+	}
+
+	return std::nullopt;
+}
+
+void DIWRSpinLockDistributed::Unlock(LockType type, ui32 readerSlot) const
+{
+	switch (type)
+	{
+	case LockType::Read:
+		ASSUME(_readerSlots[readerSlot].readers.load() > 0);
+		ASSUME(!Funcs::IsBitSet(_users.load(), ExclusiveBitIndex));
+		_readerSlots[readerSlot].readers.fetch_sub(1);
+		break;
+	case LockType::Exclusive:
+		ASSUME(Funcs::IsBitSet(_users.load(), ExclusiveBitIndex));
+		ASSUME(!Funcs::IsBitSet(_users.load(), InclusiveBitIndex));
+		ASSUME((_users.load() & PendingExclusiveMask) > 0);
+		_users.fetch_sub(ExclusiveMask | PendingExclusiveIncrement); // remove exclusive flag, decrement pending exclusive counter
+		break;
+	case LockType::Inclusive:
+		ASSUME(!Funcs::IsBitSet(_users.load(), ExclusiveBitIndex));
+		ASSUME(Funcs::IsBitSet(_users.load(), InclusiveBitIndex));
+		_users.fetch_sub(InclusiveMask); // remove inclusive flag
+		break;
+	}
+}
+
+void DIWRSpinLockDistributed::Transition(LockType current, LockType target, ui32 &readerSlot) const
+{
+	switch (current)
+	{
+	case LockType::Exclusive:
+		ASSUME(Funcs::IsBitSet(_users.load(), ExclusiveBitIndex));
+		ASSUME(!Funcs::IsBitSet(_users.load(), InclusiveBitIndex));
+		ASSUME((_users.load() & PendingExclusiveMask) > 0);
+
+		switch (target)
+		{
+		case LockType::Exclusive:
+			SOFTBREAK;
+			break;
+		case LockType::Inclusive:
+			_users.fetch_add(InclusiveMask - (ExclusiveMask | PendingExclusiveIncrement)); // remove exclusive flag, decrement pending exclusive counter, set inclusive flag
+			break;
+		case LockType::Read:
+			readerSlot = CurrentThreadReaderSlot();
+			_readerSlots[readerSlot].readers.fetch_add(1); // must become a reader before the exclusive flag is removed
+			_users.fetch_sub(ExclusiveMask | PendingExclusiveIncrement);
+			break;
+		}
+		break;
+	case LockType::Inclusive:
+		ASSUME(Funcs::IsBitSet(_users.load(), InclusiveBitIndex));
+		ASSUME(!Funcs::IsBitSet(_users.load(), ExclusiveBitIndex));
+
+		switch (target)
+		{
+		case LockType::Exclusive:
+			_users.fetch_add(PendingExclusiveIncrement); // stops new readers from coming in
+			for (auto oldLock = _users.load();;)
+			{
+				oldLock &= PendingExclusiveMask;
+				auto newLock = oldLock | ExclusiveMask;
+				oldLock |= InclusiveMask;
+				if (_users.compare_exchange_weak(oldLock, newLock))
+				{
+					break;
+				}
+			}
+			WaitForNoReaders();
+			break;
+		case LockType::Inclusive:
+			SOFTBREAK;
+			break;
+		case LockType::Read:
+			readerSlot = CurrentThreadReaderSlot();
+			_readerSlots[readerSlot].readers.fetch_add(1); // must become a reader before the inclusive flag is removed
+			_users.fetch_sub(InclusiveMask);
+			break;
+		}
+		break;
+	case LockType::Read:
+		ASSUME(_readerSlots[readerSlot].readers.load() > 0);
+		ASSUME(!Funcs::IsBitSet(_users.load(), ExclusiveBitIndex));
+
+		switch (target)
+		{
+		case LockType::Exclusive:
+			// the read lock is kept until the exclusive flag is set, so no other writer can get in between,
+			// other writers never hold the exclusive flag while there are readers, so they can't block us
+			_users.fetch_add(PendingExclusiveIncrement);
+			for (auto oldLock = _users.load();;)
+			{
+				oldLock &= PendingExclusiveMask;
+				auto newLock = oldLock | ExclusiveMask;
+				if (_users.compare_exchange_weak(oldLock, newLock))
+				{
+					break;
+				}
+				CPU_PAUSE();
+			}
+			_readerSlots[readerSlot].readers.fetch_sub(1);
+			WaitForNoReaders();
+			break;
+		case LockType::Inclusive:
+			for (;;)
+			{
+				atomicType oldLock = 0;
+				if (_users.compare_exchange_weak(oldLock, InclusiveMask))
+				{
+					break;
+				}
+				CPU_PAUSE();
+			}
+			_readerSlots[readerSlot].readers.fetch_sub(1);
+			break;
+		case LockType::Read:
+			SOFTBREAK;
+			break;
+		}
+		break;
+	}
+}
+
+bool DIWRSpinLockDistributed::TryAddReader(ui32 readerSlot) const
+{
+	auto &readers = _readerSlots[readerSlot].readers;
+	readers.fetch_add(1);
+	if ((_users.load() & (ExclusiveMask | PendingExclusiveMask)) == 0)
+	{
+		return true;
+	}
+	readers.fetch_sub(1); // a writer came in, let it go first
+	return false;
+}
+
+auto DIWRSpinLockDistributed::CountReaders() const -> atomicType
+{
+	atomicType count = 0;
+	for (const auto &slot : _readerSlots)
+	{
+		count += slot.readers.load();
+	}
+	return count;
+}
+
+void DIWRSpinLockDistributed::WaitForNoReaders() const
+{
+	while (CountReaders() != 0)
+	{
+		CPU_PAUSE();
+	}
+}
+
+ui32 DIWRSpinLockDistributed::CurrentThreadReaderSlot()
+{
+	thread_local ui32 slot = NextReaderSlot.fetch_add(1, std::memory_order_relaxed) % ReaderSlotsCount;
+	return slot;
+}
+
+DIWRSpinLockDistributed::Unlocker::Unlocker(const DIWRSpinLockDistributed &lock, DIWRSpinLockDistributed::LockType lockType, ui32 readerSlot) noexcept : _lockType(lockType), _readerSlot(readerSlot), _lock(&lock)
+{}
+
+DIWRSpinLockDistributed::Unlocker::~Unlocker() noexcept
+{
+	ASSUME_DEBUG_ONLY(_lock == nullptr);
+}
+
+DIWRSpinLockDistributed::Unlocker::Unlocker(Unlocker &&source) noexcept : _lockType(source._lockType), _readerSlot(source._readerSlot), _lock(source._lock)
+{
+#ifdef DEBUG
+	source._lock = nullptr;
+#endif
+}
+
+auto DIWRSpinLockDistributed::Unlocker::operator = (Unlocker &&source) noexcept -> Unlocker &
+{
+	ASSUME_DEBUG_ONLY(_lock == nullptr);
+
+	ASSUME(this != &source);
+	_lock = source._lock;
+	_lockType = source._lockType;
+	_readerSlot = source._readerSlot;
+
+#ifdef DEBUG
+	source._lock = nullptr;
+#endif
+
+	return *this;
+}
+
+void DIWRSpinLockDistributed::Unlocker::Unlock()
+{
+	_lock->Unlock(_lockType, _readerSlot);
+
+#ifdef DEBUG
+	ASSUME(_lock);
+	_lock = nullptr;
+#endif
+}
+
+void DIWRSpinLockDistributed::Unlocker::Transition(DIWRSpinLockDistributed::LockType target)
+{
+	ASSUME_DEBUG_ONLY(_lock);
+	_lock->Transition(_lockType, target, _readerSlot);
+	_lockType = target;
+}
+
+auto DIWRSpinLockDistributed::Unlocker::LockType() const -> DIWRSpinLockDistributed::LockType
+{
+	return _lockType;
+}
+
+bool DIWRSpinLockDistributed::Unlocker::PointToSameLock(const Unlocker &other) const
+{
+	ASSUME_DEBUG_ONLY(_lock && other._lock);
+	return _lock == other._lock;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+namespace StdLib
+{
+	/* Read-mostly version of DIWRSpinLock, supports the same lock types and transitions.
+	   Readers don't share a counter, each thread is assigned to one of the cache line sized reader slots,
+	   so taking Read locks on different cores doesn't make them fight over a single cache line.
+	   The cost is moved to Exclusive lockers, they have to scan all the slots to make sure there are no readers left.
+	   Inclusive locks don't interact with the readers at all, so they're as cheap as in DIWRSpinLock.
+	   Note that the lock takes ReaderSlotsCount cache lines, so don't use it for locks that are rarely read.
+	*/
+	class DIWRSpinLockDistributed
+	{
+		friend class Unlocker;
+
+		using atomicType = ui32;
+
+		static constexpr atomicType InclusiveBitIndex = 31;
+		static constexpr atomicType InclusiveMask = 1u << 31;
+		static constexpr atomicType ExclusiveBitIndex = 30;
+		static constexpr atomicType ExclusiveMask = 1 << 30;
+		static constexpr atomicType PendingExclusiveMask = 0x3FFF'FFFF;
+		static constexpr atomicType PendingExclusiveIncrement = 1;
+
+	public:
+		static constexpr uiw ReaderSlotsCount = 32; // threads are distributed round robin, slots shared by several threads still work correctly
+
+	private:
+		struct alignas(64) ReaderSlot
+		{
+			std::atomic<atomicType> readers{0};
+		};
+
+		alignas(64) mutable std::atomic<atomicType> _users{0};
+		mutable std::array<ReaderSlot, ReaderSlotsCount> _readerSlots{};
+
+	public:
+		enum class LockType { Read, Exclusive, Inclusive };
+
+		class Unlocker
+		{
+			friend DIWRSpinLockDistributed;
+
+			LockType _lockType;
+			ui32 _readerSlot; // the reader slot is remembered so the lock can be released from a different thread
+			const DIWRSpinLockDistributed *_lock;
+
+			Unlocker(const DIWRSpinLockDistributed &lock, LockType lockType, ui32 readerSlot) noexcept;
+
+		public:
+			~Unlocker() noexcept;
+			Unlocker(Unlocker &&source) noexcept;
+			Unlocker &operator = (Unlocker &&source) noexcept;
+			void Unlock();
+			void Transition(LockType target);
+			[[nodiscard]] LockType LockType() const;
+			[[nodiscard]] bool PointToSameLock(const Unlocker &other) const;
+		};
+
+		DIWRSpinLockDistributed() noexcept = default;
+		DIWRSpinLockDistributed(DIWRSpinLockDistributed &&source) noexcept;
+		DIWRSpinLockDistributed &operator = (DIWRSpinLockDistributed &&source) noexcept;
+
+		[[nodiscard]] Unlocker Lock(LockType type) const;
+		[[nodiscard]] std::optional<Unlocker> TryLock(LockType type) const; // avoid using it with LockType::Exclusive, there may always be some read/inclusive locks that will prevent it from ever succeeding
+
+	private:
+		void Unlock(LockType type, ui32 readerSlot) const;
+		void Transition(LockType current, LockType target, ui32 &readerSlot) const;
+		[[nodiscard]] bool TryAddReader(ui32 readerSlot) const;
+		[[nodiscard]] atomicType CountReaders() const;
+		void WaitForNoReaders() const;
+		static ui32 CurrentThreadReaderSlot();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "_PreHeader.hpp"
+#include "EpochDomain.hpp"
+#include "SpinLock.hpp"
+#include <thread>
+
+using namespace StdLib;
+
+// the reasoning follows crossbeam-epoch: a pin is published with a relaxed store followed by a sequentially consistent fence,
+// the advancing thread issues the same fence before it checks the records, so either it sees the pin or the pinned
+// thread sees everything that was unlinked before the advance
+
+namespace
+{
+	std::atomic<ui64> NextDomainId{1};
+
+	// thread caches outlive the domains, a finished thread releases its records only if their domain is still alive
+	SpinLock &LiveDomainsLock()
+	{
+		static SpinLock lock;
+		return lock;
+	}
+
+	std::vector<ui64> &LiveDomains()
+	{
+		static std::vector<ui64> domains;
+		return domains;
+	}
+
+	bool IsDomainAlive(ui64 domainId) // the lock must be held
+	{
+		auto &domains = LiveDomains();
+		return std::find(domains.begin(), domains.end(), domainId) != domains.end();
+	}
+}
+
+struct EpochDomain::ThreadCache
+{
+	struct Entry
+	{
+		ui64 domainId;
+		ThreadRecord *record;
+	};
+
+	std::vector<Entry> entries{};
+
+	~ThreadCache()
+	{
+		for (const Entry &entry : entries)
+		{
+			ReleaseRecord(entry.domainId, entry.record);
+		}
+	}
+};
+
+EpochDomain::EpochDomain() : _id(NextDomainId.fetch_add(1, std::memory_order_relaxed))
+{
+	std::scoped_lock lock(LiveDomainsLock());
+	LiveDomains().push_back(_id);
+}
+
+EpochDomain::~EpochDomain()
+{
+	{
+		std::scoped_lock lock(LiveDomainsLock());
+		auto &domains = LiveDomains();
+		domains.erase(std::find(domains.begin(), domains.end(), _id));
+	}
+
+	ThreadRecord *record = _records.load(std::memory_order_acquire);
+	while (record)
+	{
+		ASSUME((record->epoch.load(std::memory_order_relaxed) & 1) == 0); // can't destroy a pinned domain
+		FreeRetired(record->retired, ui64_max);
+		ThreadRecord *next = record->next;
+		delete record;
+		record = next;
+	}
+}
+
+EpochDomain &EpochDomain::Global()
+{
+	static EpochDomain domain;
+	return domain;
+}
+
+auto EpochDomain::Pin() -> Guard
+{
+	ThreadRecord &record = CurrentThreadRecord();
+	if (record.pinsCount++ == 0)
+	{
+		ui64 epoch = _epoch.load(std::memory_order_relaxed);
+		record.epoch.store((epoch << 1) | 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst); // the pin must be visible before any shared pointer is read
+	}
+	return Guard(&record);
+}
+
+void EpochDomain::Retire(void *object, void (*deleter)(void *object))
+{
+	ThreadRecord &record = CurrentThreadRecord();
+	ASSUME_DEBUG_ONLY(record.pinsCount > 0);
+	std::atomic_thread_fence(std::memory_order_seq_cst); // the object was unlinked before the epoch it's tagged with
+	record.retired.push_back({object, deleter, _epoch.load(std::memory_order_relaxed)});
+	if (record.retired.size() >= record.collectAt)
+	{
+		Collect();
+	}
+}
+
+uiw EpochDomain::Collect()
+{
+	ThreadRecord &record = CurrentThreadRecord();
+	uiw freed = 0;
+	if (!record.retired.empty())
+	{
+		[[maybe_unused]] bool isAdvanced = TryAdvance();
+		ui64 epoch = _epoch.load(std::memory_order_acquire);
+		if (epoch >= 2)
+		{
+			freed = FreeRetired(record.retired, epoch - 2);
+		}
+	}
+	// if something blocks the reclamation, the list isn't rescanned on every retire
+	record.collectAt = record.retired.size() + CollectThreshold;
+	return freed;
+}
+
+void EpochDomain::Synchronize()
+{
+	ThreadRecord &record = CurrentThreadRecord();
+	ASSUME(record.pinsCount == 0);
+	if (record.retired.empty())
+	{
+		return;
+	}
+
+	ui64 target = record.retired.back().epoch + 2; // the epochs are retired in non-decreasing order
+	while (_epoch.load(std::memory_order_acquire) < target)
+	{
+		if (!TryAdvance())
+		{
+			std::this_thread::yield();
+		}
+	}
+	FreeRetired(record.retired, target - 2);
+	record.collectAt = CollectThreshold;
+}
+
+uiw EpochDomain::PendingCount()
+{
+	return CurrentThreadRecord().retired.size();
+}
+
+ui64 EpochDomain::Epoch() const
+{
+	return _epoch.load(std::memory_order_acquire);
+}
+
+auto EpochDomain::CurrentThreadRecord() -> ThreadRecord &
+{
+	for (const ThreadCache::Entry &entry : CurrentThreadCache().entries)
+	{
+		if (entry.domainId == _id)
+		{
+			return *entry.record;
+		}
+	}
+	return AcquireRecord();
+}
+
+auto EpochDomain::AcquireRecord() -> ThreadRecord &
+{
+	ThreadRecord *record = nullptr;
+
+	// the records of the finished threads are reused with the objects they've left retired
+	for (ThreadRecord *current = _records.load(std::memory_order_acquire); current; current = current->next)
+	{
+		bool isInUse = false;
+		if (!current->isInUse.load(std::memory_order_relaxed) && current->isInUse.compare_exchange_strong(isInUse, true, std::memory_order_acquire))
+		{
+			record = current;
+			break;
+		}
+	}
+
+	if (record == nullptr)
+	{
+		record = new ThreadRecord;
+		record->next = _records.load(std::memory_order_relaxed);
+		while (!_records.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed))
+		{}
+	}
+
+	auto &entries = CurrentThreadCache().entries;
+	{
+		// the entries of the destroyed domains are dropped here, so a thread that goes through many domains doesn't accumulate them
+		std::scoped_lock lock(LiveDomainsLock());
+		entries.erase(std::remove_if(entries.begin(), entries.end(), [](const ThreadCache::Entry &entry) { return !IsDomainAlive(entry.domainId); }), entries.end());
+	}
+	entries.push_back({_id, record});
+	return *record;
+}
+
+bool EpochDomain::TryAdvance()
+{
+	ui64 epoch = _epoch.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	for (ThreadRecord *record = _records.load(std::memory_order_acquire); record; record = record->next)
+	{
+		ui64 recordEpoch = record->epoch.load(std::memory_order_relaxed);
+		if ((recordEpoch & 1) && (recordEpoch >> 1) != epoch)
+		{
+			return false; // pinned in the previous epoch
+		}
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire); // the frees must happen after the unpins
+	return _epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_release, std::memory_order_relaxed);
+}
+
+void EpochDomain::Unpin(ThreadRecord &record)
+{
+	ASSUME(record.pinsCount > 0);
+	if (--record.pinsCount == 0)
+	{
+		record.epoch.store(0, std::memory_order_release);
+	}
+}
+
+uiw EpochDomain::FreeRetired(std::vector<RetiredObject> &retired, ui64 safeEpoch)
+{
+	auto firstSafe = std::stable_partition(retired.begin(), retired.end(), [safeEpoch](const RetiredObject &object) { return object.epoch > safeEpoch; });
+	if (firstSafe == retired.end())
+	{
+		return 0;
+	}
+
+	// the deleters can retire more objects, so the ones being freed are moved out of the list first
+	std::vector<RetiredObject> toFree(firstSafe, retired.end());
+	retired.erase(firstSafe, retired.end());
+	for (const RetiredObject &object : toFree)
+	{
+		object.deleter(object.object);
+	}
+	return toFree.size();
+}
+
+void EpochDomain::ReleaseRecord(ui64 domainId, ThreadRecord *record)
+{
+	std::scoped_lock lock(LiveDomainsLock());
+	if (IsDomainAlive(domainId))
+	{
+		ASSUME(record->pinsCount == 0);
+		record->isInUse.store(false, std::memory_order_release);
+	}
+}
+
+auto EpochDomain::CurrentThreadCache() -> ThreadCache &
+{
+	thread_local ThreadCache cache;
+	return cache;
+}
+
+EpochDomain::Guard::Guard(ThreadRecord *record) noexcept : _record(record)
+{}
+
+EpochDomain::Guard::~Guard() noexcept
+{
+	ASSUME_DEBUG_ONLY(_record == nullptr);
+}
+
+EpochDomain::Guard::Guard(Guard &&source) noexcept : _record(source._record)
+{
+	source._record = nullptr;
+}
+
+auto EpochDomain::Guard::operator = (Guard &&source) noexcept -> Guard &
+{
+	ASSUME(this != &source);
+	ASSUME_DEBUG_ONLY(_record == nullptr);
+	_record = source._record;
+	source._record = nullptr;
+	return *this;
+}
+
+void EpochDomain::Guard::Unpin()
+{
+	ASSUME(_record);
+	EpochDomain::Unpin(*_record);
+	_record = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Allocators.hpp"
+
+namespace StdLib
+{
+	/* Epoch-based memory reclamation for lock-free structures.
+	   A thread pins the domain before it reads the shared pointers and unpins it when it no longer uses them. An object that
+	   was unlinked from the shared structure is retired instead of being freed, it's freed when the global epoch has advanced
+	   twice since it was retired, at that point every thread that could have seen it has unpinned.
+	   The global epoch advances only when every pinned thread has observed the current one, so a thread that stays pinned
+	   blocks the reclamation (but not the other threads), keep the pinned sections short.
+	   Every thread has its own retire list, retiring takes no locks, the list is collected in batches of CollectThreshold.
+	   Pins nest, only the outermost one publishes the epoch. A record of a finished thread is reused by the next thread
+	   that uses the domain, along with the objects it hasn't freed yet.
+	   The destructor frees all the retired objects, the domain must not be used by other threads at that point.
+	*/
+	class EpochDomain
+	{
+		struct ThreadRecord;
+
+	public:
+		static constexpr uiw CollectThreshold = 64;
+
+		class Guard
+		{
+			friend EpochDomain;
+
+			ThreadRecord *_record;
+
+			explicit Guard(ThreadRecord *record) noexcept;
+
+		public:
+			~Guard() noexcept;
+			Guard(Guard &&source) noexcept;
+			Guard &operator = (Guard &&source) noexcept;
+			void Unpin();
+		};
+
+	private:
+		struct RetiredObject
+		{
+			void *object;
+			void (*deleter)(void *object);
+			ui64 epoch;
+		};
+
+		struct alignas(64) ThreadRecord
+		{
+			std::atomic<ui64> epoch{0}; // the pinned epoch shifted left by one, the lowest bit is set while pinned
+			std::atomic<bool> isInUse{true};
+			ThreadRecord *next = nullptr; // records are only ever added to the list
+			// the rest is touched only by the thread that owns the record
+			ui32 pinsCount = 0;
+			uiw collectAt = CollectThreshold;
+			std::vector<RetiredObject> retired{};
+		};
+
+		struct ThreadCache;
+
+		alignas(64) std::atomic<ui64> _epoch{0};
+		alignas(64) std::atomic<ThreadRecord *> _records{};
+		ui64 _id = 0; // thread caches are keyed on it rather than on the address, which can be reused by another domain
+
+	public:
+		EpochDomain();
+		~EpochDomain();
+		EpochDomain(const EpochDomain &) = delete;
+		EpochDomain &operator = (const EpochDomain &) = delete;
+
+		// the shared domain for the structures that don't need their own
+		[[nodiscard]] static EpochDomain &Global();
+
+		// the guard must be unpinned by the thread that pinned it
+		[[nodiscard]] Guard Pin();
+
+		// the object must already be unreachable for the threads that pin the domain from now on,
+		// the calling thread must be pinned, the object is freed two epochs after the one it's retired in
+		void Retire(void *object, void (*deleter)(void *object));
+
+		template <typename T, typename AllocatorT = Allocator::Malloc> void Retire(T *object)
+		{
+			Retire(object, [](void *retired)
+			{
+				T *typed = static_cast<T *>(retired);
+				typed->~T();
+				AllocatorT::Free(typed);
+			});
+		}
+
+		template <typename T> void RetireDelete(T *object)
+		{
+			Retire(object, [](void *retired) { delete static_cast<T *>(retired); });
+		}
+
+		// frees the calling thread's retired objects that are safe to free, returns how many were freed
+		uiw Collect();
+
+		// waits until everything the calling thread has retired can be freed and frees it, the calling thread must not be pinned
+		void Synchronize();
+
+		// how many objects retired by the calling thread haven't been freed yet
+		[[nodiscard]] uiw PendingCount();
+
+		[[nodiscard]] ui64 Epoch() const;
+
+	private:
+		[[nodiscard]] ThreadRecord &CurrentThreadRecord();
+		[[nodiscard]] ThreadRecord &AcquireRecord();
+		[[nodiscard]] bool TryAdvance();
+		static void Unpin(ThreadRecord &record);
+		static uiw FreeRetired(std::vector<RetiredObject> &retired, ui64 safeEpoch);
+		static void ReleaseRecord(ui64 domainId, ThreadRecord *record);
+		static ThreadCache &CurrentThreadCache();
+	};
+}
\ No newline at end of file
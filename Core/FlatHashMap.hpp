@@ -0,0 +1,656 @@
+#pragma once
+
+#include "HashFuncs.hpp"
+#include "Allocators.hpp"
+
+#if defined(SIMD_SSE2)
+	#include <emmintrin.h>
+#elif defined(SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+namespace StdLib
+{
+	namespace HashPolicy
+	{
+		// for integers, enums, pointers and other trivial types up to 8 bytes
+		struct Integer
+		{
+			template <typename T> [[nodiscard]] static ui64 Hash(const T &value)
+			{
+				return Hash::Integer<Hash::Precision::P64>(value);
+			}
+		};
+
+		// hashes the object's bytes, strings and string views are hashed by their characters
+		struct FNV
+		{
+			template <typename T> [[nodiscard]] static ui64 Hash(const T &value)
+			{
+				return Hash::FNVHash<Hash::Precision::P64>(value);
+			}
+		};
+	}
+
+	namespace _Private
+	{
+		// control byte of every slot, the full slots store the lowest 7 bits of the hash, the high bit is set for the rest
+		enum class FlatHashControl : i8
+		{
+			Empty = -128,
+			Deleted = -2
+		};
+
+		// masks of the slots within a group that satisfied a condition, NEON uses 4 bits per slot
+		template <typename MaskType, uiw Shift> class FlatHashBitMask
+		{
+			MaskType _mask;
+
+		public:
+			explicit FlatHashBitMask(MaskType mask) : _mask(mask)
+			{}
+
+			[[nodiscard]] explicit operator bool() const
+			{
+				return _mask != 0;
+			}
+
+			[[nodiscard]] uiw Lowest() const
+			{
+				return Funcs::IndexOfLeastSignificantNonZeroBit(_mask) >> Shift;
+			}
+
+			void RemoveLowest()
+			{
+				_mask &= _mask - 1;
+			}
+		};
+
+		// 16 control bytes are probed at once
+		struct FlatHashGroup
+		{
+			static constexpr uiw size = 16;
+
+		#if defined(SIMD_SSE2)
+			using BitMask = FlatHashBitMask<ui32, 0>;
+
+			__m128i _control;
+
+			explicit FlatHashGroup(const i8 *control) : _control(_mm_loadu_si128(reinterpret_cast<const __m128i *>(control)))
+			{}
+
+			[[nodiscard]] BitMask Match(i8 hash) const
+			{
+				return BitMask(static_cast<ui32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_control, _mm_set1_epi8(hash)))));
+			}
+
+			[[nodiscard]] BitMask MatchEmpty() const
+			{
+				return Match(static_cast<i8>(FlatHashControl::Empty));
+			}
+
+			[[nodiscard]] BitMask MatchEmptyOrDeleted() const
+			{
+				return BitMask(static_cast<ui32>(_mm_movemask_epi8(_control)));
+			}
+		#elif defined(SIMD_NEON)
+			using BitMask = FlatHashBitMask<ui64, 2>;
+
+			int8x16_t _control;
+
+			explicit FlatHashGroup(const i8 *control) : _control(vld1q_s8(control))
+			{}
+
+			// narrows every byte of the comparison result to a nibble, then leaves one bit per nibble
+			[[nodiscard]] static BitMask ToMask(uint8x16_t comparison)
+			{
+				uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(comparison), 4);
+				return BitMask(vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull);
+			}
+
+			[[nodiscard]] BitMask Match(i8 hash) const
+			{
+				return ToMask(vceqq_s8(_control, vdupq_n_s8(hash)));
+			}
+
+			[[nodiscard]] BitMask MatchEmpty() const
+			{
+				return Match(static_cast<i8>(FlatHashControl::Empty));
+			}
+
+			[[nodiscard]] BitMask MatchEmptyOrDeleted() const
+			{
+				return ToMask(vcltq_s8(_control, vdupq_n_s8(0)));
+			}
+		#else
+			using BitMask = FlatHashBitMask<ui32, 0>;
+
+			const i8 *_control;
+
+			explicit FlatHashGroup(const i8 *control) : _control(control)
+			{}
+
+			[[nodiscard]] BitMask Match(i8 hash) const
+			{
+				ui32 mask = 0;
+				for (uiw index = 0; index < size; ++index)
+				{
+					mask |= static_cast<ui32>(_control[index] == hash) << index;
+				}
+				return BitMask(mask);
+			}
+
+			[[nodiscard]] BitMask MatchEmpty() const
+			{
+				return Match(static_cast<i8>(FlatHashControl::Empty));
+			}
+
+			[[nodiscard]] BitMask MatchEmptyOrDeleted() const
+			{
+				ui32 mask = 0;
+				for (uiw index = 0; index < size; ++index)
+				{
+					mask |= static_cast<ui32>(_control[index] < 0) << index;
+				}
+				return BitMask(mask);
+			}
+		#endif
+		};
+
+		// open addressing table with Swiss table style metadata: a separate array of control bytes is probed group by group,
+		// the slots are touched only when the lowest 7 bits of the hash match, groups are probed quadratically
+		// Traits must provide KeyType, SlotType and static const KeyType &KeyOf(const SlotType &)
+		template <typename Traits, typename HashPolicyType, typename AllocatorType, typename KeyEqual> class FlatHashTable
+		{
+		public:
+			using keyType = typename Traits::KeyType;
+			using slotType = typename Traits::SlotType;
+
+		private:
+			static_assert(alignof(slotType) <= MinimalGuaranteedAlignment, "slots with extended alignment aren't supported");
+
+			static constexpr uiw GroupSize = FlatHashGroup::size;
+
+			i8 *_control = nullptr;
+			slotType *_slots = nullptr;
+			uiw _capacity = 0; // always 0 or a power of two that's at least GroupSize
+			uiw _size = 0;
+			uiw _growthLeft = 0; // how many empty slots can still be filled before the table has to be rehashed
+
+			template <bool IsConst> class IteratorBase
+			{
+				friend FlatHashTable;
+				friend IteratorBase<!IsConst>;
+
+				using tableType = std::conditional_t<IsConst, const FlatHashTable, FlatHashTable>;
+
+				tableType *_table = nullptr;
+				uiw _index = 0;
+
+				IteratorBase(tableType *table, uiw index) : _table(table), _index(index)
+				{
+					SkipNonFull();
+				}
+
+				void SkipNonFull()
+				{
+					while (_index < _table->_capacity && _table->_control[_index] < 0)
+					{
+						++_index;
+					}
+				}
+
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = slotType;
+				using difference_type = iw;
+				using pointer = std::conditional_t<IsConst, const slotType *, slotType *>;
+				using reference = std::conditional_t<IsConst, const slotType &, slotType &>;
+
+				IteratorBase() = default;
+
+				operator IteratorBase<true>() const
+				{
+					return {_table, _index};
+				}
+
+				[[nodiscard]] reference operator * () const
+				{
+					ASSUME(_index < _table->_capacity && _table->_control[_index] >= 0);
+					return _table->_slots[_index];
+				}
+
+				[[nodiscard]] pointer operator -> () const
+				{
+					return &operator * ();
+				}
+
+				IteratorBase &operator ++ ()
+				{
+					++_index;
+					SkipNonFull();
+					return *this;
+				}
+
+				IteratorBase operator ++ (int)
+				{
+					IteratorBase copy = *this;
+					operator ++ ();
+					return copy;
+				}
+
+				[[nodiscard]] bool operator == (const IteratorBase &other) const
+				{
+					return _index == other._index;
+				}
+
+				[[nodiscard]] bool operator != (const IteratorBase &other) const
+				{
+					return _index != other._index;
+				}
+			};
+
+		public:
+			using iterator = IteratorBase<false>;
+			using const_iterator = IteratorBase<true>;
+
+			~FlatHashTable()
+			{
+				Destroy();
+			}
+
+			FlatHashTable() = default;
+
+			FlatHashTable(const FlatHashTable &source)
+			{
+				Reserve(source._size);
+				for (const slotType &slot : source)
+				{
+					InsertUnique(Traits::KeyOf(slot), slot);
+				}
+			}
+
+			FlatHashTable(FlatHashTable &&source) noexcept : _control(source._control), _slots(source._slots), _capacity(source._capacity), _size(source._size), _growthLeft(source._growthLeft)
+			{
+				source._control = nullptr;
+				source._slots = nullptr;
+				source._capacity = 0;
+				source._size = 0;
+				source._growthLeft = 0;
+			}
+
+			FlatHashTable &operator = (const FlatHashTable &source)
+			{
+				if (this != &source)
+				{
+					FlatHashTable copy = source;
+					*this = std::move(copy);
+				}
+				return *this;
+			}
+
+			FlatHashTable &operator = (FlatHashTable &&source) noexcept
+			{
+				ASSUME(this != &source);
+				Destroy();
+				_control = source._control;
+				_slots = source._slots;
+				_capacity = source._capacity;
+				_size = source._size;
+				_growthLeft = source._growthLeft;
+				source._control = nullptr;
+				source._slots = nullptr;
+				source._capacity = 0;
+				source._size = 0;
+				source._growthLeft = 0;
+				return *this;
+			}
+
+			[[nodiscard]] iterator begin()
+			{
+				return {this, 0};
+			}
+
+			[[nodiscard]] const_iterator begin() const
+			{
+				return {this, 0};
+			}
+
+			[[nodiscard]] iterator end()
+			{
+				return {this, _capacity};
+			}
+
+			[[nodiscard]] const_iterator end() const
+			{
+				return {this, _capacity};
+			}
+
+			[[nodiscard]] uiw Size() const
+			{
+				return _size;
+			}
+
+			[[nodiscard]] bool IsEmpty() const
+			{
+				return _size == 0;
+			}
+
+			[[nodiscard]] uiw Capacity() const
+			{
+				return _capacity;
+			}
+
+			// makes sure that count elements can be stored without rehashing
+			void Reserve(uiw count)
+			{
+				if (count > _size + _growthLeft)
+				{
+					Rehash(CapacityForCount(count));
+				}
+			}
+
+			void Clear()
+			{
+				if (_capacity)
+				{
+					DestroySlots();
+					MemOps::Set(reinterpret_cast<ui8 *>(_control), static_cast<ui8>(FlatHashControl::Empty), _capacity);
+					_size = 0;
+					_growthLeft = MaxLoad(_capacity);
+				}
+			}
+
+			[[nodiscard]] iterator Find(const keyType &key)
+			{
+				return {this, FindIndex(key, HashPolicyType::Hash(key))};
+			}
+
+			[[nodiscard]] const_iterator Find(const keyType &key) const
+			{
+				return {this, FindIndex(key, HashPolicyType::Hash(key))};
+			}
+
+			[[nodiscard]] bool Contains(const keyType &key) const
+			{
+				return FindIndex(key, HashPolicyType::Hash(key)) != _capacity;
+			}
+
+			// if the key is already present, nothing is constructed and false is returned
+			template <typename... Args> std::pair<iterator, bool> Emplace(const keyType &key, Args &&... args)
+			{
+				ui64 hash = HashPolicyType::Hash(key);
+				uiw index = FindIndex(key, hash);
+				if (index != _capacity)
+				{
+					return {iterator(this, index), false};
+				}
+				index = PrepareInsert(hash);
+				new (&_slots[index]) slotType(std::forward<Args>(args)...);
+				return {iterator(this, index), true};
+			}
+
+			bool Erase(const keyType &key)
+			{
+				uiw index = FindIndex(key, HashPolicyType::Hash(key));
+				if (index == _capacity)
+				{
+					return false;
+				}
+				EraseAt(index);
+				return true;
+			}
+
+			// returns the iterator following the erased element
+			iterator Erase(const_iterator it)
+			{
+				ASSUME(it._table == this && it._index < _capacity && _control[it._index] >= 0);
+				EraseAt(it._index);
+				return {this, it._index + 1};
+			}
+
+		private:
+			[[nodiscard]] static uiw MaxLoad(uiw capacity)
+			{
+				return capacity - capacity / 8;
+			}
+
+			[[nodiscard]] static uiw CapacityForCount(uiw count)
+			{
+				uiw capacity = GroupSize;
+				while (MaxLoad(capacity) < count)
+				{
+					capacity *= 2;
+				}
+				return capacity;
+			}
+
+			[[nodiscard]] static i8 ControlHash(ui64 hash)
+			{
+				return static_cast<i8>(hash & 0x7F);
+			}
+
+			// the first group to probe, the lowest 7 bits are used for the control bytes
+			[[nodiscard]] uiw FirstGroup(ui64 hash) const
+			{
+				return static_cast<uiw>(hash >> 7) & (_capacity / GroupSize - 1);
+			}
+
+			[[nodiscard]] uiw FindIndex(const keyType &key, ui64 hash) const
+			{
+				if (_capacity == 0)
+				{
+					return 0;
+				}
+
+				i8 controlHash = ControlHash(hash);
+				uiw groupMask = _capacity / GroupSize - 1;
+				uiw groupIndex = FirstGroup(hash);
+				// triangular numbers visit every group when the count of groups is a power of two
+				for (uiw probe = 1; ; ++probe)
+				{
+					FlatHashGroup group(_control + groupIndex * GroupSize);
+					for (auto match = group.Match(controlHash); match; match.RemoveLowest())
+					{
+						uiw index = groupIndex * GroupSize + match.Lowest();
+						if (KeyEqual()(Traits::KeyOf(_slots[index]), key))
+						{
+							return index;
+						}
+					}
+					if (group.MatchEmpty())
+					{
+						return _capacity;
+					}
+					ASSUME(probe <= groupMask + 1);
+					groupIndex = (groupIndex + probe) & groupMask;
+				}
+			}
+
+			// returns the first empty or deleted slot in the probe sequence
+			[[nodiscard]] uiw FindInsertIndex(ui64 hash) const
+			{
+				uiw groupMask = _capacity / GroupSize - 1;
+				uiw groupIndex = FirstGroup(hash);
+				for (uiw probe = 1; ; ++probe)
+				{
+					FlatHashGroup group(_control + groupIndex * GroupSize);
+					if (auto match = group.MatchEmptyOrDeleted(); match)
+					{
+						return groupIndex * GroupSize + match.Lowest();
+					}
+					ASSUME(probe <= groupMask + 1);
+					groupIndex = (groupIndex + probe) & groupMask;
+				}
+			}
+
+			// the slot must be constructed by the caller
+			[[nodiscard]] uiw PrepareInsert(ui64 hash)
+			{
+				if (_growthLeft == 0)
+				{
+					// if the table is mostly tombstones, rehashing with the same capacity is enough
+					Rehash(_size * 2 <= MaxLoad(_capacity) ? std::max(_capacity, GroupSize) : CapacityForCount(_size + 1));
+				}
+				uiw index = FindInsertIndex(hash);
+				if (_control[index] == static_cast<i8>(FlatHashControl::Empty))
+				{
+					--_growthLeft;
+				}
+				_control[index] = ControlHash(hash);
+				++_size;
+				return index;
+			}
+
+			template <typename SlotSource> void InsertUnique(const keyType &key, SlotSource &&slot)
+			{
+				uiw index = PrepareInsert(HashPolicyType::Hash(key));
+				new (&_slots[index]) slotType(std::forward<SlotSource>(slot));
+			}
+
+			void EraseAt(uiw index)
+			{
+				_slots[index].~slotType();
+				--_size;
+				// groups are probed as a whole, so if this group has an empty slot, no probe sequence goes past it
+				if (FlatHashGroup(_control + index / GroupSize * GroupSize).MatchEmpty())
+				{
+					_control[index] = static_cast<i8>(FlatHashControl::Empty);
+					++_growthLeft;
+				}
+				else
+				{
+					_control[index] = static_cast<i8>(FlatHashControl::Deleted);
+				}
+			}
+
+			void Rehash(uiw newCapacity)
+			{
+				ASSUME(newCapacity >= GroupSize && Funcs::IsPowerOf2(newCapacity) && MaxLoad(newCapacity) >= _size);
+
+				i8 *oldControl = _control;
+				slotType *oldSlots = _slots;
+				uiw oldCapacity = _capacity;
+
+				// a single allocation, control bytes followed by the slots
+				uiw controlSize = Funcs::AlignAs(newCapacity, alignof(slotType));
+				std::byte *memory = AllocatorType::template Allocate<std::byte>(controlSize + newCapacity * sizeof(slotType));
+				_control = reinterpret_cast<i8 *>(memory);
+				_slots = reinterpret_cast<slotType *>(memory + controlSize);
+				_capacity = newCapacity;
+				_growthLeft = MaxLoad(newCapacity) - _size;
+				MemOps::Set(reinterpret_cast<ui8 *>(_control), static_cast<ui8>(FlatHashControl::Empty), newCapacity);
+
+				for (uiw index = 0; index < oldCapacity; ++index)
+				{
+					if (oldControl[index] >= 0)
+					{
+						slotType &slot = oldSlots[index];
+						ui64 hash = HashPolicyType::Hash(Traits::KeyOf(slot));
+						uiw target = FindInsertIndex(hash);
+						_control[target] = ControlHash(hash);
+						new (&_slots[target]) slotType(std::move(slot));
+						slot.~slotType();
+					}
+				}
+
+				AllocatorType::Free(reinterpret_cast<std::byte *>(oldControl));
+			}
+
+			void DestroySlots()
+			{
+				if constexpr (!std::is_trivially_destructible_v<slotType>)
+				{
+					for (uiw index = 0; index < _capacity; ++index)
+					{
+						if (_control[index] >= 0)
+						{
+							_slots[index].~slotType();
+						}
+					}
+				}
+			}
+
+			void Destroy()
+			{
+				if (_capacity)
+				{
+					DestroySlots();
+					AllocatorType::Free(reinterpret_cast<std::byte *>(_control));
+					_control = nullptr;
+					_slots = nullptr;
+					_capacity = 0;
+					_size = 0;
+					_growthLeft = 0;
+				}
+			}
+		};
+
+		template <typename Key, typename Value> struct FlatHashMapTraits
+		{
+			using KeyType = Key;
+			using SlotType = std::pair<Key, Value>;
+
+			[[nodiscard]] static const Key &KeyOf(const SlotType &slot)
+			{
+				return slot.first;
+			}
+		};
+
+		template <typename Key> struct FlatHashSetTraits
+		{
+			using KeyType = Key;
+			using SlotType = Key;
+
+			[[nodiscard]] static const Key &KeyOf(const SlotType &slot)
+			{
+				return slot;
+			}
+		};
+	}
+
+	// elements are stored as std::pair<Key, Value>, the key must not be modified through iterators
+	// iterators and references are invalidated by any insertion that causes a rehash, erasure doesn't invalidate anything but the erased element
+	template <typename Key, typename Value, typename HashPolicyType = HashPolicy::Integer, typename AllocatorType = Allocator::Malloc, typename KeyEqual = std::equal_to<Key>> class FlatHashMap : public _Private::FlatHashTable<_Private::FlatHashMapTraits<Key, Value>, HashPolicyType, AllocatorType, KeyEqual>
+	{
+		using baseType = _Private::FlatHashTable<_Private::FlatHashMapTraits<Key, Value>, HashPolicyType, AllocatorType, KeyEqual>;
+
+	public:
+		using typename baseType::iterator;
+
+		// doesn't overwrite the value if the key is already present
+		std::pair<iterator, bool> Insert(const Key &key, const Value &value)
+		{
+			return baseType::Emplace(key, key, value);
+		}
+
+		std::pair<iterator, bool> Insert(const Key &key, Value &&value)
+		{
+			return baseType::Emplace(key, key, std::move(value));
+		}
+
+		template <typename... Args> std::pair<iterator, bool> TryEmplace(const Key &key, Args &&... args)
+		{
+			return baseType::Emplace(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		// default constructs the value if the key isn't present
+		Value &operator [] (const Key &key)
+		{
+			return TryEmplace(key).first->second;
+		}
+	};
+
+	template <typename Key, typename HashPolicyType = HashPolicy::Integer, typename AllocatorType = Allocator::Malloc, typename KeyEqual = std::equal_to<Key>> class FlatHashSet : public _Private::FlatHashTable<_Private::FlatHashSetTraits<Key>, HashPolicyType, AllocatorType, KeyEqual>
+	{
+		using baseType = _Private::FlatHashTable<_Private::FlatHashSetTraits<Key>, HashPolicyType, AllocatorType, KeyEqual>;
+
+	public:
+		using typename baseType::iterator;
+
+		std::pair<iterator, bool> Insert(const Key &key)
+		{
+			return baseType::Emplace(key, key);
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "_PreHeader.hpp"
+#include "Futex.hpp"
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID)
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#define FUTEX_SYSCALL_AVAILABLE
+#elif defined(PLATFORM_WINDOWS) && !defined(PLATFORM_WINXP)
+	#define WAIT_ON_ADDRESS_AVAILABLE // Windows 8 and newer, requires Synchronization.lib
+#endif
+#include <thread>
+
+using namespace StdLib;
+
+#ifdef FUTEX_SYSCALL_AVAILABLE
+
+static_assert(sizeof(std::atomic<ui32>) == sizeof(ui32), "futex requires std::atomic<ui32> to have the same layout as ui32");
+
+static long FutexCall(const std::atomic<ui32> &value, int operation, ui32 argument, const timespec *timeout = nullptr)
+{
+	return syscall(SYS_futex, reinterpret_cast<const ui32 *>(&value), operation, argument, timeout, nullptr, 0);
+}
+
+void Futex::Wait(const std::atomic<ui32> &value, ui32 expected)
+{
+	FutexCall(value, FUTEX_WAIT_PRIVATE, expected); // EAGAIN and EINTR are treated as spurious wake ups
+}
+
+void Futex::WaitFor(const std::atomic<ui32> &value, ui32 expected, ui64 timeoutUSec)
+{
+	timespec timeout;
+	timeout.tv_sec = static_cast<time_t>(timeoutUSec / 1'000'000);
+	timeout.tv_nsec = static_cast<long>(timeoutUSec % 1'000'000) * 1000;
+	FutexCall(value, FUTEX_WAIT_PRIVATE, expected, &timeout); // the timeout is relative for FUTEX_WAIT, ETIMEDOUT is treated as a spurious wake up
+}
+
+void Futex::WakeOne(std::atomic<ui32> &value)
+{
+	FutexCall(value, FUTEX_WAKE_PRIVATE, 1);
+}
+
+void Futex::WakeAll(std::atomic<ui32> &value)
+{
+	FutexCall(value, FUTEX_WAKE_PRIVATE, i32_max);
+}
+
+#elif defined(WAIT_ON_ADDRESS_AVAILABLE)
+
+static_assert(sizeof(std::atomic<ui32>) == sizeof(ui32), "WaitOnAddress requires std::atomic<ui32> to have the same layout as ui32");
+
+void Futex::Wait(const std::atomic<ui32> &value, ui32 expected)
+{
+	WaitOnAddress(const_cast<std::atomic<ui32> *>(&value), &expected, sizeof(ui32), INFINITE);
+}
+
+void Futex::WaitFor(const std::atomic<ui32> &value, ui32 expected, ui64 timeoutUSec)
+{
+	// the timeout is rounded up to milliseconds so the wait doesn't end early, INFINITE must not be passed by accident
+	DWORD timeoutMSec = static_cast<DWORD>(std::min<ui64>((timeoutUSec + 999) / 1000, INFINITE - 1));
+	WaitOnAddress(const_cast<std::atomic<ui32> *>(&value), &expected, sizeof(ui32), timeoutMSec); // a timeout is treated as a spurious wake up
+}
+
+void Futex::WakeOne(std::atomic<ui32> &value)
+{
+	WakeByAddressSingle(&value);
+}
+
+void Futex::WakeAll(std::atomic<ui32> &value)
+{
+	WakeByAddressAll(&value);
+}
+
+#elif defined(__cpp_lib_atomic_wait)
+
+void Futex::Wait(const std::atomic<ui32> &value, ui32 expected)
+{
+	value.wait(expected, std::memory_order_relaxed);
+}
+
+void Futex::WaitFor(const std::atomic<ui32> &value, ui32 expected, [[maybe_unused]] ui64 timeoutUSec)
+{
+	if (value.load(std::memory_order_relaxed) == expected)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void Futex::WakeOne(std::atomic<ui32> &value)
+{
+	value.notify_one();
+}
+
+void Futex::WakeAll(std::atomic<ui32> &value)
+{
+	value.notify_all();
+}
+
+#else
+
+void Futex::Wait(const std::atomic<ui32> &value, ui32 expected)
+{
+	if (value.load(std::memory_order_relaxed) == expected)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void Futex::WaitFor(const std::atomic<ui32> &value, ui32 expected, [[maybe_unused]] ui64 timeoutUSec)
+{
+	Wait(value, expected);
+}
+
+void Futex::WakeOne([[maybe_unused]] std::atomic<ui32> &value)
+{}
+
+void Futex::WakeAll([[maybe_unused]] std::atomic<ui32> &value)
+{}
+
+#endif
\ No newline at end of file
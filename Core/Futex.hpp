@@ -0,0 +1,13 @@
+#pragma once
+
+namespace StdLib::Futex
+{
+	// blocks the calling thread while the value is equal to expected, can return spuriously, so the value must be re-checked
+	// Linux and Android use the futex syscall, Windows uses WaitOnAddress, other platforms use std::atomic::wait or fall back to yielding if it isn't available
+	void Wait(const std::atomic<ui32> &value, ui32 expected);
+	// same as Wait, but also returns after the timeout, std::atomic::wait has no timeout, so it yields once instead on the platforms
+	// that have neither the futex syscall nor WaitOnAddress, the timed waits in the Blocking modes spin there
+	void WaitFor(const std::atomic<ui32> &value, ui32 expected, ui64 timeoutUSec);
+	void WakeOne(std::atomic<ui32> &value);
+	void WakeAll(std::atomic<ui32> &value);
+}
\ No newline at end of file
@@ -3,60 +3,371 @@
 
 using namespace StdLib;
 
-// Reverses (reflects) bits in a 32-bit word.
-static inline ui32 reverse(ui32 x) 
+// slicing-by-8 tables for the reflected 0x04C11DB7 polynomial, the first table is the classic byte-wise one
+static constexpr std::array<std::array<ui32, 256>, 8> CRC32Tables = []
 {
-	x = ((x & 0x55555555) << 1) | ((x >> 1) & 0x55555555);
-	x = ((x & 0x33333333) << 2) | ((x >> 2) & 0x33333333);
-	x = ((x & 0x0F0F0F0F) << 4) | ((x >> 4) & 0x0F0F0F0F);
-	x = (x << 24) | ((x & 0xFF00) << 8) | ((x >> 8) & 0xFF00) | (x >> 24);
-	return x;
+	std::array<std::array<ui32, 256>, 8> tables{};
+	for (ui32 index = 0; index < 256; ++index)
+	{
+		ui32 crc = index;
+		for (uiw bit = 0; bit < 8; ++bit)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+		}
+		tables[0][index] = crc;
+	}
+	for (ui32 index = 0; index < 256; ++index)
+	{
+		for (uiw slice = 1; slice < 8; ++slice)
+		{
+			ui32 previous = tables[slice - 1][index];
+			tables[slice][index] = (previous >> 8) ^ tables[0][previous & 0xFF];
+		}
+	}
+	return tables;
+} ();
+
+void Hash::CRC32Hasher::Update(const void *source, uiw length)
+{
+	const ui8 *p = static_cast<const ui8 *>(source);
+	ui32 crc = _crc;
+
+	for (; length >= 8; p += 8, length -= 8)
+	{
+		ui32 low = crc ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<ui32>(p[3]) << 24));
+		ui32 high = p[4] | (p[5] << 8) | (p[6] << 16) | (static_cast<ui32>(p[7]) << 24);
+		crc = CRC32Tables[7][low & 0xFF] ^ CRC32Tables[6][(low >> 8) & 0xFF] ^ CRC32Tables[5][(low >> 16) & 0xFF] ^ CRC32Tables[4][low >> 24] ^
+			CRC32Tables[3][high & 0xFF] ^ CRC32Tables[2][(high >> 8) & 0xFF] ^ CRC32Tables[1][(high >> 16) & 0xFF] ^ CRC32Tables[0][high >> 24];
+	}
+
+	for (uiw index = 0; index < length; ++index)
+	{
+		crc = (crc >> 8) ^ CRC32Tables[0][(crc ^ p[index]) & 0xFF];
+	}
+
+	_crc = crc;
 }
 
-// based on https://www.hackersdelight.org/hdcodetxt/crc.c.txt
-// the most basic implementation
 ui32 Hash::CRC32(const ui8 *message)
 {
-	i32 crc = 0xFFFFFFFF;
-	for (uiw i = 0; message[i]; ++i)
+	return CRC32(message, strlen(reinterpret_cast<const char *>(message)));
+}
+
+ui32 Hash::CRC32(const ui8 *message, uiw length)
+{
+	CRC32Hasher hasher;
+	hasher.Update(message, length);
+	return hasher.Finish();
+}
+
+// based on zlib's crc32_combine, appending secondLength zero bytes to the first message
+// is a linear operation in GF(2), it is applied by squaring the one zero bit operator matrix
+static ui32 GF2MatrixTimes(const ui32 *matrix, ui32 vector)
+{
+	ui32 sum = 0;
+	for (; vector; vector >>= 1, ++matrix)
 	{
-		ui32 byte = message[i];
-		byte = reverse(byte);
-		for (uiw j = 0; j <= 7; j++) 
+		if (vector & 1)
 		{
-			if (static_cast<i32>(crc ^ byte) < 0)
-			{
-				crc = (crc << 1) ^ 0x04C11DB7;
-			}
-			else
-			{
-				crc = crc << 1;
-			}
-			byte = byte << 1;
+			sum ^= *matrix;
 		}
 	}
-	return reverse(static_cast<ui32>(~crc));
+	return sum;
 }
 
-ui32 Hash::CRC32(const ui8 *message, uiw length)
+static void GF2MatrixSquare(ui32 *RSTR square, const ui32 *RSTR matrix)
+{
+	for (uiw index = 0; index < 32; ++index)
+	{
+		square[index] = GF2MatrixTimes(matrix, matrix[index]);
+	}
+}
+
+ui32 Hash::CRC32Combine(ui32 crcFirst, ui32 crcSecond, ui64 secondLength)
+{
+	if (secondLength == 0)
+	{
+		return crcFirst;
+	}
+
+	ui32 even[32]; // even powers of two zeros operator
+	ui32 odd[32]; // odd powers of two zeros operator
+
+	odd[0] = 0xEDB88320u; // the operator for one zero bit
+	for (uiw index = 1; index < 32; ++index)
+	{
+		odd[index] = 1u << (index - 1);
+	}
+
+	GF2MatrixSquare(even, odd); // two zero bits
+	GF2MatrixSquare(odd, even); // four zero bits
+
+	// the first squaring produces the operator for one zero byte
+	for (;;)
+	{
+		GF2MatrixSquare(even, odd);
+		if (secondLength & 1)
+		{
+			crcFirst = GF2MatrixTimes(even, crcFirst);
+		}
+		secondLength >>= 1;
+		if (secondLength == 0)
+		{
+			break;
+		}
+
+		GF2MatrixSquare(odd, even);
+		if (secondLength & 1)
+		{
+			crcFirst = GF2MatrixTimes(odd, crcFirst);
+		}
+		secondLength >>= 1;
+		if (secondLength == 0)
+		{
+			break;
+		}
+	}
+
+	return crcFirst ^ crcSecond;
+}
+
+#if defined(SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(SIMD_SSE2)
+	#include <emmintrin.h>
+#elif defined(SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+// must produce the same results as the scalar path of Hash::_FastHashAccumulate
+// acc[lane ^ 1] += data[lane], acc[lane] += lo32(data[lane] ^ key[lane]) * hi32(data[lane] ^ key[lane])
+void Hash::_FastHashAccumulateBulk(ui64 *RSTR accumulators, const ui8 *RSTR stripes, uiw stripesCount, uiw keyIndex)
 {
-	i32 crc = 0xFFFFFFFF;
-	for (uiw i = 0; i < length; ++i)
+#if defined(SIMD_AVX2)
+	__m256i acc[2];
+	for (uiw index = 0; index < 2; ++index)
+	{
+		acc[index] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(accumulators + index * 4));
+	}
+	for (uiw stripe = 0; stripe < stripesCount; ++stripe)
+	{
+		const ui8 *p = stripes + stripe * _FastHashStripeLength;
+		for (uiw index = 0; index < 2; ++index)
+		{
+			__m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + index * 32));
+			__m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_FastHashKeys.data() + keyIndex + stripe + index * 4));
+			__m256i dataKey = _mm256_xor_si256(data, key);
+			__m256i product = _mm256_mul_epu32(dataKey, _mm256_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+			__m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			acc[index] = _mm256_add_epi64(acc[index], _mm256_add_epi64(product, swapped));
+		}
+	}
+	for (uiw index = 0; index < 2; ++index)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(accumulators + index * 4), acc[index]);
+	}
+#elif defined(SIMD_SSE2)
+	__m128i acc[4];
+	for (uiw index = 0; index < 4; ++index)
+	{
+		acc[index] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(accumulators + index * 2));
+	}
+	for (uiw stripe = 0; stripe < stripesCount; ++stripe)
 	{
-		ui32 byte = message[i];
-		byte = reverse(byte);
-		for (uiw j = 0; j <= 7; j++)
+		const ui8 *p = stripes + stripe * _FastHashStripeLength;
+		for (uiw index = 0; index < 4; ++index)
 		{
-			if (static_cast<i32>(crc ^ byte) < 0)
-			{
-				crc = (crc << 1) ^ 0x04C11DB7;
-			}
-			else
-			{
-				crc = crc << 1;
-			}
-			byte = byte << 1;
+			__m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + index * 16));
+			__m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_FastHashKeys.data() + keyIndex + stripe + index * 2));
+			__m128i dataKey = _mm_xor_si128(data, key);
+			__m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+			__m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			acc[index] = _mm_add_epi64(acc[index], _mm_add_epi64(product, swapped));
 		}
 	}
-	return reverse(static_cast<ui32>(~crc));
+	for (uiw index = 0; index < 4; ++index)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(accumulators + index * 2), acc[index]);
+	}
+#elif defined(SIMD_NEON)
+	uint64x2_t acc[4];
+	for (uiw index = 0; index < 4; ++index)
+	{
+		acc[index] = vld1q_u64(accumulators + index * 2);
+	}
+	for (uiw stripe = 0; stripe < stripesCount; ++stripe)
+	{
+		const ui8 *p = stripes + stripe * _FastHashStripeLength;
+		for (uiw index = 0; index < 4; ++index)
+		{
+			uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(p + index * 16));
+			uint64x2_t key = vld1q_u64(_FastHashKeys.data() + keyIndex + stripe + index * 2);
+			uint64x2_t dataKey = veorq_u64(data, key);
+			uint64x2_t product = vmull_u32(vmovn_u64(dataKey), vshrn_n_u64(dataKey, 32));
+			uint64x2_t swapped = vextq_u64(data, data, 1);
+			acc[index] = vaddq_u64(acc[index], vaddq_u64(product, swapped));
+		}
+	}
+	for (uiw index = 0; index < 4; ++index)
+	{
+		vst1q_u64(accumulators + index * 2, acc[index]);
+	}
+#else
+	_FastHashAccumulate<false>(accumulators, stripes, stripesCount, keyIndex);
+#endif
+}
+
+namespace
+{
+	// the operations required by the integer hashes, Multiply64 keeps only the low 64 bits of the product
+#if defined(SIMD_AVX2)
+	struct IntegerLanes
+	{
+		using type = __m256i;
+		static constexpr uiw size = sizeof(type);
+
+		static type Load(const ui8 *source) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source)); }
+		static void Store(ui8 *target, type value) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(target), value); }
+		static type Xor(type left, type right) { return _mm256_xor_si256(left, right); }
+		template <int shift> static type ShiftRight32(type value) { return _mm256_srli_epi32(value, shift); }
+		template <int shift> static type ShiftRight64(type value) { return _mm256_srli_epi64(value, shift); }
+
+		static type Multiply32(type value, ui32 multiplier)
+		{
+			return _mm256_mullo_epi32(value, _mm256_set1_epi32(static_cast<i32>(multiplier)));
+		}
+
+		static type Multiply64(type value, ui64 multiplier)
+		{
+			__m256i low = _mm256_set1_epi64x(static_cast<i64>(multiplier & 0xFFFFFFFF));
+			__m256i high = _mm256_set1_epi64x(static_cast<i64>(multiplier >> 32));
+			__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(value, 32), low), _mm256_mul_epu32(value, high));
+			return _mm256_add_epi64(_mm256_mul_epu32(value, low), _mm256_slli_epi64(cross, 32));
+		}
+	};
+#elif defined(SIMD_SSE2)
+	struct IntegerLanes
+	{
+		using type = __m128i;
+		static constexpr uiw size = sizeof(type);
+
+		static type Load(const ui8 *source) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(source)); }
+		static void Store(ui8 *target, type value) { _mm_storeu_si128(reinterpret_cast<__m128i *>(target), value); }
+		static type Xor(type left, type right) { return _mm_xor_si128(left, right); }
+		template <int shift> static type ShiftRight32(type value) { return _mm_srli_epi32(value, shift); }
+		template <int shift> static type ShiftRight64(type value) { return _mm_srli_epi64(value, shift); }
+
+		// SSE2 doesn't have 32 bit multiplication, so even and odd lanes are multiplied separately
+		static type Multiply32(type value, ui32 multiplier)
+		{
+			__m128i broadcasted = _mm_set1_epi32(static_cast<i32>(multiplier));
+			__m128i even = _mm_mul_epu32(value, broadcasted);
+			__m128i odd = _mm_mul_epu32(_mm_srli_epi64(value, 32), broadcasted);
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+
+		static type Multiply64(type value, ui64 multiplier)
+		{
+			__m128i low = _mm_set1_epi64x(static_cast<i64>(multiplier & 0xFFFFFFFF));
+			__m128i high = _mm_set1_epi64x(static_cast<i64>(multiplier >> 32));
+			__m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(value, 32), low), _mm_mul_epu32(value, high));
+			return _mm_add_epi64(_mm_mul_epu32(value, low), _mm_slli_epi64(cross, 32));
+		}
+	};
+#elif defined(SIMD_NEON)
+	struct IntegerLanes
+	{
+		using type = uint64x2_t;
+		static constexpr uiw size = sizeof(type);
+
+		static type Load(const ui8 *source) { return vreinterpretq_u64_u8(vld1q_u8(source)); }
+		static void Store(ui8 *target, type value) { vst1q_u8(target, vreinterpretq_u8_u64(value)); }
+		static type Xor(type left, type right) { return veorq_u64(left, right); }
+		template <int shift> static type ShiftRight32(type value) { return vreinterpretq_u64_u32(vshrq_n_u32(vreinterpretq_u32_u64(value), shift)); }
+		template <int shift> static type ShiftRight64(type value) { return vshrq_n_u64(value, shift); }
+
+		static type Multiply32(type value, ui32 multiplier)
+		{
+			return vreinterpretq_u64_u32(vmulq_n_u32(vreinterpretq_u32_u64(value), multiplier));
+		}
+
+		static type Multiply64(type value, ui64 multiplier)
+		{
+			ui32 low = static_cast<ui32>(multiplier), high = static_cast<ui32>(multiplier >> 32);
+			uint32x2_t valueLow = vmovn_u64(value), valueHigh = vshrn_n_u64(value, 32);
+			uint32x2_t cross = vadd_u32(vmul_n_u32(valueHigh, low), vmul_n_u32(valueLow, high));
+			return vaddq_u64(vmull_n_u32(valueLow, low), vshlq_n_u64(vmovl_u32(cross), 32));
+		}
+	};
+#endif
+
+	template <typename T, typename VectorFunc, typename ScalarFunc> void ProcessIntegerBatch(const void *source, void *target, uiw count, VectorFunc &&vectorFunc, ScalarFunc &&scalarFunc)
+	{
+		const ui8 *p = static_cast<const ui8 *>(source);
+		ui8 *t = static_cast<ui8 *>(target);
+		uiw index = 0;
+
+	#if defined(SIMD_AVX2) || defined(SIMD_SSE2) || defined(SIMD_NEON)
+		constexpr uiw perVector = IntegerLanes::size / sizeof(T);
+		for (; index + perVector <= count; index += perVector)
+		{
+			IntegerLanes::Store(t + index * sizeof(T), vectorFunc(IntegerLanes::Load(p + index * sizeof(T)), IntegerLanes{}));
+		}
+	#endif
+
+		for (; index < count; ++index)
+		{
+			T value;
+			MemOps::Copy(reinterpret_cast<ui8 *>(&value), p + index * sizeof(T), sizeof(T));
+			value = scalarFunc(value);
+			MemOps::Copy(t + index * sizeof(T), reinterpret_cast<const ui8 *>(&value), sizeof(T));
+		}
+	}
+}
+
+// every step has to mirror Hash::Integer and Hash::IntegerInverse exactly, the vector lambdas
+// receive the lanes type as an argument so they aren't instantiated if there's no SIMD support
+
+void Hash::_IntegerBatch32(const void *source, void *target, uiw count)
+{
+	ProcessIntegerBatch<ui32>(source, target, count, [](auto x, auto lanes)
+	{
+		using l = decltype(lanes);
+		x = l::Multiply32(l::Xor(l::template ShiftRight32<16>(x), x), 0x45d9f3b);
+		x = l::Multiply32(l::Xor(l::template ShiftRight32<16>(x), x), 0x45d9f3b);
+		return l::Xor(l::template ShiftRight32<16>(x), x);
+	}, [](ui32 x) { return Integer<Precision::P32>(x); });
+}
+
+void Hash::_IntegerBatch64(const void *source, void *target, uiw count)
+{
+	ProcessIntegerBatch<ui64>(source, target, count, [](auto x, auto lanes)
+	{
+		using l = decltype(lanes);
+		x = l::Multiply64(l::Xor(x, l::template ShiftRight64<30>(x)), 0xbf58476d1ce4e5b9ULL);
+		x = l::Multiply64(l::Xor(x, l::template ShiftRight64<27>(x)), 0x94d049bb133111ebULL);
+		return l::Xor(x, l::template ShiftRight64<31>(x));
+	}, [](ui64 x) { return Integer<Precision::P64>(x); });
+}
+
+void Hash::_IntegerInverseBatch32(const void *source, void *target, uiw count)
+{
+	ProcessIntegerBatch<ui32>(source, target, count, [](auto x, auto lanes)
+	{
+		using l = decltype(lanes);
+		x = l::Multiply32(l::Xor(l::template ShiftRight32<16>(x), x), 0x119de1f3);
+		x = l::Multiply32(l::Xor(l::template ShiftRight32<16>(x), x), 0x119de1f3);
+		return l::Xor(l::template ShiftRight32<16>(x), x);
+	}, [](ui32 x) { return IntegerInverse<Precision::P32>(x); });
+}
+
+void Hash::_IntegerInverseBatch64(const void *source, void *target, uiw count)
+{
+	ProcessIntegerBatch<ui64>(source, target, count, [](auto x, auto lanes)
+	{
+		using l = decltype(lanes);
+		x = l::Multiply64(l::Xor(l::Xor(x, l::template ShiftRight64<31>(x)), l::template ShiftRight64<62>(x)), 0x319642b2d24d8ec3ULL);
+		x = l::Multiply64(l::Xor(l::Xor(x, l::template ShiftRight64<27>(x)), l::template ShiftRight64<54>(x)), 0x96de1b173f119089ULL);
+		return l::Xor(l::Xor(x, l::template ShiftRight64<30>(x)), l::template ShiftRight64<60>(x));
+	}, [](ui64 x) { return IntegerInverse<Precision::P64>(x); });
 }
\ No newline at end of file
@@ -4,10 +4,27 @@
 
 namespace StdLib::Hash
 {
-	enum class Precision { P32, P64 };
+	enum class Precision { P32, P64, P128 };
+
+	struct Hash128
+	{
+		ui64 low{}, high{};
+
+		[[nodiscard]] constexpr bool operator == (const Hash128 &other) const
+		{
+			return low == other.low && high == other.high;
+		}
+
+		[[nodiscard]] constexpr bool operator != (const Hash128 &other) const
+		{
+			return !operator == (other);
+		}
+	};
 
 	template <Precision precision, bool IsLengthDefined> [[nodiscard]] auto _FNVHash(const void *source, uiw length)
 	{
+		static_assert(precision == Precision::P32 || precision == Precision::P64, "FNV hash supports only 32 and 64 bit precision");
+
 		const ui8 *p = static_cast<const ui8 *>(source);
 
 		auto calculate = [p](auto initialConstant, auto multiplier, bool isLengthDefined, uiw length) -> decltype(initialConstant)
@@ -69,6 +86,8 @@ namespace StdLib::Hash
 	// will generate different hashes compared to FNVHash if sizeof(T) is not 1
 	template <Precision precision, typename T, uiw length> [[nodiscard]] constexpr auto FNVHashCT(const T *source)
 	{
+		static_assert(precision == Precision::P32 || precision == Precision::P64, "FNV hash supports only 32 and 64 bit precision");
+
 		const T *p = source;
 		if constexpr (precision == Precision::P32)
 		{
@@ -111,14 +130,488 @@ namespace StdLib::Hash
 		}
 	}
 
+	// FastHash uses wyhash-style 64x64->128 multiply-mixing for inputs up to 240 bytes and
+	// XXH3-style striped accumulation for longer inputs, the accumulation is done with SIMD at runtime
+	// the scalar path is constexpr, both paths generate identical hashes
+	// the hash is defined for the little-endian byte order, big-endian machines will generate the same values
+
+	constexpr uiw _FastHashStripeLength = 64;
+	constexpr uiw _FastHashStripesPerBlock = 16;
+	constexpr uiw _FastHashBlockLength = _FastHashStripeLength * _FastHashStripesPerBlock;
+	constexpr uiw _FastHashShortLengthMax = 240;
+	constexpr uiw _FastHashLastStripeKeyIndex = 24;
+	constexpr uiw _FastHashScrambleKeyIndex = 32;
+	constexpr uiw _FastHashMergeKeyIndex = 40;
+	constexpr uiw _FastHashMergeHighKeyIndex = 48;
+
+	constexpr ui64 _FastHashSeeds[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+	// stripe N uses keys [N, N + 8), the rest are used for the last stripe, scrambling and merging
+	constexpr std::array<ui64, 56> _FastHashKeys = []
+	{
+		std::array<ui64, 56> keys{};
+		ui64 state = 0x9E3779B97F4A7C15ull;
+		for (ui64 &key : keys) // splitmix64
+		{
+			state += 0x9E3779B97F4A7C15ull;
+			ui64 z = state;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			key = z ^ (z >> 31);
+		}
+		return keys;
+	} ();
+
+	[[nodiscard]] constexpr bool _IsConstantEvaluated()
+	{
+	#ifdef __cpp_lib_is_constant_evaluated
+		return std::is_constant_evaluated();
+	#else
+		return true; // the constexpr friendly code will be used everywhere
+	#endif
+	}
+
+	template <typename T> [[nodiscard]] FORCEINLINE constexpr ui64 _FastHashRead(const T *source, uiw bytes)
+	{
+		static_assert(sizeof(T) == 1, "FastHash operates on bytes");
+		if (!_IsConstantEvaluated() && bytes == 8)
+		{
+			// all supported platforms are little-endian, the SIMD path relies on it too
+			ui64 value;
+			MemOps::Copy(reinterpret_cast<std::byte *>(&value), reinterpret_cast<const std::byte *>(source), 8);
+			return value;
+		}
+		ui64 value = 0;
+		for (uiw index = 0; index < bytes; ++index)
+		{
+			value |= static_cast<ui64>(static_cast<ui8>(source[index])) << (index * 8);
+		}
+		return value;
+	}
+
+	// a receives the low part of the product, b receives the high part
+	FORCEINLINE constexpr void _FastHashMultiply(ui64 &a, ui64 &b)
+	{
+	#ifdef __SIZEOF_INT128__
+		unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		a = static_cast<ui64>(product);
+		b = static_cast<ui64>(product >> 64);
+	#else
+		#if defined(_MSC_VER) && defined(_M_X64)
+			if (!_IsConstantEvaluated())
+			{
+				ui64 high;
+				a = _umul128(a, b, &high);
+				b = high;
+				return;
+			}
+		#endif
+		ui64 aHigh = a >> 32, aLow = a & 0xFFFFFFFF;
+		ui64 bHigh = b >> 32, bLow = b & 0xFFFFFFFF;
+		ui64 high = aHigh * bHigh, middle0 = aHigh * bLow, middle1 = bHigh * aLow, low = aLow * bLow;
+		ui64 sum = low + (middle0 << 32);
+		ui64 carry = sum < low;
+		ui64 resultLow = sum + (middle1 << 32);
+		carry += resultLow < sum;
+		a = resultLow;
+		b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+	#endif
+	}
+
+	[[nodiscard]] FORCEINLINE constexpr ui64 _FastHashMix(ui64 a, ui64 b)
+	{
+		_FastHashMultiply(a, b);
+		return a ^ b;
+	}
+
+	[[nodiscard]] constexpr ui64 _FastHashAvalanche(ui64 hash)
+	{
+		hash ^= hash >> 37;
+		hash *= 0x165667919E3779F9ull;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	template <Precision precision> [[nodiscard]] constexpr auto _FastHashFold(ui64 low, ui64 high)
+	{
+		if constexpr (precision == Precision::P32)
+		{
+			return static_cast<ui32>(low ^ (low >> 32));
+		}
+		else if constexpr (precision == Precision::P64)
+		{
+			return low;
+		}
+		else
+		{
+			return Hash128{low, high};
+		}
+	}
+
+	template <Precision precision, typename T> [[nodiscard]] constexpr auto _FastHashShort(const T *source, uiw length)
+	{
+		ASSUME(length <= _FastHashShortLengthMax);
+		const T *p = source;
+		ui64 seed = _FastHashSeeds[0] ^ _FastHashMix(_FastHashSeeds[0], _FastHashSeeds[1]);
+		ui64 a = 0, b = 0;
+		if (length <= 16)
+		{
+			if (length >= 4)
+			{
+				uiw shift = (length >> 3) << 2;
+				a = (_FastHashRead(p, 4) << 32) | _FastHashRead(p + shift, 4);
+				b = (_FastHashRead(p + length - 4, 4) << 32) | _FastHashRead(p + length - 4 - shift, 4);
+			}
+			else if (length > 0)
+			{
+				a = (_FastHashRead(p, 1) << 16) | (_FastHashRead(p + (length >> 1), 1) << 8) | _FastHashRead(p + length - 1, 1);
+			}
+		}
+		else
+		{
+			uiw left = length;
+			if (left > 48)
+			{
+				ui64 seed1 = seed, seed2 = seed;
+				do
+				{
+					seed = _FastHashMix(_FastHashRead(p, 8) ^ _FastHashSeeds[1], _FastHashRead(p + 8, 8) ^ seed);
+					seed1 = _FastHashMix(_FastHashRead(p + 16, 8) ^ _FastHashSeeds[2], _FastHashRead(p + 24, 8) ^ seed1);
+					seed2 = _FastHashMix(_FastHashRead(p + 32, 8) ^ _FastHashSeeds[3], _FastHashRead(p + 40, 8) ^ seed2);
+					p += 48;
+					left -= 48;
+				} while (left > 48);
+				seed ^= seed1 ^ seed2;
+			}
+			while (left > 16)
+			{
+				seed = _FastHashMix(_FastHashRead(p, 8) ^ _FastHashSeeds[1], _FastHashRead(p + 8, 8) ^ seed);
+				p += 16;
+				left -= 16;
+			}
+			a = _FastHashRead(p + left - 16, 8);
+			b = _FastHashRead(p + left - 8, 8);
+		}
+
+		a ^= _FastHashSeeds[1];
+		b ^= seed;
+		_FastHashMultiply(a, b);
+
+		ui64 low = _FastHashMix(a ^ _FastHashSeeds[0] ^ length, b ^ _FastHashSeeds[1]);
+		ui64 high = 0;
+		if constexpr (precision == Precision::P128)
+		{
+			high = _FastHashMix(a ^ _FastHashSeeds[2], b ^ _FastHashSeeds[3] ^ length);
+		}
+		return _FastHashFold<precision>(low, high);
+	}
+
+	// the SIMD version of _FastHashAccumulate, implemented in HashFuncs.cpp
+	void _FastHashAccumulateBulk(ui64 *RSTR accumulators, const ui8 *RSTR stripes, uiw stripesCount, uiw keyIndex);
+
+	template <bool IsBulk, typename T> constexpr void _FastHashAccumulate(ui64 *accumulators, const T *stripes, uiw stripesCount, uiw keyIndex)
+	{
+		if constexpr (IsBulk)
+		{
+			_FastHashAccumulateBulk(accumulators, reinterpret_cast<const ui8 *>(stripes), stripesCount, keyIndex);
+		}
+		else
+		{
+			for (uiw stripe = 0; stripe < stripesCount; ++stripe)
+			{
+				const T *p = stripes + stripe * _FastHashStripeLength;
+				for (uiw lane = 0; lane < 8; ++lane)
+				{
+					ui64 data = _FastHashRead(p + lane * 8, 8);
+					ui64 key = data ^ _FastHashKeys[keyIndex + stripe + lane];
+					accumulators[lane ^ 1] += data;
+					accumulators[lane] += (key & 0xFFFFFFFF) * (key >> 32);
+				}
+			}
+		}
+	}
+
+	constexpr void _FastHashScramble(ui64 *accumulators)
+	{
+		for (uiw lane = 0; lane < 8; ++lane)
+		{
+			ui64 value = accumulators[lane];
+			value ^= value >> 47;
+			value ^= _FastHashKeys[_FastHashScrambleKeyIndex + lane];
+			value *= 0x9E3779B1u;
+			accumulators[lane] = value;
+		}
+	}
+
+	constexpr void _FastHashInitialize(ui64 *accumulators)
+	{
+		constexpr ui64 initial[8] = {0xC2B2AE3Du, 0x9E3779B185EBCA87ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x85EBCA77C2B2AE63ull, 0x85EBCA77u, 0x27D4EB2F165667C5ull, 0x9E3779B1u};
+		for (uiw lane = 0; lane < 8; ++lane)
+		{
+			accumulators[lane] = initial[lane];
+		}
+	}
+
+	template <Precision precision> [[nodiscard]] constexpr auto _FastHashMerge(const ui64 *accumulators, ui64 length)
+	{
+		auto merge = [accumulators](ui64 hash, uiw keyIndex)
+		{
+			for (uiw pair = 0; pair < 4; ++pair)
+			{
+				hash += _FastHashMix(accumulators[pair * 2] ^ _FastHashKeys[keyIndex + pair * 2], accumulators[pair * 2 + 1] ^ _FastHashKeys[keyIndex + pair * 2 + 1]);
+			}
+			return _FastHashAvalanche(hash);
+		};
+
+		ui64 low = merge(length * 0x9E3779B185EBCA87ull, _FastHashMergeKeyIndex);
+		ui64 high = 0;
+		if constexpr (precision == Precision::P128)
+		{
+			high = merge(~(length * 0xC2B2AE3D27D4EB4Full), _FastHashMergeHighKeyIndex);
+		}
+		return _FastHashFold<precision>(low, high);
+	}
+
+	// the last byte always ends up in the last stripe, even if the length is a multiple of the stripe length
+	template <Precision precision, bool IsBulk, typename T> [[nodiscard]] constexpr auto _FastHashLong(const T *source, uiw length)
+	{
+		ASSUME(length > _FastHashShortLengthMax);
+		ui64 accumulators[8]{};
+		_FastHashInitialize(accumulators);
+
+		uiw blocksCount = (length - 1) / _FastHashBlockLength;
+		for (uiw block = 0; block < blocksCount; ++block)
+		{
+			_FastHashAccumulate<IsBulk>(accumulators, source + block * _FastHashBlockLength, _FastHashStripesPerBlock, 0);
+			_FastHashScramble(accumulators);
+		}
+
+		uiw stripesCount = ((length - 1) - blocksCount * _FastHashBlockLength) / _FastHashStripeLength;
+		_FastHashAccumulate<IsBulk>(accumulators, source + blocksCount * _FastHashBlockLength, stripesCount, 0);
+		_FastHashAccumulate<false>(accumulators, source + length - _FastHashStripeLength, 1, _FastHashLastStripeKeyIndex);
+
+		return _FastHashMerge<precision>(accumulators, length);
+	}
+
+	template <Precision precision, bool IsBulk, typename T> [[nodiscard]] constexpr auto _FastHash(const T *source, uiw length)
+	{
+		static_assert(sizeof(T) == 1, "FastHash operates on bytes");
+		if (length <= _FastHashShortLengthMax)
+		{
+			return _FastHashShort<precision>(source, length);
+		}
+		return _FastHashLong<precision, IsBulk>(source, length);
+	}
+
+	template <Precision precision> [[nodiscard]] auto FastHash(const void *source, uiw length)
+	{
+		return _FastHash<precision, true>(static_cast<const ui8 *>(source), length);
+	}
+
+	template <Precision precision> [[nodiscard]] auto FastHash(const char *source)
+	{
+		return FastHash<precision>(source, strlen(source));
+	}
+
+	template <Precision precision> [[nodiscard]] auto FastHash(std::string_view str)
+	{
+		return FastHash<precision>(str.data(), str.length());
+	}
+
+	template <Precision precision> [[nodiscard]] auto FastHash(const std::string &str)
+	{
+		return FastHash<precision>(str.data(), str.length());
+	}
+
+	// T must be a byte-sized type, generates the same hashes as FastHash
+	template <Precision precision, typename T, uiw length> [[nodiscard]] constexpr auto FastHashCT(const T *source)
+	{
+		return _FastHash<precision, false>(source, length);
+	}
+
+	// T must be a byte-sized type, generates the same hashes as FastHash
+	template <Precision precision, typename T, uiw length, bool useReference = true> [[nodiscard]] constexpr auto FastHashCT(const T (&source)[length])
+	{
+		return FastHashCT<precision, T, length>(static_cast<const T *>(source));
+	}
+
+	template <Precision precision, typename T, typename = std::enable_if_t<std::is_pointer_v<T> == false>> [[nodiscard]] auto FastHash(const T &value)
+	{
+		return FastHash<precision>(&value, sizeof(T));
+	}
+
 	[[nodiscard]] ui32 CRC32(const ui8 *message); // zero terminated
 	[[nodiscard]] ui32 CRC32(const ui8 *message, uiw length);
+	[[nodiscard]] ui32 CRC32Combine(ui32 crcFirst, ui32 crcSecond, ui64 secondLength); // returns CRC32 of the concatenation of the first and the second messages
+
+	// incremental versions of the hash functions above, Update can be called any number of times
+	// with arbitrary sized pieces, Finish returns the same value the one-shot function would return
+	// for the concatenation of all the pieces, it doesn't modify the state
+
+	template <Precision precision> class FNVHasher
+	{
+		static_assert(precision == Precision::P32 || precision == Precision::P64, "FNV hash supports only 32 and 64 bit precision");
+
+		std::conditional_t<precision == Precision::P32, ui32, ui64> _hash = precision == Precision::P32 ? 0x811c9dc5u : 0xcbf29ce484222325ull;
+
+	public:
+		void Update(const void *source, uiw length)
+		{
+			const ui8 *p = static_cast<const ui8 *>(source);
+			auto hash = _hash;
+			for (uiw index = 0; index < length; ++index)
+			{
+				hash ^= p[index];
+				if constexpr (precision == Precision::P32)
+				{
+					hash *= 16777619u;
+				}
+				else
+				{
+					hash *= 1099511628211ull;
+				}
+			}
+			_hash = hash;
+		}
+
+		[[nodiscard]] auto Finish() const
+		{
+			return _hash;
+		}
+	};
+
+	class CRC32Hasher
+	{
+		ui32 _crc = 0xFFFFFFFF;
+
+	public:
+		void Update(const void *source, uiw length);
+
+		[[nodiscard]] ui32 Finish() const
+		{
+			return ~_crc;
+		}
+	};
+
+	template <Precision precision> class FastHasher
+	{
+		alignas(8) ui8 _buffer[_FastHashBlockLength];
+		ui8 _previousStripe[_FastHashStripeLength]; // the tail of the last consumed block, required if the final block is shorter than a stripe
+		ui64 _accumulators[8];
+		uiw _buffered = 0;
+		ui64 _totalLength = 0;
+
+		void ConsumeBlock(const ui8 *block)
+		{
+			_FastHashAccumulate<true>(_accumulators, block, _FastHashStripesPerBlock, 0);
+			_FastHashScramble(_accumulators);
+			MemOps::Copy(_previousStripe, block + _FastHashBlockLength - _FastHashStripeLength, _FastHashStripeLength);
+		}
+
+	public:
+		FastHasher()
+		{
+			_FastHashInitialize(_accumulators);
+		}
+
+		void Update(const void *source, uiw length)
+		{
+			const ui8 *p = static_cast<const ui8 *>(source);
+			_totalLength += length;
+
+			// a full block is consumed only when more data follows it, because the final block is processed differently
+			if (_buffered + length <= _FastHashBlockLength)
+			{
+				MemOps::Copy(_buffer + _buffered, p, length);
+				_buffered += length;
+				return;
+			}
+
+			if (_buffered)
+			{
+				uiw toCopy = _FastHashBlockLength - _buffered;
+				MemOps::Copy(_buffer + _buffered, p, toCopy);
+				p += toCopy;
+				length -= toCopy;
+				ConsumeBlock(_buffer);
+			}
+
+			// consume directly from the source, skipping the buffer
+			for (; length > _FastHashBlockLength; p += _FastHashBlockLength, length -= _FastHashBlockLength)
+			{
+				ConsumeBlock(p);
+			}
+
+			MemOps::Copy(_buffer, p, length);
+			_buffered = length;
+		}
+
+		[[nodiscard]] auto Finish() const
+		{
+			if (_totalLength <= _FastHashShortLengthMax)
+			{
+				return _FastHashShort<precision>(_buffer, static_cast<uiw>(_totalLength));
+			}
+
+			ui64 accumulators[8];
+			MemOps::Copy(accumulators, _accumulators, 8);
+
+			ASSUME(_buffered > 0);
+			uiw stripesCount = (_buffered - 1) / _FastHashStripeLength;
+			_FastHashAccumulate<true>(accumulators, _buffer, stripesCount, 0);
+
+			if (_buffered >= _FastHashStripeLength)
+			{
+				_FastHashAccumulate<false>(accumulators, _buffer + _buffered - _FastHashStripeLength, 1, _FastHashLastStripeKeyIndex);
+			}
+			else
+			{
+				ui8 lastStripe[_FastHashStripeLength];
+				uiw fromPrevious = _FastHashStripeLength - _buffered;
+				MemOps::Copy(lastStripe, _previousStripe + _buffered, fromPrevious);
+				MemOps::Copy(lastStripe + fromPrevious, _buffer, _buffered);
+				_FastHashAccumulate<false>(accumulators, lastStripe, 1, _FastHashLastStripeKeyIndex);
+			}
+
+			return _FastHashMerge<precision>(accumulators, _totalLength);
+		}
+	};
+
+	// FastHash tree mode: the input is split into leafLength sized leaves (the last one can be shorter),
+	// every leaf is hashed with 128 bit FastHash independently from the others, so the leaves can be hashed in parallel,
+	// the result is FastHash of the leaf hashes followed by the total length and the leaf length
+	// produces different hashes than FastHash, the leaf length is a part of the hash
+	constexpr uiw FastHashTreeDefaultLeafLength = 1 << 20;
+
+	template <Precision precision> [[nodiscard]] auto FastHashTreeCombine(const Hash128 *leaves, uiw leavesCount, ui64 totalLength, uiw leafLength)
+	{
+		ASSUME(leafLength > 0 && leavesCount == (totalLength + leafLength - 1) / leafLength);
+		FastHasher<precision> hasher;
+		hasher.Update(leaves, leavesCount * sizeof(Hash128));
+		ui64 lengths[2] = {totalLength, leafLength};
+		hasher.Update(lengths, sizeof(lengths));
+		return hasher.Finish();
+	}
+
+	template <Precision precision> [[nodiscard]] auto FastHashTree(const void *source, uiw length, uiw leafLength = FastHashTreeDefaultLeafLength)
+	{
+		ASSUME(leafLength > 0);
+		const ui8 *p = static_cast<const ui8 *>(source);
+		std::vector<Hash128> leaves((length + leafLength - 1) / leafLength);
+		for (uiw index = 0; index < leaves.size(); ++index)
+		{
+			uiw offset = index * leafLength;
+			leaves[index] = FastHash<Precision::P128>(p + offset, std::min(leafLength, length - offset));
+		}
+		return FastHashTreeCombine<precision>(leaves.data(), leaves.size(), length, leafLength);
+	}
 
     // based on Thomas Mueller's answer from 
     // https://stackoverflow.com/questions/664014/what-integer-hash-function-are-good-that-accepts-an-integer-hash-key
     template <Precision precision, typename T> [[nodiscard]] auto Integer(T y)
     {
         static_assert(std::is_trivial_v<T>);
+		static_assert(precision == Precision::P32 || precision == Precision::P64, "integer hash supports only 32 and 64 bit precision");
 		auto fundamental = Funcs::ToFundamental(y);
         if constexpr (precision == Precision::P64)
         {
@@ -142,6 +635,7 @@ namespace StdLib::Hash
     template <Precision precision, typename T> [[nodiscard]] auto IntegerInverse(T y)
     {
         static_assert(std::is_trivial_v<T>);
+		static_assert(precision == Precision::P32 || precision == Precision::P64, "integer hash supports only 32 and 64 bit precision");
 		auto fundamental = Funcs::ToFundamental(y);
 		if constexpr (precision == Precision::P64)
         {
@@ -160,4 +654,53 @@ namespace StdLib::Hash
 			return x;
 		}
     }
+
+	// the SIMD versions of Integer and IntegerInverse, implemented in HashFuncs.cpp
+	// values are read and written as raw bits, source and target can point to the same array
+	void _IntegerBatch32(const void *source, void *target, uiw count);
+	void _IntegerBatch64(const void *source, void *target, uiw count);
+	void _IntegerInverseBatch32(const void *source, void *target, uiw count);
+	void _IntegerInverseBatch64(const void *source, void *target, uiw count);
+
+	// produce the same results as calling Integer and IntegerInverse for every value, source and target can point to the same array
+	// 4 byte values with P32 and 8 byte values with P64 are processed with SIMD, other combinations fall back to the scalar code
+	template <Precision precision, typename T> void IntegerBatch(const T *source, std::conditional_t<precision == Precision::P32, ui32, ui64> *target, uiw count)
+	{
+		static_assert(std::is_trivial_v<T>);
+		if constexpr (precision == Precision::P32 && sizeof(T) == 4)
+		{
+			_IntegerBatch32(source, target, count);
+		}
+		else if constexpr (precision == Precision::P64 && sizeof(T) == 8)
+		{
+			_IntegerBatch64(source, target, count);
+		}
+		else
+		{
+			for (uiw index = 0; index < count; ++index)
+			{
+				target[index] = Integer<precision>(source[index]);
+			}
+		}
+	}
+
+	template <Precision precision, typename T> void IntegerInverseBatch(const T *source, std::conditional_t<precision == Precision::P32, ui32, ui64> *target, uiw count)
+	{
+		static_assert(std::is_trivial_v<T>);
+		if constexpr (precision == Precision::P32 && sizeof(T) == 4)
+		{
+			_IntegerInverseBatch32(source, target, count);
+		}
+		else if constexpr (precision == Precision::P64 && sizeof(T) == 8)
+		{
+			_IntegerInverseBatch64(source, target, count);
+		}
+		else
+		{
+			for (uiw index = 0; index < count; ++index)
+			{
+				target[index] = IntegerInverse<precision>(source[index]);
+			}
+		}
+	}
 }
\ No newline at end of file
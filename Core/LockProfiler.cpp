@@ -0,0 +1,123 @@
+#include "_PreHeader.hpp"
+#include "LockProfiler.hpp"
+
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+
+using namespace StdLib;
+
+namespace
+{
+	// std::mutex because SpinLock registers itself here
+	struct Registry
+	{
+		std::mutex lock{};
+		std::vector<LockProfiler::Record *> records{};
+	};
+
+	// a function level static, locks with static storage duration can be created before any other static is initialized
+	Registry &GlobalRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+}
+
+auto LockProfiler::Record::StatsGet() const -> Stats
+{
+	Stats stats;
+	stats.acquisitions = acquisitions.load(std::memory_order_relaxed);
+	stats.contendedAcquisitions = contendedAcquisitions.load(std::memory_order_relaxed);
+	stats.spinIterations = spinIterations.load(std::memory_order_relaxed);
+	stats.waitUSec = waitUSec.load(std::memory_order_relaxed);
+	stats.waitingThreads = waitingThreads.load(std::memory_order_relaxed);
+	return stats;
+}
+
+auto LockProfiler::Register(const void *lock) -> Record *
+{
+	auto *record = new Record;
+	record->lock = lock;
+	Registry &registry = GlobalRegistry();
+	std::scoped_lock scopeLock(registry.lock);
+	registry.records.push_back(record);
+	return record;
+}
+
+void LockProfiler::Unregister(Record *record)
+{
+	Registry &registry = GlobalRegistry();
+	{
+		std::scoped_lock scopeLock(registry.lock);
+		auto it = std::find(registry.records.begin(), registry.records.end(), record);
+		ASSUME(it != registry.records.end());
+		*it = registry.records.back();
+		registry.records.pop_back();
+	}
+	delete record;
+}
+
+void LockProfiler::NameSet(Record *record, std::string_view name)
+{
+	Registry &registry = GlobalRegistry();
+	std::scoped_lock scopeLock(registry.lock);
+	record->name = name;
+}
+
+std::string LockProfiler::NameGet(const Record *record)
+{
+	Registry &registry = GlobalRegistry();
+	std::scoped_lock scopeLock(registry.lock);
+	return record->name;
+}
+
+auto LockProfiler::MostContended(uiw count) -> std::vector<Report>
+{
+	std::vector<Report> reports;
+	{
+		Registry &registry = GlobalRegistry();
+		std::scoped_lock scopeLock(registry.lock);
+		for (const Record *record : registry.records)
+		{
+			Stats stats = record->StatsGet();
+			if (stats.contendedAcquisitions)
+			{
+				reports.push_back({record->lock, record->name, stats});
+			}
+		}
+	}
+
+	auto isMoreContended = [](const Report &left, const Report &right)
+	{
+		if (left.stats.waitUSec != right.stats.waitUSec)
+		{
+			return left.stats.waitUSec > right.stats.waitUSec;
+		}
+		return left.stats.contendedAcquisitions > right.stats.contendedAcquisitions;
+	};
+
+	if (reports.size() > count)
+	{
+		std::partial_sort(reports.begin(), reports.begin() + count, reports.end(), isMoreContended);
+		reports.resize(count);
+	}
+	else
+	{
+		std::sort(reports.begin(), reports.end(), isMoreContended);
+	}
+	return reports;
+}
+
+void LockProfiler::Reset()
+{
+	Registry &registry = GlobalRegistry();
+	std::scoped_lock scopeLock(registry.lock);
+	for (Record *record : registry.records)
+	{
+		record->acquisitions.store(0, std::memory_order_relaxed);
+		record->contendedAcquisitions.store(0, std::memory_order_relaxed);
+		record->spinIterations.store(0, std::memory_order_relaxed);
+		record->waitUSec.store(0, std::memory_order_relaxed);
+	}
+}
+
+#endif
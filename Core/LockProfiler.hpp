@@ -0,0 +1,109 @@
+#pragma once
+
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+	#include <chrono>
+#endif
+
+namespace StdLib::LockProfiler
+{
+	/* Contention profiling for SpinLock and DIWRSpinLock, compiled in only when STDLIB_ENABLE_LOCK_PROFILING is defined.
+	   Every lock gets a record that is registered while the lock is alive, the records are reported sorted by the time
+	   threads spent waiting for them.
+	   An acquisition is contended if the first attempt failed, the clock is read only for the contended acquisitions,
+	   so the uncontended path pays only for one relaxed increment. The counters of a lock are shared by all its users.
+	   Successful TryLock calls are counted as uncontended acquisitions, failed ones aren't counted.
+	   DIWRSpinLock transitions that may have to wait (the upgrades and Read to Inclusive) are counted as acquisitions too.
+	   Wait time is measured with steady_clock, Core can't use TimeMoment.
+	*/
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+	struct Stats
+	{
+		using countert = ui64;
+		countert acquisitions;
+		countert contendedAcquisitions; // the first attempt to acquire the lock failed
+		countert spinIterations; // failed attempts, a waiter that went to sleep counts one per wake up
+		countert waitUSec; // from the first failed attempt to the acquisition
+		countert waitingThreads; // the threads that were waiting for the lock when the stats were taken
+	};
+
+	struct Report
+	{
+		const void *lock;
+		std::string name; // empty if the lock wasn't named
+		Stats stats;
+	};
+
+	struct alignas(64) Record
+	{
+		std::atomic<ui64> acquisitions{0};
+		std::atomic<ui64> contendedAcquisitions{0};
+		std::atomic<ui64> spinIterations{0};
+		std::atomic<ui64> waitUSec{0};
+		std::atomic<ui64> waitingThreads{0}; // isn't reset, it's the current state rather than a statistic
+		const void *lock = nullptr;
+		std::string name{}; // guarded by the registry lock
+
+		[[nodiscard]] Stats StatsGet() const;
+	};
+
+	[[nodiscard]] Record *Register(const void *lock);
+	void Unregister(Record *record);
+	void NameSet(Record *record, std::string_view name);
+	[[nodiscard]] std::string NameGet(const Record *record);
+
+	// up to count locks with the longest wait time, the ones that were never contended aren't reported
+	[[nodiscard]] std::vector<Report> MostContended(uiw count);
+	void Reset(); // resets the stats of all the registered locks
+
+	// measures a single acquisition
+	class Acquisition
+	{
+		Record *_record;
+		ui64 _failedAttempts = 0;
+		std::chrono::steady_clock::time_point _waitStart{};
+
+	public:
+		explicit Acquisition(Record *record) noexcept : _record(record)
+		{}
+
+		void Failed()
+		{
+			if (_failedAttempts++ == 0)
+			{
+				_waitStart = std::chrono::steady_clock::now();
+				_record->waitingThreads.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		void Acquired()
+		{
+			_record->acquisitions.fetch_add(1, std::memory_order_relaxed);
+			if (_failedAttempts)
+			{
+				auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _waitStart).count();
+				_record->contendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+				_record->spinIterations.fetch_add(_failedAttempts, std::memory_order_relaxed);
+				_record->waitUSec.fetch_add(static_cast<ui64>(waited), std::memory_order_relaxed);
+				_record->waitingThreads.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+	};
+#else
+	// the locks use it unconditionally, it compiles to nothing
+	class Acquisition
+	{
+	public:
+		void Failed()
+		{}
+
+		void Acquired()
+		{}
+	};
+#endif
+}
+
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+	#pragma detect_mismatch("STDLIB_ENABLE_LOCK_PROFILING", "1")
+#else
+	#pragma detect_mismatch("STDLIB_ENABLE_LOCK_PROFILING", "0")
+#endif
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "Message.hpp"
+#include "MessagePool.hpp"
+#include "Futex.hpp"
+#ifdef STDLIB_ENABLE_QUEUE_STATS
+    #include "ShardedCounter.hpp"
+#endif
+
+namespace StdLib
+{
+    // lock-free version of MTMessageQueue for multiple producers and a single consumer,
+    // intrusive Vyukov-style queue, the producers don't contend on anything but a single exchange,
+    // ExecWait, ExecNoWait and Clear must be called only by the consumer thread (one at a time)
+    // the consumer sleeps on a futex, producers check a flag and issue a wake only if it's actually asleep
+    class MPSCMessageQueue
+    {
+		struct MessageWithNext
+		{
+			std::atomic<MessageBase<MessageWithNext> *> nextMessage{nullptr};
+			ui32 allocatedSize = 0; // messages are allocated from MessagePool, it needs the size to free them
+		};
+
+		using Message = MessageBase<MessageWithNext>;
+
+		static constexpr ui32 SpinsBeforeSleep = 64;
+
+		alignas(64) std::atomic<Message *> _head; // producers push here
+		alignas(64) Message *_tail; // the consumer pops from here
+		Message _stub{}; // keeps the list non-empty, so the producers never have to touch _tail
+		std::atomic<ui32> _isConsumerSleeping{0};
+	#ifdef STDLIB_ENABLE_QUEUE_STATS
+		ShardedStats<MessageQueueStats> _stats{}; // a single atomic would be the only thing the producers contend on besides _head
+	#endif
+
+    public:
+		MPSCMessageQueue() : _head(&_stub), _tail(&_stub)
+		{}
+
+		~MPSCMessageQueue()
+		{
+			Clear();
+		}
+
+		MPSCMessageQueue(const MPSCMessageQueue &) = delete;
+		MPSCMessageQueue &operator = (const MPSCMessageQueue &) = delete;
+
+        template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> void Add(Caller &&caller, VArgs &&... args)
+        {
+            using messageType = MessageDelegate<MessageWithNext, Caller, Method, VArgs...>;
+            NewMessage(AllocateMessage<messageType>(std::forward<Caller>(caller), std::forward<VArgs>(args)...));
+        }
+
+        template <auto Func, typename... VArgs> void Add(VArgs &&... args)
+        {
+            using messageType = MessageFuncInline<MessageWithNext, Func, VArgs...>;
+            NewMessage(AllocateMessage<messageType>(std::forward<VArgs>(args)...));
+        }
+
+        template <typename FuncType, typename... VArgs> void Add(FuncType func, VArgs &&... args)
+        {
+            using messageType = MessageFuncPointer<MessageWithNext, FuncType, VArgs...>;
+            NewMessage(AllocateMessage<messageType>(func, std::forward<VArgs>(args)...));
+        }
+
+        void ExecWait()
+        {
+			for (ui32 attempt = 0;; ++attempt)
+			{
+				if (ExecNoWait())
+				{
+					return;
+				}
+				if (attempt < SpinsBeforeSleep)
+				{
+					CPU_PAUSE();
+					continue;
+				}
+
+				// pairs with the fence in NewMessage, either the producer sees the flag or we see its message
+				_isConsumerSleeping.store(1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (ExecNoWait())
+				{
+					_isConsumerSleeping.store(0, std::memory_order_relaxed);
+					return;
+				}
+				Futex::Wait(_isConsumerSleeping, 1);
+				_isConsumerSleeping.store(0, std::memory_order_relaxed);
+				attempt = 0;
+			}
+        }
+
+        bool ExecNoWait() // returns true if something had been exectuted
+        {
+			Message *message = Pop();
+			if (message == nullptr)
+			{
+				return false;
+			}
+
+			uiw size = message->allocatedSize; // the message is destroyed by Execute
+			message->Execute(Message::Action::ProcessAndDestroy);
+			MessagePool::Free(message, size);
+			StatsAdd(&MessageQueueStats::executed);
+
+            return true;
+        }
+
+		void Clear()
+		{
+			while (Message *message = Pop())
+			{
+				uiw size = message->allocatedSize;
+				message->Execute(Message::Action::Destroy);
+				MessagePool::Free(message, size);
+				StatsAdd(&MessageQueueStats::destroyed);
+			}
+		}
+
+	#ifdef STDLIB_ENABLE_QUEUE_STATS
+		[[nodiscard]] MessageQueueStats StatsGet() const
+		{
+			return _stats.Load();
+		}
+
+		MessageQueueStats StatsReset() // returns the stats before the reset
+		{
+			return _stats.Reset();
+		}
+	#endif
+
+    private:
+		template <typename T, typename... Args> static T *AllocateMessage(Args &&... args)
+		{
+			T *message = MessagePool::New<T>(std::forward<Args>(args)...);
+			message->allocatedSize = sizeof(T);
+			return message;
+		}
+
+		void StatsAdd([[maybe_unused]] MessageQueueStats::countert MessageQueueStats::*field)
+		{
+		#ifdef STDLIB_ENABLE_QUEUE_STATS
+			_stats.Add(field);
+		#endif
+		}
+
+        void NewMessage(Message *message)
+        {
+			StatsAdd(&MessageQueueStats::added);
+			message->nextMessage.store(nullptr, std::memory_order_relaxed);
+			Push(message);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (_isConsumerSleeping.load(std::memory_order_relaxed) && _isConsumerSleeping.exchange(0, std::memory_order_relaxed))
+			{
+				Futex::WakeOne(_isConsumerSleeping);
+			}
+        }
+
+		void Push(Message *message)
+		{
+			Message *previous = _head.exchange(message, std::memory_order_acq_rel);
+			previous->nextMessage.store(message, std::memory_order_release); // the consumer can't see the message until this store
+		}
+
+		// returns nullptr if the queue is empty or a producer is in the middle of Push, the latter is treated as empty,
+		// the producer will wake the consumer after it is done
+		Message *Pop()
+		{
+			Message *tail = _tail;
+			Message *next = tail->nextMessage.load(std::memory_order_acquire);
+
+			if (tail == &_stub)
+			{
+				if (next == nullptr)
+				{
+					return nullptr;
+				}
+				_tail = next;
+				tail = next;
+				next = next->nextMessage.load(std::memory_order_acquire);
+			}
+
+			if (next)
+			{
+				_tail = next;
+				return tail;
+			}
+
+			if (tail != _head.load(std::memory_order_acquire))
+			{
+				return nullptr;
+			}
+
+			// tail is the last message, the stub is put behind it so tail can be detached
+			_stub.nextMessage.store(nullptr, std::memory_order_relaxed);
+			Push(&_stub);
+			next = tail->nextMessage.load(std::memory_order_acquire);
+			if (next)
+			{
+				_tail = next;
+				return tail;
+			}
+			return nullptr;
+		}
+    };
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "Message.hpp"
+#include "MessagePool.hpp"
 #include "SpinLock.hpp"
+#ifdef STDLIB_ENABLE_QUEUE_STATS
+    #include "ShardedCounter.hpp"
+#endif
 
 namespace StdLib
 {
@@ -11,6 +15,7 @@ namespace StdLib
 		struct MessageWithNext
 		{
 			MessageBase<MessageWithNext> *nextMessage = nullptr;
+			ui32 allocatedSize = 0; // messages are allocated from MessagePool, it needs the size to free them
 		};
 
 		using Message = MessageBase<MessageWithNext>;
@@ -18,12 +23,83 @@ namespace StdLib
 		Message *_firstMessage{}, *_lastMessage{};
         SpinLock _mutex{};
         std::condition_variable_any _newWorkNotifier{};
+    #ifdef STDLIB_ENABLE_QUEUE_STATS
+        ShardedStats<MessageQueueStats> _stats{}; // producers and consumers update it from different threads
+    #endif
 
     public:
+        // a chain of messages built without any synchronization and posted with a single lock acquisition using AddBatch
+        class Batch
+        {
+            friend MTMessageQueue;
+
+            Message *_firstMessage{}, *_lastMessage{};
+            uiw _size = 0;
+
+        public:
+            Batch() = default;
+
+            ~Batch()
+            {
+                DestroyMessages(_firstMessage);
+            }
+
+            Batch(Batch &&source) noexcept : _firstMessage(std::exchange(source._firstMessage, nullptr)), _lastMessage(std::exchange(source._lastMessage, nullptr)), _size(std::exchange(source._size, 0))
+            {}
+
+            Batch &operator = (Batch &&source) noexcept
+            {
+                ASSUME(this != &source);
+                DestroyMessages(_firstMessage);
+                _firstMessage = std::exchange(source._firstMessage, nullptr);
+                _lastMessage = std::exchange(source._lastMessage, nullptr);
+                _size = std::exchange(source._size, 0);
+                return *this;
+            }
+
+            template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> void Add(Caller &&caller, VArgs &&... args)
+            {
+                using messageType = MessageDelegate<MessageWithNext, Caller, Method, VArgs...>;
+                Append(AllocateMessage<messageType>(std::forward<Caller>(caller), std::forward<VArgs>(args)...));
+            }
+
+            template <auto Func, typename... VArgs> void Add(VArgs &&... args)
+            {
+                using messageType = MessageFuncInline<MessageWithNext, Func, VArgs...>;
+                Append(AllocateMessage<messageType>(std::forward<VArgs>(args)...));
+            }
+
+            template <typename FuncType, typename... VArgs> void Add(FuncType func, VArgs &&... args)
+            {
+                using messageType = MessageFuncPointer<MessageWithNext, FuncType, VArgs...>;
+                Append(AllocateMessage<messageType>(func, std::forward<VArgs>(args)...));
+            }
+
+            [[nodiscard]] uiw Size() const
+            {
+                return _size;
+            }
+
+        private:
+            void Append(Message *message)
+            {
+                if (_lastMessage)
+                {
+                    _lastMessage->nextMessage = message;
+                }
+                else
+                {
+                    _firstMessage = message;
+                }
+                _lastMessage = message;
+                ++_size;
+            }
+        };
+
         template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> void Add(Caller &&caller, VArgs &&... args)
         {
             using messageType = MessageDelegate<MessageWithNext, Caller, Method, VArgs...>;
-            auto newMessage = new messageType(std::forward<Caller>(caller), std::forward<VArgs>(args)...);
+            auto newMessage = AllocateMessage<messageType>(std::forward<Caller>(caller), std::forward<VArgs>(args)...);
             std::scoped_lock lock{_mutex};
             NewMessage(newMessage);
             _newWorkNotifier.notify_all();
@@ -32,7 +108,7 @@ namespace StdLib
         template <auto Func, typename... VArgs> void Add(VArgs &&... args)
         {
             using messageType = MessageFuncInline<MessageWithNext, Func, VArgs...>;
-            auto newMessage = new messageType(std::forward<VArgs>(args)...);
+            auto newMessage = AllocateMessage<messageType>(std::forward<VArgs>(args)...);
             std::scoped_lock lock{_mutex};
             NewMessage(newMessage);
             _newWorkNotifier.notify_all();
@@ -41,12 +117,39 @@ namespace StdLib
         template <typename FuncType, typename... VArgs> void Add(FuncType func, VArgs &&... args)
         {
             using messageType = MessageFuncPointer<MessageWithNext, FuncType, VArgs...>;
-            auto newMessage = new messageType(func, std::forward<VArgs>(args)...);
+            auto newMessage = AllocateMessage<messageType>(func, std::forward<VArgs>(args)...);
             std::scoped_lock lock{_mutex};
             NewMessage(newMessage);
             _newWorkNotifier.notify_all();
         }
 
+        // the batch is left empty
+        void AddBatch(Batch &&batch)
+        {
+            if (batch._firstMessage == nullptr)
+            {
+                return;
+            }
+
+            {
+                std::scoped_lock lock{_mutex};
+                if (_lastMessage)
+                {
+                    _lastMessage->nextMessage = batch._firstMessage;
+                }
+                else
+                {
+                    _firstMessage = batch._firstMessage;
+                }
+                _lastMessage = batch._lastMessage;
+            }
+            _newWorkNotifier.notify_all();
+            StatsAdd(&MessageQueueStats::added, batch._size);
+
+            batch._firstMessage = batch._lastMessage = nullptr;
+            batch._size = 0;
+        }
+
         void ExecWait()
         {
             std::unique_lock cvLock{_mutex};
@@ -61,8 +164,8 @@ namespace StdLib
 
             cvLock.unlock();
 
-			message->Execute(Message::Action::ProcessAndDestroy);
-            delete message;
+			ExecuteAndFree(message);
+            StatsAdd(&MessageQueueStats::executed);
         }
 
         bool ExecNoWait() // returns true if something had been exectuted
@@ -85,29 +188,144 @@ namespace StdLib
                 }
             }
 
-			message->Execute(Message::Action::ProcessAndDestroy);
-            delete message;
+			ExecuteAndFree(message);
+            StatsAdd(&MessageQueueStats::executed);
 
             return true;
         }
 
+        // detaches all pending messages with a single lock acquisition and executes them, returns how many were executed
+        uiw ExecAll()
+        {
+            Message *message;
+
+            {
+                std::scoped_lock scopeLock{_mutex};
+                message = _firstMessage;
+                _firstMessage = _lastMessage = nullptr;
+            }
+
+            uiw executed = ExecuteChain(message);
+            StatsAdd(&MessageQueueStats::executed, executed);
+            return executed;
+        }
+
+        // same as ExecAll, but detaches no more than maxCount messages, the rest stays in the queue
+        uiw ExecUpTo(uiw maxCount)
+        {
+            if (maxCount == 0)
+            {
+                return 0;
+            }
+
+            Message *message;
+
+            {
+                std::scoped_lock scopeLock{_mutex};
+
+                message = _firstMessage;
+                if (message == nullptr)
+                {
+                    return 0;
+                }
+
+                Message *last = message;
+                for (uiw index = 1; index < maxCount && last->nextMessage; ++index)
+                {
+                    last = last->nextMessage;
+                }
+
+                _firstMessage = last->nextMessage;
+                if (_firstMessage == nullptr)
+                {
+                    _lastMessage = nullptr;
+                }
+                last->nextMessage = nullptr;
+            }
+
+            uiw executed = ExecuteChain(message);
+            StatsAdd(&MessageQueueStats::executed, executed);
+            return executed;
+        }
+
 		void Clear()
 		{
-			std::scoped_lock scopeLock{_mutex};
-
-			Message *curMessage = _firstMessage;
+			Message *curMessage;
 
-			while (curMessage)
 			{
-                Message *nextMessage = curMessage->nextMessage;
-				curMessage->Execute(Message::Action::Destroy);
-				curMessage = nextMessage;
+				std::scoped_lock scopeLock{_mutex};
+				curMessage = _firstMessage;
+				_firstMessage = _lastMessage = nullptr;
 			}
+
+			StatsAdd(&MessageQueueStats::destroyed, DestroyMessages(curMessage));
 		}
 
+    #ifdef STDLIB_ENABLE_QUEUE_STATS
+        [[nodiscard]] MessageQueueStats StatsGet() const
+        {
+            return _stats.Load();
+        }
+
+        MessageQueueStats StatsReset() // returns the stats before the reset
+        {
+            return _stats.Reset();
+        }
+    #endif
+
     private:
+		static uiw ExecuteChain(Message *message)
+		{
+			uiw executed = 0;
+			while (message)
+			{
+				Message *nextMessage = message->nextMessage; // must be read before the message is destroyed
+				ExecuteAndFree(message);
+				message = nextMessage;
+				++executed;
+			}
+			return executed;
+		}
+
+		static uiw DestroyMessages(Message *message) // returns how many were destroyed
+		{
+			uiw destroyed = 0;
+			while (message)
+			{
+				Message *nextMessage = message->nextMessage;
+				uiw size = message->allocatedSize;
+				message->Execute(Message::Action::Destroy);
+				MessagePool::Free(message, size);
+				message = nextMessage;
+				++destroyed;
+			}
+			return destroyed;
+		}
+
+		template <typename T, typename... Args> static T *AllocateMessage(Args &&... args)
+		{
+			T *message = MessagePool::New<T>(std::forward<Args>(args)...);
+			message->allocatedSize = sizeof(T);
+			return message;
+		}
+
+		static void ExecuteAndFree(Message *message)
+		{
+			uiw size = message->allocatedSize; // the message is destroyed by Execute
+			message->Execute(Message::Action::ProcessAndDestroy);
+			MessagePool::Free(message, size);
+		}
+
+        void StatsAdd([[maybe_unused]] MessageQueueStats::countert MessageQueueStats::*field, [[maybe_unused]] uiw value = 1)
+        {
+        #ifdef STDLIB_ENABLE_QUEUE_STATS
+            _stats.Add(field, value);
+        #endif
+        }
+
         void NewMessage(Message *message)
         {
+            StatsAdd(&MessageQueueStats::added);
             if (_lastMessage)
             {
                 _lastMessage->nextMessage = message;
@@ -87,7 +87,7 @@ bool MemoryStreamFile::Read(void *RSTR target, ui32 len, ui32 *RSTR read)
     {
         len = static_cast<ui32>(uiw_max - _offset);
     }
-    MemOps::Copy(static_cast<std::byte *>(target), _stream->Memory() + _offset, len);
+    MemOps::Copy(static_cast<std::byte *>(target), _stream->CMemory() + _offset, len);
     _offset += len;
     if (read) *read = len;
     return true;
@@ -212,4 +212,19 @@ namespace StdLib
             this->_execute = &CallFunc;
         }
     };
-}
\ No newline at end of file
+
+    // collected by the message queues when STDLIB_ENABLE_QUEUE_STATS is defined
+    struct MessageQueueStats
+    {
+        using countert = ui64;
+        countert added;
+        countert executed;
+        countert destroyed; // removed by Clear or by the queue's destructor without being executed
+    };
+}
+
+#ifdef STDLIB_ENABLE_QUEUE_STATS
+	#pragma detect_mismatch("STDLIB_ENABLE_QUEUE_STATS", "1")
+#else
+	#pragma detect_mismatch("STDLIB_ENABLE_QUEUE_STATS", "0")
+#endif
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "_PreHeader.hpp"
+#include "MessagePool.hpp"
+#include "SpinLock.hpp"
+#include "GenericFuncs.hpp"
+#include "ShardedCounter.hpp"
+
+using namespace StdLib;
+
+namespace
+{
+	constexpr uiw MinClassSizeLog2 = 5;
+	constexpr uiw MinClassSize = 1 << MinClassSizeLog2;
+	constexpr uiw ClassesCount = 5; // 32, 64, 128, 256, 512
+	constexpr uiw SlabSize = 64 * 1024;
+	constexpr ui32 ThreadCacheLimit = 256; // a thread with more free blocks of a class than this gives a batch to the depot
+	constexpr ui32 TransferBatchSize = 128;
+
+	static_assert(MinClassSize << (ClassesCount - 1) == MessagePool::MaxPooledSize);
+
+	struct FreeBlock
+	{
+		FreeBlock *next;
+		FreeBlock *nextBatch; // used only by the first block of a batch in the depot
+		ui32 batchSize; // used only by the first block of a batch in the depot
+	};
+
+	static_assert(sizeof(FreeBlock) <= MinClassSize);
+
+#ifdef STDLIB_ENABLE_ALLOCATOR_STATS
+	// blocks are allocated and freed from every thread, a single set of atomics would be contended on every call
+	ShardedStats<MessagePool::Stats> GlobalStats;
+
+	#define MESSAGE_POOL_STATS_ADD(field) GlobalStats.Add(&MessagePool::Stats::field)
+#else
+	#define MESSAGE_POOL_STATS_ADD(field)
+#endif
+
+	struct Depot
+	{
+		SpinLock lock{};
+		FreeBlock *batches = nullptr;
+	};
+
+	Depot &DepotForClass(uiw classIndex)
+	{
+		static Depot depots[ClassesCount];
+		return depots[classIndex];
+	}
+
+	uiw ClassIndex(uiw size)
+	{
+		if (size <= MinClassSize)
+		{
+			return 0;
+		}
+		return Funcs::IndexOfMostSignificantNonZeroBit(size - 1) + 1 - MinClassSizeLog2;
+	}
+
+	void GiveToDepot(uiw classIndex, FreeBlock *first, ui32 count)
+	{
+		first->batchSize = count;
+		MESSAGE_POOL_STATS_ADD(depotReturns);
+		Depot &depot = DepotForClass(classIndex);
+		std::scoped_lock lock(depot.lock);
+		first->nextBatch = depot.batches;
+		depot.batches = first;
+	}
+
+	struct ThreadCache
+	{
+		FreeBlock *heads[ClassesCount]{};
+		ui32 counts[ClassesCount]{};
+
+		~ThreadCache()
+		{
+			for (uiw classIndex = 0; classIndex < ClassesCount; ++classIndex)
+			{
+				if (heads[classIndex])
+				{
+					GiveToDepot(classIndex, heads[classIndex], counts[classIndex]);
+				}
+			}
+		}
+
+		void Refill(uiw classIndex)
+		{
+			Depot &depot = DepotForClass(classIndex);
+			{
+				std::scoped_lock lock(depot.lock);
+				if (FreeBlock *batch = depot.batches)
+				{
+					depot.batches = batch->nextBatch;
+					heads[classIndex] = batch;
+					counts[classIndex] = batch->batchSize;
+					MESSAGE_POOL_STATS_ADD(depotRefills);
+					return;
+				}
+			}
+
+			uiw classSize = MinClassSize << classIndex;
+			ui32 blocksCount = static_cast<ui32>(SlabSize / classSize);
+			auto *slab = static_cast<std::byte *>(::operator new(SlabSize));
+			MESSAGE_POOL_STATS_ADD(slabsAllocated);
+			for (ui32 index = 0; index < blocksCount; ++index)
+			{
+				auto *block = reinterpret_cast<FreeBlock *>(slab + index * classSize);
+				block->next = index + 1 < blocksCount ? reinterpret_cast<FreeBlock *>(slab + (index + 1) * classSize) : nullptr;
+			}
+			heads[classIndex] = reinterpret_cast<FreeBlock *>(slab);
+			counts[classIndex] = blocksCount;
+		}
+	};
+
+	thread_local ThreadCache Cache;
+}
+
+void *MessagePool::Allocate(uiw size)
+{
+	if (size > MaxPooledSize)
+	{
+		MESSAGE_POOL_STATS_ADD(largeAllocations);
+		return ::operator new(size);
+	}
+
+	MESSAGE_POOL_STATS_ADD(pooledAllocations);
+
+	uiw classIndex = ClassIndex(size);
+	ThreadCache &cache = Cache;
+	if (cache.heads[classIndex] == nullptr)
+	{
+		cache.Refill(classIndex);
+	}
+
+	FreeBlock *block = cache.heads[classIndex];
+	cache.heads[classIndex] = block->next;
+	--cache.counts[classIndex];
+	return block;
+}
+
+void MessagePool::Free(void *memory, uiw size)
+{
+	if (size > MaxPooledSize)
+	{
+		MESSAGE_POOL_STATS_ADD(largeFrees);
+		::operator delete(memory);
+		return;
+	}
+
+	MESSAGE_POOL_STATS_ADD(pooledFrees);
+
+	uiw classIndex = ClassIndex(size);
+	ThreadCache &cache = Cache;
+	auto *block = static_cast<FreeBlock *>(memory);
+	block->next = cache.heads[classIndex];
+	cache.heads[classIndex] = block;
+
+	if (++cache.counts[classIndex] > ThreadCacheLimit)
+	{
+		// the newest blocks stay in the cache, they're more likely to still be in the CPU cache
+		constexpr ui32 toKeep = ThreadCacheLimit - TransferBatchSize;
+		FreeBlock *last = block;
+		for (ui32 index = 1; index < toKeep; ++index)
+		{
+			last = last->next;
+		}
+		FreeBlock *batch = last->next;
+		last->next = nullptr;
+		GiveToDepot(classIndex, batch, cache.counts[classIndex] - toKeep);
+		cache.counts[classIndex] = toKeep;
+	}
+}
+
+#ifdef STDLIB_ENABLE_ALLOCATOR_STATS
+auto MessagePool::StatsGet() -> Stats
+{
+	return GlobalStats.Load();
+}
+
+auto MessagePool::StatsReset() -> Stats
+{
+	return GlobalStats.Reset();
+}
+#endif
\ No newline at end of file
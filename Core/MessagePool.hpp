@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+namespace StdLib::MessagePool
+{
+	// thread caching allocator for small objects that are usually allocated on one thread and freed on another,
+	// like queued messages, sizes up to MaxPooledSize are rounded up to a power of two size class and served
+	// from 64KB slabs, each thread keeps its own free lists and exchanges batches of blocks with a shared depot
+	// when its lists run dry or grow too large, larger sizes go straight to operator new
+	// slabs are never returned to the system, their memory is reused by later allocations
+	constexpr uiw MaxPooledSize = 512;
+
+	[[nodiscard]] void *Allocate(uiw size);
+	void Free(void *memory, uiw size); // size must be the same as the one used to allocate the memory
+
+#ifdef STDLIB_ENABLE_ALLOCATOR_STATS
+	struct Stats
+	{
+		using countert = ui64;
+		countert pooledAllocations;
+		countert pooledFrees;
+		countert largeAllocations; // sizes above MaxPooledSize
+		countert largeFrees;
+		countert slabsAllocated;
+		countert depotRefills; // a thread cache took a batch of blocks from the depot
+		countert depotReturns; // a thread cache gave a batch of blocks to the depot
+	};
+
+	// the sum of the stats of all threads
+	[[nodiscard]] Stats StatsGet();
+	Stats StatsReset(); // returns the stats before the reset
+#endif
+
+	template <typename T, typename... Args> [[nodiscard]] T *New(Args &&... args)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+		return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,478 @@
+#pragma once
+
+#include "Futex.hpp"
+
+namespace StdLib
+{
+	/* Fixed capacity queues for value types, the storage is allocated once by the constructor, pushing and popping never allocate.
+	   The capacity must be a power of two. A full queue makes the producers fail or wait, which gives the backpressure.
+	   Spin: the waiting operations spin, the producers and the consumers don't pay for the waiting support
+	   Blocking: the waiting operations spin for a bit and then sleep on a futex, every push and pop issues a full fence
+	     to check whether anyone is sleeping on the other side, the wake itself is issued only if there is a sleeper
+	   Elements left in a queue are destroyed with it.
+	*/
+	enum class RingQueueMode : ui8 { Spin, Blocking };
+
+	class _RingQueueSignal
+	{
+		static constexpr ui32 SpinAttempts = 64;
+
+		std::atomic<ui32> _epoch{0};
+		std::atomic<ui32> _waiters{0};
+
+	public:
+		// tries the operation until it succeeds, sleeps between the attempts if the mode is Blocking
+		template <typename Attempt, typename IsReady> void WaitUntil(RingQueueMode mode, Attempt &&attempt, IsReady &&isReady)
+		{
+			for (ui32 spins = 0; !attempt(); ++spins)
+			{
+				if (mode == RingQueueMode::Spin || spins < SpinAttempts)
+				{
+					CPU_PAUSE();
+					continue;
+				}
+
+				ui32 epoch = _epoch.load(std::memory_order_relaxed);
+				_waiters.fetch_add(1, std::memory_order_relaxed);
+				// pairs with the fence in Notify, either we see the change or the notifier sees us
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (!isReady())
+				{
+					Futex::Wait(_epoch, epoch);
+				}
+				_waiters.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		void Notify(RingQueueMode mode, bool isWakingAll)
+		{
+			if (mode == RingQueueMode::Spin)
+			{
+				return;
+			}
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (_waiters.load(std::memory_order_relaxed) != 0)
+			{
+				_epoch.fetch_add(1, std::memory_order_relaxed);
+				if (isWakingAll)
+				{
+					Futex::WakeAll(_epoch);
+				}
+				else
+				{
+					Futex::WakeOne(_epoch);
+				}
+			}
+		}
+	};
+
+	// one producer thread and one consumer thread, each side caches the other side's index
+	// and reads the shared one only when the cached value says the queue is full or empty
+	template <typename T> class SPSCRingQueue
+	{
+		struct Slot
+		{
+			alignas(T) std::byte storage[sizeof(T)];
+
+			T *Get()
+			{
+				return std::launder(reinterpret_cast<T *>(storage));
+			}
+		};
+
+		uiw _mask = 0;
+		std::unique_ptr<Slot[]> _slots{};
+		RingQueueMode _mode = RingQueueMode::Spin;
+
+		alignas(64) std::atomic<uiw> _tail{0}; // written by the producer
+		uiw _cachedHead = 0; // the producer's copy of _head
+
+		alignas(64) std::atomic<uiw> _head{0}; // written by the consumer
+		uiw _cachedTail = 0; // the consumer's copy of _tail
+
+		alignas(64) _RingQueueSignal _notEmpty{};
+		_RingQueueSignal _notFull{};
+
+	public:
+		explicit SPSCRingQueue(uiw capacity, RingQueueMode mode = RingQueueMode::Spin) : _mask(capacity - 1), _slots(new Slot[capacity]), _mode(mode)
+		{
+			ASSUME(capacity > 0 && (capacity & (capacity - 1)) == 0);
+		}
+
+		~SPSCRingQueue()
+		{
+			for (uiw index = _head.load(std::memory_order_relaxed), tail = _tail.load(std::memory_order_relaxed); index != tail; ++index)
+			{
+				_slots[index & _mask].Get()->~T();
+			}
+		}
+
+		SPSCRingQueue(const SPSCRingQueue &) = delete;
+		SPSCRingQueue &operator = (const SPSCRingQueue &) = delete;
+
+		// producer only, the value isn't moved from if the queue is full
+		[[nodiscard]] bool TryPush(T &&value)
+		{
+			return TryPushBatch(&value, 1) == 1;
+		}
+
+		[[nodiscard]] bool TryPush(const T &value)
+		{
+			T copy = value;
+			return TryPush(std::move(copy));
+		}
+
+		// producer only, moves as many values as there is free space for, returns how many were pushed
+		[[nodiscard]] uiw TryPushBatch(T *values, uiw count)
+		{
+			uiw tail = _tail.load(std::memory_order_relaxed);
+			uiw capacity = _mask + 1;
+			if (capacity - (tail - _cachedHead) < count)
+			{
+				_cachedHead = _head.load(std::memory_order_acquire);
+			}
+			count = std::min(count, capacity - (tail - _cachedHead));
+			if (count == 0)
+			{
+				return 0;
+			}
+
+			for (uiw index = 0; index < count; ++index)
+			{
+				new (_slots[(tail + index) & _mask].storage) T(std::move(values[index]));
+			}
+			_tail.store(tail + count, std::memory_order_release);
+			_notEmpty.Notify(_mode, false);
+			return count;
+		}
+
+		// producer only, waits for free space
+		void Push(T &&value)
+		{
+			_notFull.WaitUntil(_mode, [this, &value] { return TryPush(std::move(value)); }, [this] { return !IsFullApprox(); });
+		}
+
+		void Push(const T &value)
+		{
+			T copy = value;
+			Push(std::move(copy));
+		}
+
+		// producer only, waits until all the values are pushed
+		void PushBatch(T *values, uiw count)
+		{
+			_notFull.WaitUntil(_mode, [this, &values, &count]
+			{
+				uiw pushed = TryPushBatch(values, count);
+				values += pushed;
+				count -= pushed;
+				return count == 0;
+			}, [this] { return !IsFullApprox(); });
+		}
+
+		// consumer only
+		[[nodiscard]] std::optional<T> TryPop()
+		{
+			uiw head = _head.load(std::memory_order_relaxed);
+			if (head == _cachedTail)
+			{
+				_cachedTail = _tail.load(std::memory_order_acquire);
+				if (head == _cachedTail)
+				{
+					return std::nullopt;
+				}
+			}
+
+			T *slot = _slots[head & _mask].Get();
+			std::optional<T> value = std::move(*slot);
+			slot->~T();
+			_head.store(head + 1, std::memory_order_release);
+			_notFull.Notify(_mode, false);
+			return value;
+		}
+
+		// consumer only, moves up to maxCount values into the output, returns how many were popped
+		[[nodiscard]] uiw TryPopBatch(T *output, uiw maxCount)
+		{
+			uiw head = _head.load(std::memory_order_relaxed);
+			if (_cachedTail - head < maxCount)
+			{
+				_cachedTail = _tail.load(std::memory_order_acquire);
+			}
+			uiw count = std::min(maxCount, _cachedTail - head);
+			if (count == 0)
+			{
+				return 0;
+			}
+
+			for (uiw index = 0; index < count; ++index)
+			{
+				T *slot = _slots[(head + index) & _mask].Get();
+				output[index] = std::move(*slot);
+				slot->~T();
+			}
+			_head.store(head + count, std::memory_order_release);
+			_notFull.Notify(_mode, false);
+			return count;
+		}
+
+		// consumer only, waits for a value
+		[[nodiscard]] T Pop()
+		{
+			std::optional<T> value;
+			_notEmpty.WaitUntil(_mode, [this, &value] { value = TryPop(); return value.has_value(); }, [this] { return !IsEmptyApprox(); });
+			return std::move(*value);
+		}
+
+		// consumer only, waits until there's at least one value
+		[[nodiscard]] uiw PopBatch(T *output, uiw maxCount)
+		{
+			ASSUME(maxCount > 0);
+			uiw count = 0;
+			_notEmpty.WaitUntil(_mode, [this, output, maxCount, &count] { count = TryPopBatch(output, maxCount); return count != 0; }, [this] { return !IsEmptyApprox(); });
+			return count;
+		}
+
+		[[nodiscard]] uiw Capacity() const
+		{
+			return _mask + 1;
+		}
+
+		// can be stale by the time it returns
+		[[nodiscard]] uiw SizeApprox() const
+		{
+			uiw head = _head.load(std::memory_order_acquire);
+			uiw tail = _tail.load(std::memory_order_acquire);
+			return std::min(tail - head, _mask + 1); // the tail is read last, it can be ahead of the head by more than the capacity
+		}
+
+		[[nodiscard]] bool IsEmptyApprox() const
+		{
+			return SizeApprox() == 0;
+		}
+
+		[[nodiscard]] bool IsFullApprox() const
+		{
+			return SizeApprox() == _mask + 1;
+		}
+	};
+
+	// any number of producers and consumers, Vyukov's bounded queue, every cell has a sequence number that tells
+	// whether it's ready to be written or read at the current lap, the producers and the consumers contend only on
+	// their own index, batches claim a run of consecutive ready cells with a single compare-exchange
+	template <typename T> class MPMCRingQueue
+	{
+		struct Cell
+		{
+			std::atomic<uiw> sequence;
+			alignas(T) std::byte storage[sizeof(T)];
+
+			T *Get()
+			{
+				return std::launder(reinterpret_cast<T *>(storage));
+			}
+		};
+
+		uiw _mask = 0;
+		std::unique_ptr<Cell[]> _cells{};
+		RingQueueMode _mode = RingQueueMode::Spin;
+
+		alignas(64) std::atomic<uiw> _enqueuePosition{0};
+		alignas(64) std::atomic<uiw> _dequeuePosition{0};
+
+		alignas(64) _RingQueueSignal _notEmpty{};
+		_RingQueueSignal _notFull{};
+
+	public:
+		explicit MPMCRingQueue(uiw capacity, RingQueueMode mode = RingQueueMode::Spin) : _mask(capacity - 1), _cells(new Cell[capacity]), _mode(mode)
+		{
+			ASSUME(capacity > 1 && (capacity & (capacity - 1)) == 0);
+			for (uiw index = 0; index < capacity; ++index)
+			{
+				_cells[index].sequence.store(index, std::memory_order_relaxed);
+			}
+		}
+
+		~MPMCRingQueue()
+		{
+			while (TryPop())
+			{}
+		}
+
+		MPMCRingQueue(const MPMCRingQueue &) = delete;
+		MPMCRingQueue &operator = (const MPMCRingQueue &) = delete;
+
+		// the value isn't moved from if the queue is full
+		[[nodiscard]] bool TryPush(T &&value)
+		{
+			return TryPushBatch(&value, 1) == 1;
+		}
+
+		[[nodiscard]] bool TryPush(const T &value)
+		{
+			T copy = value;
+			return TryPush(std::move(copy));
+		}
+
+		// moves as many values as there are consecutive free cells for, returns how many were pushed,
+		// the batch stays contiguous in the queue, so the consumers receive it in order
+		[[nodiscard]] uiw TryPushBatch(T *values, uiw count)
+		{
+			uiw position, claimed;
+			if (!Claim(_enqueuePosition, 0, count, position, claimed))
+			{
+				return 0;
+			}
+
+			for (uiw index = 0; index < claimed; ++index)
+			{
+				Cell &cell = _cells[(position + index) & _mask];
+				new (cell.storage) T(std::move(values[index]));
+				cell.sequence.store(position + index + 1, std::memory_order_release);
+			}
+			_notEmpty.Notify(_mode, claimed > 1);
+			return claimed;
+		}
+
+		// waits for free space
+		void Push(T &&value)
+		{
+			_notFull.WaitUntil(_mode, [this, &value] { return TryPush(std::move(value)); }, [this] { return !IsFullApprox(); });
+		}
+
+		void Push(const T &value)
+		{
+			T copy = value;
+			Push(std::move(copy));
+		}
+
+		// waits until all the values are pushed, other producers' values can get between the parts of the batch
+		void PushBatch(T *values, uiw count)
+		{
+			_notFull.WaitUntil(_mode, [this, &values, &count]
+			{
+				uiw pushed = TryPushBatch(values, count);
+				values += pushed;
+				count -= pushed;
+				return count == 0;
+			}, [this] { return !IsFullApprox(); });
+		}
+
+		[[nodiscard]] std::optional<T> TryPop()
+		{
+			uiw position, claimed;
+			if (!Claim(_dequeuePosition, 1, 1, position, claimed))
+			{
+				return std::nullopt;
+			}
+
+			std::optional<T> value = std::move(*_cells[position & _mask].Get());
+			Release(position);
+			_notFull.Notify(_mode, false);
+			return value;
+		}
+
+		// moves up to maxCount values into the output, returns how many were popped
+		[[nodiscard]] uiw TryPopBatch(T *output, uiw maxCount)
+		{
+			uiw position, claimed;
+			if (!Claim(_dequeuePosition, 1, maxCount, position, claimed))
+			{
+				return 0;
+			}
+
+			for (uiw index = 0; index < claimed; ++index)
+			{
+				output[index] = std::move(*_cells[(position + index) & _mask].Get());
+				Release(position + index);
+			}
+			_notFull.Notify(_mode, claimed > 1);
+			return claimed;
+		}
+
+		// waits for a value
+		[[nodiscard]] T Pop()
+		{
+			std::optional<T> value;
+			_notEmpty.WaitUntil(_mode, [this, &value] { value = TryPop(); return value.has_value(); }, [this] { return !IsEmptyApprox(); });
+			return std::move(*value);
+		}
+
+		// waits until there's at least one value
+		[[nodiscard]] uiw PopBatch(T *output, uiw maxCount)
+		{
+			ASSUME(maxCount > 0);
+			uiw count = 0;
+			_notEmpty.WaitUntil(_mode, [this, output, maxCount, &count] { count = TryPopBatch(output, maxCount); return count != 0; }, [this] { return !IsEmptyApprox(); });
+			return count;
+		}
+
+		[[nodiscard]] uiw Capacity() const
+		{
+			return _mask + 1;
+		}
+
+		// counts the claimed cells, so it can include the values that are still being written or read
+		[[nodiscard]] uiw SizeApprox() const
+		{
+			uiw dequeue = _dequeuePosition.load(std::memory_order_acquire);
+			uiw enqueue = _enqueuePosition.load(std::memory_order_acquire);
+			return std::min(enqueue - dequeue, _mask + 1);
+		}
+
+		[[nodiscard]] bool IsEmptyApprox() const
+		{
+			return SizeApprox() == 0;
+		}
+
+		[[nodiscard]] bool IsFullApprox() const
+		{
+			return SizeApprox() == _mask + 1;
+		}
+
+	private:
+		// a cell is ready when its sequence is position + readyOffset (0 for writing, 1 for reading),
+		// claims up to maxCount consecutive ready cells starting at the current position
+		bool Claim(std::atomic<uiw> &positionAtomic, uiw readyOffset, uiw maxCount, uiw &position, uiw &claimed)
+		{
+			position = positionAtomic.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				claimed = 0;
+				while (claimed < maxCount && claimed <= _mask)
+				{
+					uiw sequence = _cells[(position + claimed) & _mask].sequence.load(std::memory_order_acquire);
+					if (sequence != position + claimed + readyOffset)
+					{
+						break;
+					}
+					++claimed;
+				}
+
+				if (claimed == 0)
+				{
+					// either it's full/empty or another thread has claimed the position and we're behind
+					uiw current = positionAtomic.load(std::memory_order_relaxed);
+					if (current == position)
+					{
+						return false;
+					}
+					position = current;
+					continue;
+				}
+
+				if (positionAtomic.compare_exchange_weak(position, position + claimed, std::memory_order_relaxed, std::memory_order_relaxed))
+				{
+					return true;
+				}
+			}
+		}
+
+		void Release(uiw position)
+		{
+			Cell &cell = _cells[position & _mask];
+			cell.Get()->~T();
+			cell.sequence.store(position + _mask + 1, std::memory_order_release);
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+namespace StdLib
+{
+	/* Sequence lock for read-mostly data that is cheap to copy.
+	   A writer makes the sequence odd, updates the value and makes the sequence even again. A reader copies the value
+	   optimistically and retries if the sequence was odd or has changed during the copy, so readers never write shared memory
+	   and never slow each other down, the cache line stays shared between the cores until the next write.
+	   Writers are serialized by the sequence itself, they spin while another write is in progress.
+	   The value is kept as an array of atomic words, so a torn copy is never a data race, it's just discarded.
+	   Readers can be starved by a continuous stream of writes, use it only for rarely written data.
+	*/
+	template <typename T> class SeqLock
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "the value is copied while it can be modified, it must be trivially copyable");
+		static_assert(std::is_default_constructible_v<T>, "Load constructs the value before copying into it");
+
+		using wordType = uiw;
+		static constexpr uiw WordsCount = (sizeof(T) + sizeof(wordType) - 1) / sizeof(wordType);
+
+		alignas(64) std::atomic<ui32> _sequence{0};
+		std::atomic<wordType> _words[WordsCount]{};
+
+	public:
+		SeqLock() : SeqLock(T{})
+		{}
+
+		explicit SeqLock(const T &value)
+		{
+			StoreWords(value);
+		}
+
+		SeqLock(const SeqLock &) = delete;
+		SeqLock &operator = (const SeqLock &) = delete;
+
+		[[nodiscard]] T Load() const
+		{
+			for (;;)
+			{
+				if (auto value = TryLoad(); value)
+				{
+					return *value;
+				}
+				CPU_PAUSE();
+			}
+		}
+
+		// makes a single attempt, fails if a write is in progress or happens during the copy
+		[[nodiscard]] std::optional<T> TryLoad() const
+		{
+			ui32 sequence = _sequence.load(std::memory_order_acquire);
+			if (sequence & 1)
+			{
+				return std::nullopt;
+			}
+
+			T value;
+			LoadWords(value);
+
+			// the copy must not be reordered after the sequence check
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (_sequence.load(std::memory_order_relaxed) != sequence)
+			{
+				return std::nullopt;
+			}
+			return value;
+		}
+
+		void Store(const T &value)
+		{
+			ui32 sequence = BeginWrite();
+			StoreWords(value);
+			EndWrite(sequence);
+		}
+
+		// the updater receives the current value and modifies it in place, the readers see either the old value or the new one
+		template <typename Updater> void Update(Updater &&updater)
+		{
+			ui32 sequence = BeginWrite();
+			T value;
+			LoadWords(value); // no other writer can be active, so the copy is consistent
+			updater(value);
+			StoreWords(value);
+			EndWrite(sequence);
+		}
+
+		// changes with every write, an even value means no write is in progress
+		[[nodiscard]] ui32 Sequence() const
+		{
+			return _sequence.load(std::memory_order_acquire);
+		}
+
+	private:
+		ui32 BeginWrite()
+		{
+			ui32 sequence = _sequence.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				// acquire pairs with the release in the previous writer's EndWrite, so Update sees the words it has written
+				if (!(sequence & 1) && _sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					break;
+				}
+				CPU_PAUSE();
+				sequence = _sequence.load(std::memory_order_relaxed);
+			}
+			// the odd sequence must become visible before any of the new words
+			std::atomic_thread_fence(std::memory_order_release);
+			return sequence;
+		}
+
+		void EndWrite(ui32 sequence)
+		{
+			_sequence.store(sequence + 2, std::memory_order_release);
+		}
+
+		void LoadWords(T &value) const
+		{
+			wordType words[WordsCount];
+			for (uiw index = 0; index < WordsCount; ++index)
+			{
+				words[index] = _words[index].load(std::memory_order_relaxed);
+			}
+			MemOps::Copy(reinterpret_cast<std::byte *>(&value), reinterpret_cast<const std::byte *>(words), sizeof(T));
+		}
+
+		void StoreWords(const T &value)
+		{
+			wordType words[WordsCount]{};
+			MemOps::Copy(reinterpret_cast<std::byte *>(words), reinterpret_cast<const std::byte *>(&value), sizeof(T));
+			for (uiw index = 0; index < WordsCount; ++index)
+			{
+				_words[index].store(words[index], std::memory_order_relaxed);
+			}
+		}
+	};
+}
\ No newline at end of file
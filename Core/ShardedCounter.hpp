@@ -0,0 +1,139 @@
+#pragma once
+
+namespace StdLib
+{
+	/* Counters for statistics that are updated from many threads and read rarely.
+	   Each thread is assigned to one of the cache line sized shards, so updates from different cores don't fight over
+	   a single cache line, reading sums all the shards. The threads are distributed round robin, a shard shared by
+	   several threads still works correctly, it's just contended again.
+	   A read isn't a point-in-time snapshot, the updates that happen while the shards are summed may or may not be included.
+	   Note that every counter takes CounterShardsCount cache lines, group the related counters with ShardedStats.
+	*/
+	constexpr uiw CounterShardsCount = 32;
+
+	inline ui32 _CurrentThreadCounterShard()
+	{
+		static std::atomic<ui32> nextShard{0};
+		thread_local ui32 shard = nextShard.fetch_add(1, std::memory_order_relaxed) % CounterShardsCount;
+		return shard;
+	}
+
+	template <typename T = ui64> class ShardedCounter
+	{
+		static_assert(std::is_integral_v<T>);
+
+		struct alignas(64) Shard
+		{
+			std::atomic<T> value{0};
+		};
+
+		std::array<Shard, CounterShardsCount> _shards{};
+
+	public:
+		ShardedCounter() = default;
+		ShardedCounter(const ShardedCounter &) = delete;
+		ShardedCounter &operator = (const ShardedCounter &) = delete;
+
+		void Add(T value)
+		{
+			_shards[_CurrentThreadCounterShard()].value.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		void Increment()
+		{
+			Add(1);
+		}
+
+		[[nodiscard]] T Load() const
+		{
+			T sum = 0;
+			for (const Shard &shard : _shards)
+			{
+				sum += shard.value.load(std::memory_order_relaxed);
+			}
+			return sum;
+		}
+
+		// returns the sum the counter had, the concurrent updates go either to the returned sum or to the reset counter
+		T Reset()
+		{
+			T sum = 0;
+			for (Shard &shard : _shards)
+			{
+				sum += shard.value.exchange(0, std::memory_order_relaxed);
+			}
+			return sum;
+		}
+	};
+
+	// StatsT is a struct of counters that all have the type StatsT::countert, every shard holds a copy of all of them
+	template <typename StatsT> class ShardedStats
+	{
+		using countert = typename StatsT::countert;
+
+		static constexpr uiw CountersCount = sizeof(StatsT) / sizeof(countert);
+
+		static_assert(std::is_integral_v<countert>);
+		static_assert(std::is_trivially_copyable_v<StatsT> && std::is_standard_layout_v<StatsT>);
+		static_assert(sizeof(StatsT) == CountersCount * sizeof(countert), "StatsT must consist of countert fields only");
+
+		struct alignas(64) Shard
+		{
+			std::atomic<countert> counters[CountersCount]{};
+		};
+
+		std::array<Shard, CounterShardsCount> _shards{};
+
+	public:
+		ShardedStats() = default;
+		ShardedStats(const ShardedStats &) = delete;
+		ShardedStats &operator = (const ShardedStats &) = delete;
+
+		void Add(countert StatsT::*field, countert value = 1)
+		{
+			_shards[_CurrentThreadCounterShard()].counters[FieldIndex(field)].fetch_add(value, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] StatsT Load() const
+		{
+			countert sums[CountersCount]{};
+			for (const Shard &shard : _shards)
+			{
+				for (uiw index = 0; index < CountersCount; ++index)
+				{
+					sums[index] += shard.counters[index].load(std::memory_order_relaxed);
+				}
+			}
+			return ToStats(sums);
+		}
+
+		// returns the stats it had, the concurrent updates go either to the returned stats or to the reset ones
+		StatsT Reset()
+		{
+			countert sums[CountersCount]{};
+			for (Shard &shard : _shards)
+			{
+				for (uiw index = 0; index < CountersCount; ++index)
+				{
+					sums[index] += shard.counters[index].exchange(0, std::memory_order_relaxed);
+				}
+			}
+			return ToStats(sums);
+		}
+
+	private:
+		// the member pointer is a constant at the call sites, so this folds into a constant
+		static uiw FieldIndex(countert StatsT::*field)
+		{
+			StatsT probe{};
+			return static_cast<uiw>(reinterpret_cast<const std::byte *>(&(probe.*field)) - reinterpret_cast<const std::byte *>(&probe)) / sizeof(countert);
+		}
+
+		static StatsT ToStats(const countert (&sums)[CountersCount])
+		{
+			StatsT stats;
+			MemOps::Copy(reinterpret_cast<std::byte *>(&stats), reinterpret_cast<const std::byte *>(sums), sizeof(StatsT));
+			return stats;
+		}
+	};
+}
\ No newline at end of file
@@ -1,20 +1,48 @@
 #include "_PreHeader.hpp"
 #include "SpinLock.hpp"
+#include "Futex.hpp"
 
 using namespace StdLib;
 
-SpinLock::SpinLock(SpinLock &&source) noexcept
+namespace
+{
+	constexpr ui32 HybridSpinPausesLimit = 1024; // the backoff doubles the amount of pauses until it reaches this limit, then the thread goes to sleep
+}
+
+SpinLock::SpinLock(Mode mode) noexcept : _mode(mode)
+{}
+
+SpinLock::SpinLock(SpinLock &&source) noexcept : _mode(source._mode)
 {
 	ASSUME(source._users.load() == 0 && _users.load() == 0); // can't move while locked
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+	LockProfiler::NameSet(_profile, LockProfiler::NameGet(source._profile)); // the stats stay with the source
+#endif
 }
 
 SpinLock &SpinLock::operator = (SpinLock &&source) noexcept
 {
 	ASSUME(source._users.load() == 0); // can't move while locked
 	_users.store(0);
+	_mode = source._mode;
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+	LockProfiler::NameSet(_profile, LockProfiler::NameGet(source._profile));
+#endif
 	return *this;
 }
 
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+SpinLock::~SpinLock()
+{
+	LockProfiler::Unregister(_profile);
+}
+#endif
+
+auto SpinLock::LockMode() const -> Mode
+{
+	return _mode;
+}
+
 auto SpinLock::Lock() const -> Unlocker
 {
 	lock();
@@ -37,6 +65,15 @@ void SpinLock::Unlock() const
 
 void SpinLock::lock() const
 {
+	auto acquisition = ProfileAcquisition();
+
+	if (_mode == Mode::Hybrid)
+	{
+		LockHybrid(acquisition);
+		acquisition.Acquired();
+		return;
+	}
+
 	for (;;)
 	{
 		atomicType oldLock = 0;
@@ -44,17 +81,72 @@ void SpinLock::lock() const
 		{
 			break;
 		}
+		acquisition.Failed();
+		CPU_PAUSE();
+	}
+	acquisition.Acquired();
+}
+
+// based on Ulrich Drepper's "Futexes Are Tricky", mutex 2
+void SpinLock::LockHybrid(LockProfiler::Acquisition &acquisition) const
+{
+	atomicType state = 0;
+	if (_users.compare_exchange_strong(state, 1, std::memory_order_acquire))
+	{
+		return;
+	}
+
+	for (ui32 pauses = 1; pauses <= HybridSpinPausesLimit; pauses *= 2)
+	{
+		acquisition.Failed();
+		for (ui32 index = 0; index < pauses; ++index)
+		{
+			CPU_PAUSE();
+		}
+		state = _users.load(std::memory_order_relaxed);
+		if (state == 0 && _users.compare_exchange_weak(state, 1, std::memory_order_acquire))
+		{
+			return;
+		}
+	}
+
+	// the lock is acquired with state 2 because there's no way to tell whether other threads are sleeping
+	if (state != 2)
+	{
+		state = _users.exchange(2, std::memory_order_acquire);
+	}
+	while (state != 0)
+	{
+		acquisition.Failed();
+		Futex::Wait(_users, 2);
+		state = _users.exchange(2, std::memory_order_acquire);
 	}
 }
 
 bool SpinLock::try_lock() const
 {
 	atomicType oldLock = 0;
-	return _users.compare_exchange_strong(oldLock, 1, std::memory_order_acquire);
+	if (_users.compare_exchange_strong(oldLock, 1, std::memory_order_acquire))
+	{
+		ProfileAcquisition().Acquired();
+		return true;
+	}
+	return false;
 }
 
 void SpinLock::unlock() const
 {
+	if (_mode == Mode::Hybrid)
+	{
+		atomicType state = _users.exchange(0, std::memory_order_release);
+		ASSUME(state == 1 || state == 2);
+		if (state == 2)
+		{
+			Futex::WakeOne(_users);
+		}
+		return;
+	}
+
 	ASSUME(_users.load() == 1);
 	_users.store(0, std::memory_order_release);
 }
@@ -1,14 +1,32 @@
 #pragma once
 
+#include "LockProfiler.hpp"
+
 namespace StdLib
 {
 	class SpinLock
 	{
 		friend class Unlocker;
 
+	public:
+		// Spin: waiters spin until the lock is released, the lowest latency if the lock is held for a very short time
+		// Hybrid: waiters spin with an exponential backoff for a while, then sleep on a futex until the lock is released,
+		// use it if there can be more threads than cores, a descheduled owner makes spinning waiters burn their time slices
+		enum class Mode : ui8
+		{
+			Spin,
+			Hybrid
+		};
+
+	private:
 		using atomicType = ui32;
 
+		// 0 - unlocked, 1 - locked, 2 - locked and there might be sleeping waiters (used only by the hybrid mode)
 		alignas(64) mutable std::atomic<atomicType> _users{0};
+		Mode _mode = Mode::Spin;
+	#ifdef STDLIB_ENABLE_LOCK_PROFILING
+		LockProfiler::Record *_profile = LockProfiler::Register(this);
+	#endif
 
 	public:
 		class Unlocker
@@ -27,17 +45,47 @@ namespace StdLib
 		};
 
 		SpinLock() noexcept = default;
+		explicit SpinLock(Mode mode) noexcept;
 		SpinLock(SpinLock &&source) noexcept;
 		SpinLock &operator = (SpinLock &&source) noexcept;
+	#ifdef STDLIB_ENABLE_LOCK_PROFILING
+		~SpinLock();
+	#endif
 
 		[[nodiscard]] Unlocker Lock() const;
 		[[nodiscard]] std::optional<Unlocker> TryLock() const;
+		[[nodiscard]] Mode LockMode() const;
 
 		void lock() const;
 		[[nodiscard]] bool try_lock() const;
 		void unlock() const;
 
+		// the name the lock is reported with by LockProfiler, does nothing if the profiling is disabled
+		void ProfilingNameSet([[maybe_unused]] std::string_view name)
+		{
+		#ifdef STDLIB_ENABLE_LOCK_PROFILING
+			LockProfiler::NameSet(_profile, name);
+		#endif
+		}
+
+	#ifdef STDLIB_ENABLE_LOCK_PROFILING
+		[[nodiscard]] LockProfiler::Stats ProfilingStatsGet() const
+		{
+			return _profile->StatsGet();
+		}
+	#endif
+
 	private:
+		[[nodiscard]] LockProfiler::Acquisition ProfileAcquisition() const
+		{
+		#ifdef STDLIB_ENABLE_LOCK_PROFILING
+			return LockProfiler::Acquisition(_profile);
+		#else
+			return {};
+		#endif
+		}
+
 		void Unlock() const;
+		void LockHybrid(LockProfiler::Acquisition &acquisition) const;
 	};
 }
\ No newline at end of file
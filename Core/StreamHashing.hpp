@@ -0,0 +1,61 @@
+#pragma once
+
+#include "HashFuncs.hpp"
+#include "IFile.hpp"
+#include "IMemoryStream.hpp"
+
+namespace StdLib::Hash
+{
+	// feeds the file's content from its current offset to the end into the hasher, only a small stack buffer is used
+	// so the file doesn't have to fit in memory, returns false if a read had failed, the hasher contains
+	// everything that was read before the failure in that case
+	template <typename Hasher> [[nodiscard]] bool UpdateFromFile(Hasher &hasher, IFile &file)
+	{
+		ASSUME(file.IsOpen() && file.ProcMode().Contains(FileProcModes::Read));
+
+		std::array<std::byte, 16384> chunk;
+		for (;;)
+		{
+			ui32 read = 0;
+			if (!file.Read(chunk.data(), static_cast<ui32>(chunk.size()), &read))
+			{
+				return false;
+			}
+			hasher.Update(chunk.data(), read);
+			if (read < chunk.size())
+			{
+				return true;
+			}
+		}
+	}
+
+	// the stream's content is already in memory, but its size is 64 bit, so it is passed in uiw sized pieces
+	template <typename Hasher> void UpdateFromMemoryStream(Hasher &hasher, const IMemoryStream &stream)
+	{
+		ASSUME(stream.IsReadable());
+
+		const std::byte *memory = stream.CMemory();
+		for (ui64 left = stream.Size(); left; )
+		{
+			uiw piece = static_cast<uiw>(std::min<ui64>(left, uiw_max));
+			hasher.Update(memory, piece);
+			memory += piece;
+			left -= piece;
+		}
+	}
+
+	template <typename Hasher> [[nodiscard]] std::optional<decltype(std::declval<Hasher>().Finish())> HashFile(IFile &file, Hasher hasher = {})
+	{
+		if (!UpdateFromFile(hasher, file))
+		{
+			return {};
+		}
+		return hasher.Finish();
+	}
+
+	template <typename Hasher> [[nodiscard]] auto HashMemoryStream(const IMemoryStream &stream, Hasher hasher = {})
+	{
+		UpdateFromMemoryStream(hasher, stream);
+		return hasher.Finish();
+	}
+}
\ No newline at end of file
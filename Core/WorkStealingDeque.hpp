@@ -0,0 +1,145 @@
+#pragma once
+
+namespace StdLib
+{
+	/* Chase-Lev work stealing deque (with the memory orders from "Correct and Efficient Work-Stealing for Weak Memory Models").
+	   The owner thread pushes and pops at the bottom in LIFO order, any other thread can steal from the top in FIFO order.
+	   The buffer grows when it gets full, retired buffers are kept until the deque is destroyed
+	   because a thief might still be reading from them.
+	   T must be trivially copyable, usually it's a pointer to the actual work item.
+	*/
+	template <typename T> class WorkStealingDeque
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+		struct Buffer
+		{
+			iw mask;
+			std::unique_ptr<std::atomic<T>[]> items;
+
+			explicit Buffer(iw capacity) : mask(capacity - 1), items(new std::atomic<T>[static_cast<uiw>(capacity)])
+			{}
+
+			[[nodiscard]] iw Capacity() const
+			{
+				return mask + 1;
+			}
+
+			[[nodiscard]] T Get(iw index) const
+			{
+				return items[static_cast<uiw>(index & mask)].load(std::memory_order_relaxed);
+			}
+
+			void Put(iw index, T item)
+			{
+				items[static_cast<uiw>(index & mask)].store(item, std::memory_order_relaxed);
+			}
+		};
+
+		alignas(64) std::atomic<iw> _top{0};
+		alignas(64) std::atomic<iw> _bottom{0};
+		std::atomic<Buffer *> _buffer{};
+		std::vector<std::unique_ptr<Buffer>> _buffers{}; // the current one is the last, accessed only by the owner
+
+	public:
+		explicit WorkStealingDeque(uiw initialCapacity = 256)
+		{
+			ASSUME(initialCapacity > 0 && (initialCapacity & (initialCapacity - 1)) == 0);
+			_buffers.emplace_back(std::make_unique<Buffer>(static_cast<iw>(initialCapacity)));
+			_buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+		}
+
+		WorkStealingDeque(const WorkStealingDeque &) = delete;
+		WorkStealingDeque &operator = (const WorkStealingDeque &) = delete;
+
+		// owner only
+		void Push(T item)
+		{
+			iw bottom = _bottom.load(std::memory_order_relaxed);
+			iw top = _top.load(std::memory_order_acquire);
+			Buffer *buffer = _buffer.load(std::memory_order_relaxed);
+			if (bottom - top > buffer->Capacity() - 1)
+			{
+				buffer = Grow(buffer, bottom, top);
+			}
+			buffer->Put(bottom, item);
+			std::atomic_thread_fence(std::memory_order_release);
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		// owner only, returns the most recently pushed item
+		[[nodiscard]] std::optional<T> Pop()
+		{
+			iw bottom = _bottom.load(std::memory_order_relaxed) - 1;
+			Buffer *buffer = _buffer.load(std::memory_order_relaxed);
+			_bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			iw top = _top.load(std::memory_order_relaxed);
+
+			if (top > bottom) // empty
+			{
+				_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return std::nullopt;
+			}
+
+			T item = buffer->Get(bottom);
+			if (top == bottom) // the last item, a thief might be trying to take it too
+			{
+				bool isWon = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				_bottom.store(bottom + 1, std::memory_order_relaxed);
+				if (!isWon)
+				{
+					return std::nullopt;
+				}
+			}
+			return item;
+		}
+
+		// any thread, returns the oldest item, can also fail if another thread took the item at the same time
+		[[nodiscard]] std::optional<T> Steal()
+		{
+			iw top = _top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			iw bottom = _bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+			{
+				return std::nullopt;
+			}
+
+			T item = _buffer.load(std::memory_order_acquire)->Get(top);
+			if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return std::nullopt;
+			}
+			return item;
+		}
+
+		// can be stale by the time it returns if other threads use the deque
+		[[nodiscard]] uiw SizeApprox() const
+		{
+			iw bottom = _bottom.load(std::memory_order_relaxed);
+			iw top = _top.load(std::memory_order_relaxed);
+			return bottom > top ? static_cast<uiw>(bottom - top) : 0;
+		}
+
+		[[nodiscard]] bool IsEmptyApprox() const
+		{
+			return SizeApprox() == 0;
+		}
+
+	private:
+		Buffer *Grow(Buffer *current, iw bottom, iw top)
+		{
+			auto grown = std::make_unique<Buffer>(current->Capacity() * 2);
+			for (iw index = top; index < bottom; ++index)
+			{
+				grown->Put(index, current->Get(index));
+			}
+			Buffer *result = grown.get();
+			_buffers.emplace_back(std::move(grown));
+			_buffer.store(result, std::memory_order_release);
+			return result;
+		}
+	};
+}
\ No newline at end of file
@@ -51,7 +51,35 @@ template <typename T> NOINLINE void UniqueIdManager::AllocateLevel(T &level)
 	{
 		level.level = make_unique<array<ui64, 64>>();
 		level.level->fill(ui64_max);
+		++_emptyBlocksCount;
 	}
+	_levelsMemory += sizeof(*level.level);
+}
+
+// the allocatedMask bits are set from the lowest level up, a set bit means the levels above are already marked
+void UniqueIdManager::MarkAllocated(ui32 level0Index, Level1 &level1, ui32 level1Index, Level2 &level2, ui32 level2Index, Level3 &level3, ui32 level3Index, ui32 level4Index)
+{
+    if (Funcs::IsBitSet(level3.allocatedMask, level4Index))
+    {
+        return;
+    }
+    if (level3.allocatedMask == 0)
+    {
+        ASSUME(_emptyBlocksCount > 0);
+        --_emptyBlocksCount;
+    }
+    level3.allocatedMask = Funcs::SetBit(level3.allocatedMask, level4Index, true);
+    if (Funcs::IsBitSet(level2.allocatedMask, level3Index))
+    {
+        return;
+    }
+    level2.allocatedMask = Funcs::SetBit(level2.allocatedMask, level3Index, true);
+    if (Funcs::IsBitSet(level1.allocatedMask, level2Index))
+    {
+        return;
+    }
+    level1.allocatedMask = Funcs::SetBit(level1.allocatedMask, level2Index, true);
+    _level0AllocatedMasks[level0Index] = Funcs::SetBit(_level0AllocatedMasks[level0Index], level1Index, true);
 }
 
 ui32 UniqueIdManager::Allocate()
@@ -121,6 +149,8 @@ ui32 UniqueIdManager::Allocate()
             }
         }
 
+        MarkAllocated(static_cast<ui32>(level0Index), level1, static_cast<ui32>(level1Index), level2, static_cast<ui32>(level2Index), level3, static_cast<ui32>(level3Index), static_cast<ui32>(level4Index));
+
         return static_cast<ui32>(id);
     }
 
@@ -175,6 +205,7 @@ bool UniqueIdManager::Allocate(ui32 id)
             }
         }
     }
+    MarkAllocated(level0Index, level1, level1Index, level2, level2Index, level3, level3Index, level4Index);
     return true;
 }
 
@@ -225,6 +256,26 @@ bool UniqueIdManager::Free(ui32 id)
                 }
             }
         }
+
+        level3.allocatedMask = Funcs::SetBit(level3.allocatedMask, level4Index, false);
+        if (level3.allocatedMask == 0)
+        {
+            ++_emptyBlocksCount;
+            level2.allocatedMask = Funcs::SetBit(level2.allocatedMask, level3Index, false);
+            if (level2.allocatedMask == 0)
+            {
+                level1.allocatedMask = Funcs::SetBit(level1.allocatedMask, level2Index, false);
+                if (level1.allocatedMask == 0)
+                {
+                    _level0AllocatedMasks[level0Index] = Funcs::SetBit(_level0AllocatedMasks[level0Index], level1Index, false);
+                }
+            }
+
+            if (_autoShrinkThreshold && _emptyBlocksCount > *_autoShrinkThreshold)
+            {
+                ShrinkToFit();
+            }
+        }
     }
     return true;
 }
@@ -256,4 +307,435 @@ bool StdLib::UniqueIdManager::IsAllocated(ui32 id) const
     ui64 level4 = level3.level->operator[](level4Index);
     ui32 level5Index = IDToLevelIndex<5>(id);
     return Funcs::IsBitSet(level4, level5Index) == false;
-}
\ No newline at end of file
+}
+
+// a level is entirely free when its bit in the allocatedMask of the level above is clear
+void UniqueIdManager::ShrinkToFit()
+{
+    for (array<Level1, 64> &level0Levels : _level0Levels)
+    {
+        for (Level1 &level1 : level0Levels)
+        {
+            if (level1.level == nullptr)
+            {
+                continue;
+            }
+            for (Level2 &level2 : *level1.level)
+            {
+                if (level2.level == nullptr)
+                {
+                    continue;
+                }
+                for (Level3 &level3 : *level2.level)
+                {
+                    if (level3.level != nullptr && level3.allocatedMask == 0)
+                    {
+                        ASSUME(level3.mask == ui64_max);
+                        level3.level.reset();
+                        _levelsMemory -= sizeof(array<ui64, 64>);
+                    }
+                }
+                if (level2.allocatedMask == 0)
+                {
+                    level2.level.reset();
+                    _levelsMemory -= sizeof(array<Level3, 64>);
+                }
+            }
+            if (level1.allocatedMask == 0)
+            {
+                level1.level.reset();
+                _levelsMemory -= sizeof(array<Level2, 64>);
+            }
+        }
+    }
+    _emptyBlocksCount = 0;
+}
+
+void UniqueIdManager::AutoShrinkSet(std::optional<ui32> emptyBlocksThreshold)
+{
+    _autoShrinkThreshold = emptyBlocksThreshold;
+    if (_autoShrinkThreshold && _emptyBlocksCount > *_autoShrinkThreshold)
+    {
+        ShrinkToFit();
+    }
+}
+
+uiw UniqueIdManager::MemoryUsage() const
+{
+    return sizeof(*this) + _levelsMemory;
+}
+
+// every step either finds the level that contains the next allocated id or skips the rest of the current level
+ui64 UniqueIdManager::NextAllocated(ui64 from) const
+{
+    constexpr ui64 level1Size = 64 * 64 * 64 * 64, level2Size = 64 * 64 * 64, level3Size = 64 * 64, level4Size = 64;
+
+    ui64 id = from;
+    while (id < Iterator::endId)
+    {
+        ui32 id32 = static_cast<ui32>(id);
+        ui32 level0Index = IDToLevelIndex<0>(id32);
+        ui64 mask = _level0AllocatedMasks[level0Index] & (ui64_max << IDToLevelIndex<1>(id32));
+        if (mask == 0)
+        {
+            id = (level0Index + 1) * level1Size * 64;
+            continue;
+        }
+        ui32 level1Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(mask));
+        if (level1Index != IDToLevelIndex<1>(id32))
+        {
+            id = (level0Index * 64 + level1Index) * level1Size;
+            id32 = static_cast<ui32>(id);
+        }
+
+        const Level1 &level1 = _level0Levels[level0Index][level1Index];
+        mask = level1.allocatedMask & (ui64_max << IDToLevelIndex<2>(id32));
+        if (mask == 0)
+        {
+            id = (id / level1Size + 1) * level1Size;
+            continue;
+        }
+        ui32 level2Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(mask));
+        if (level2Index != IDToLevelIndex<2>(id32))
+        {
+            id = id / level1Size * level1Size + level2Index * level2Size;
+            id32 = static_cast<ui32>(id);
+        }
+
+        const Level2 &level2 = level1.level->operator[](level2Index);
+        mask = level2.allocatedMask & (ui64_max << IDToLevelIndex<3>(id32));
+        if (mask == 0)
+        {
+            id = (id / level2Size + 1) * level2Size;
+            continue;
+        }
+        ui32 level3Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(mask));
+        if (level3Index != IDToLevelIndex<3>(id32))
+        {
+            id = id / level2Size * level2Size + level3Index * level3Size;
+            id32 = static_cast<ui32>(id);
+        }
+
+        const Level3 &level3 = level2.level->operator[](level3Index);
+        mask = level3.allocatedMask & (ui64_max << IDToLevelIndex<4>(id32));
+        if (mask == 0)
+        {
+            id = (id / level3Size + 1) * level3Size;
+            continue;
+        }
+        ui32 level4Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(mask));
+        if (level4Index != IDToLevelIndex<4>(id32))
+        {
+            id = id / level3Size * level3Size + level4Index * level4Size;
+            id32 = static_cast<ui32>(id);
+        }
+
+        ui64 allocated = ~level3.level->operator[](level4Index) & (ui64_max << IDToLevelIndex<5>(id32));
+        if (allocated == 0)
+        {
+            id = (id / level4Size + 1) * level4Size;
+            continue;
+        }
+        return id / level4Size * level4Size + Funcs::IndexOfLeastSignificantNonZeroBit(allocated);
+    }
+    return Iterator::endId;
+}
+
+namespace
+{
+    // masks[0] is a level 0 mask, masks[4] is a word of a Level4, bits[depth] is the bit that represents masks[depth] in masks[depth - 1]
+    struct MaskPath
+    {
+        std::atomic<ui64> *masks[5];
+        ui32 bits[5];
+    };
+
+    // masks[depth] has become non-zero, marks it as having free ids in the levels above
+    void PropagateFree(const MaskPath &path, ui32 depth)
+    {
+        for (; depth > 0; --depth)
+        {
+            ui64 previous = path.masks[depth - 1]->fetch_or(1ULL << path.bits[depth]);
+            if (previous != 0)
+            {
+                break; // the levels above already know about this one
+            }
+        }
+    }
+
+    // masks[depth] has been seen as zero, marks it as full in the levels above
+    void PropagateFull(const MaskPath &path, ui32 depth)
+    {
+        for (; depth > 0; --depth)
+        {
+            ui64 bit = 1ULL << path.bits[depth];
+            ui64 previous = path.masks[depth - 1]->fetch_and(~bit);
+            if (path.masks[depth]->load() != 0)
+            {
+                // an id has been freed meanwhile, its Free could've seen the bit still set and skipped updating the level above
+                PropagateFree(path, depth);
+                return;
+            }
+            if ((previous & ~bit) != 0)
+            {
+                return;
+            }
+        }
+    }
+}
+
+template <typename T> auto ConcurrentUniqueIdManager::LevelAcquire(T &level)
+{
+    auto *current = level.level.load(std::memory_order_acquire);
+    if (current != nullptr)
+    {
+        return current;
+    }
+
+    auto *created = new std::remove_pointer_t<decltype(current)>;
+    if constexpr (std::is_same_v<T, Level3>)
+    {
+        for (std::atomic<ui64> &word : *created)
+        {
+            word.store(ui64_max, std::memory_order_relaxed);
+        }
+    }
+    if (level.level.compare_exchange_strong(current, created, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        return created;
+    }
+    delete created; // another thread has allocated the level first
+    return current;
+}
+
+ConcurrentUniqueIdManager::~ConcurrentUniqueIdManager()
+{
+    for (array<Level1, 64> &level0Levels : _level0Levels)
+    {
+        for (Level1 &level1 : level0Levels)
+        {
+            array<Level2, 64> *level2s = level1.level.load(std::memory_order_acquire);
+            if (level2s == nullptr)
+            {
+                continue;
+            }
+            for (Level2 &level2 : *level2s)
+            {
+                array<Level3, 64> *level3s = level2.level.load(std::memory_order_acquire);
+                if (level3s == nullptr)
+                {
+                    continue;
+                }
+                for (Level3 &level3 : *level3s)
+                {
+                    delete level3.level.load(std::memory_order_acquire);
+                }
+                delete level3s;
+            }
+            delete level2s;
+        }
+    }
+}
+
+std::optional<ui32> ConcurrentUniqueIdManager::AllocateFrom(ui32 level0Index)
+{
+    MaskPath path;
+    path.masks[0] = &_level0Masks[level0Index];
+    uiw id = level0Index * (64 * 64 * 64 * 64 * 64);
+
+    ui64 level0Mask = path.masks[0]->load();
+    if (level0Mask == 0)
+    {
+        return std::nullopt;
+    }
+    ui32 level1Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(level0Mask));
+    Level1 &level1 = _level0Levels[level0Index][level1Index];
+    path.masks[1] = &level1.mask;
+    path.bits[1] = level1Index;
+    id += level1Index * (64 * 64 * 64 * 64);
+
+    ui64 level1Mask = level1.mask.load();
+    if (level1Mask == 0)
+    {
+        PropagateFull(path, 1);
+        return std::nullopt;
+    }
+    ui32 level2Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(level1Mask));
+    Level2 &level2 = LevelAcquire(level1)->operator[](level2Index);
+    path.masks[2] = &level2.mask;
+    path.bits[2] = level2Index;
+    id += level2Index * (64 * 64 * 64);
+
+    ui64 level2Mask = level2.mask.load();
+    if (level2Mask == 0)
+    {
+        PropagateFull(path, 2);
+        return std::nullopt;
+    }
+    ui32 level3Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(level2Mask));
+    Level3 &level3 = LevelAcquire(level2)->operator[](level3Index);
+    path.masks[3] = &level3.mask;
+    path.bits[3] = level3Index;
+    id += level3Index * (64 * 64);
+
+    ui64 level3Mask = level3.mask.load();
+    if (level3Mask == 0)
+    {
+        PropagateFull(path, 3);
+        return std::nullopt;
+    }
+    ui32 level4Index = static_cast<ui32>(Funcs::IndexOfLeastSignificantNonZeroBit(level3Mask));
+    std::atomic<ui64> &level4 = LevelAcquire(level3)->operator[](level4Index);
+    path.masks[4] = &level4;
+    path.bits[4] = level4Index;
+    id += level4Index * 64;
+
+    ui64 word = level4.load();
+    while (word != 0)
+    {
+        uiw level5Index = Funcs::IndexOfLeastSignificantNonZeroBit(word);
+        ui64 claimed = Funcs::SetBit(word, level5Index, false);
+        if (level4.compare_exchange_weak(word, claimed))
+        {
+            if (claimed == 0)
+            {
+                PropagateFull(path, 4);
+            }
+            return static_cast<ui32>(id + level5Index);
+        }
+    }
+    PropagateFull(path, 4); // other threads have claimed the rest of the word
+    return std::nullopt;
+}
+
+ui32 ConcurrentUniqueIdManager::Allocate()
+{
+    for (;;)
+    {
+        ui32 level0Index = 0;
+        while (level0Index < 4 && _level0Masks[level0Index].load() == 0)
+        {
+            ++level0Index;
+        }
+        if (level0Index == 4)
+        {
+            return invalidId;
+        }
+        if (auto id = AllocateFrom(level0Index))
+        {
+            return *id;
+        }
+    }
+}
+
+bool ConcurrentUniqueIdManager::Allocate(ui32 id)
+{
+    ASSUME(id != invalidId);
+    MaskPath path;
+    ui32 level0Index = IDToLevelIndex<0>(id);
+    path.masks[0] = &_level0Masks[level0Index];
+    ui32 level1Index = IDToLevelIndex<1>(id);
+    Level1 &level1 = _level0Levels[level0Index][level1Index];
+    path.masks[1] = &level1.mask;
+    path.bits[1] = level1Index;
+    ui32 level2Index = IDToLevelIndex<2>(id);
+    Level2 &level2 = LevelAcquire(level1)->operator[](level2Index);
+    path.masks[2] = &level2.mask;
+    path.bits[2] = level2Index;
+    ui32 level3Index = IDToLevelIndex<3>(id);
+    Level3 &level3 = LevelAcquire(level2)->operator[](level3Index);
+    path.masks[3] = &level3.mask;
+    path.bits[3] = level3Index;
+    ui32 level4Index = IDToLevelIndex<4>(id);
+    std::atomic<ui64> &level4 = LevelAcquire(level3)->operator[](level4Index);
+    path.masks[4] = &level4;
+    path.bits[4] = level4Index;
+
+    ui64 bit = 1ULL << IDToLevelIndex<5>(id);
+    ui64 previous = level4.fetch_and(~bit);
+    if ((previous & bit) == 0)
+    {
+        return false;
+    }
+    if ((previous & ~bit) == 0)
+    {
+        PropagateFull(path, 4);
+    }
+    return true;
+}
+
+bool ConcurrentUniqueIdManager::Free(ui32 id)
+{
+    ASSUME(id != invalidId);
+    MaskPath path;
+    ui32 level0Index = IDToLevelIndex<0>(id);
+    path.masks[0] = &_level0Masks[level0Index];
+    ui32 level1Index = IDToLevelIndex<1>(id);
+    Level1 &level1 = _level0Levels[level0Index][level1Index];
+    path.masks[1] = &level1.mask;
+    path.bits[1] = level1Index;
+    array<Level2, 64> *level2s = level1.level.load(std::memory_order_acquire);
+    if (level2s == nullptr)
+    {
+        return false;
+    }
+    ui32 level2Index = IDToLevelIndex<2>(id);
+    Level2 &level2 = level2s->operator[](level2Index);
+    path.masks[2] = &level2.mask;
+    path.bits[2] = level2Index;
+    array<Level3, 64> *level3s = level2.level.load(std::memory_order_acquire);
+    if (level3s == nullptr)
+    {
+        return false;
+    }
+    ui32 level3Index = IDToLevelIndex<3>(id);
+    Level3 &level3 = level3s->operator[](level3Index);
+    path.masks[3] = &level3.mask;
+    path.bits[3] = level3Index;
+    Level4 *level4s = level3.level.load(std::memory_order_acquire);
+    if (level4s == nullptr)
+    {
+        return false;
+    }
+    ui32 level4Index = IDToLevelIndex<4>(id);
+    std::atomic<ui64> &level4 = level4s->operator[](level4Index);
+    path.masks[4] = &level4;
+    path.bits[4] = level4Index;
+
+    ui64 bit = 1ULL << IDToLevelIndex<5>(id);
+    ui64 previous = level4.fetch_or(bit);
+    if (previous & bit)
+    {
+        return false;
+    }
+    if (previous == 0)
+    {
+        PropagateFree(path, 4);
+    }
+    return true;
+}
+
+bool ConcurrentUniqueIdManager::IsAllocated(ui32 id) const
+{
+    ASSUME(id != invalidId);
+    const Level1 &level1 = _level0Levels[IDToLevelIndex<0>(id)][IDToLevelIndex<1>(id)];
+    const array<Level2, 64> *level2s = level1.level.load(std::memory_order_acquire);
+    if (level2s == nullptr)
+    {
+        return false;
+    }
+    const Level2 &level2 = level2s->operator[](IDToLevelIndex<2>(id));
+    const array<Level3, 64> *level3s = level2.level.load(std::memory_order_acquire);
+    if (level3s == nullptr)
+    {
+        return false;
+    }
+    const Level3 &level3 = level3s->operator[](IDToLevelIndex<3>(id));
+    const Level4 *level4s = level3.level.load(std::memory_order_acquire);
+    if (level4s == nullptr)
+    {
+        return false;
+    }
+    ui64 level4 = level4s->operator[](IDToLevelIndex<4>(id)).load(std::memory_order_acquire);
+    return Funcs::IsBitSet(level4, IDToLevelIndex<5>(id)) == false;
+}
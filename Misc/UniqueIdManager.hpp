@@ -2,39 +2,201 @@
 
 namespace StdLib
 {
+    // mask bits are set for the levels that have free ids, allocatedMask bits are set for the levels that have allocated ids,
+    // the latter are used to skip the free parts of the id space when enumerating the allocated ids
     class UniqueIdManager
     {
         struct Level3
         {
             ui64 mask = ui64_max;
+            ui64 allocatedMask = 0;
             std::unique_ptr<std::array<ui64, 64>> level{};
         };
 
         struct Level2
         {
             ui64 mask = ui64_max;
+            ui64 allocatedMask = 0;
             std::unique_ptr<std::array<Level3, 64>> level{};
         };
 
         struct Level1
         {
             ui64 mask = ui64_max;
+            ui64 allocatedMask = 0;
             std::unique_ptr<std::array<Level2, 64>> level{};
         };
 
         std::array<ui64, 4> _level0Masks{ui64_max, ui64_max, ui64_max, ui64_max};
+        std::array<ui64, 4> _level0AllocatedMasks{};
         std::array<std::array<Level1, 64>, 4> _level0Levels{};
+        uiw _levelsMemory = 0; // bytes used by the allocated levels
+        ui32 _emptyBlocksCount = 0; // allocated Level3 words that have no allocated ids
+        std::optional<ui32> _autoShrinkThreshold{};
 
 		template <typename T> NOINLINE void AllocateLevel(T &level);
+        void MarkAllocated(ui32 level0Index, Level1 &level1, ui32 level1Index, Level2 &level2, ui32 level2Index, Level3 &level3, ui32 level3Index, ui32 level4Index);
 
     public:
         static constexpr ui32 invalidId = ui32_max;
 
+        // visits the allocated ids in ascending order
+        // the manager is only read, so the ids can be freed during the iteration, the ids allocated ahead of the iterator may or may not be visited
+        class Iterator
+        {
+            friend UniqueIdManager;
+
+            static constexpr ui64 endId = 4ULL * 64 * 64 * 64 * 64 * 64;
+
+            const UniqueIdManager *_manager = nullptr;
+            ui64 _id = endId;
+
+            Iterator(const UniqueIdManager *manager, ui64 id) : _manager(manager), _id(manager->NextAllocated(id))
+            {}
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = ui32;
+            using difference_type = i64;
+            using pointer = const ui32 *;
+            using reference = ui32;
+
+            Iterator() = default;
+
+            [[nodiscard]] ui32 operator * () const
+            {
+                ASSUME(_id < endId);
+                return static_cast<ui32>(_id);
+            }
+
+            Iterator &operator ++ ()
+            {
+                ASSUME(_id < endId);
+                _id = _manager->NextAllocated(_id + 1);
+                return *this;
+            }
+
+            Iterator operator ++ (int)
+            {
+                Iterator copy = *this;
+                operator ++ ();
+                return copy;
+            }
+
+            [[nodiscard]] bool operator == (const Iterator &other) const
+            {
+                return _id == other._id;
+            }
+
+            [[nodiscard]] bool operator != (const Iterator &other) const
+            {
+                return _id != other._id;
+            }
+        };
+
+        [[nodiscard]] ui32 Allocate();
+        [[nodiscard]] bool Allocate(ui32 id);
+        bool Free(ui32 id);
+        [[nodiscard]] bool IsAllocated(ui32 id) const;
+
+        // releases the levels that have no allocated ids, they'll be allocated again when they're needed
+        void ShrinkToFit();
+        // when freeing makes more than emptyBlocksThreshold blocks of 4096 ids entirely free, ShrinkToFit is called,
+        // the blocks that become free below the threshold are kept, so allocating and freeing around a block's boundary
+        // doesn't allocate and release it every time, nullopt disables the automatic release, which is the default
+        void AutoShrinkSet(std::optional<ui32> emptyBlocksThreshold);
+        // the size of the manager including the allocated levels
+        [[nodiscard]] uiw MemoryUsage() const;
+
+        // the cost depends on the number of allocated ids and the masks that have to be looked at, not on the size of the id space
+        [[nodiscard]] Iterator begin() const
+        {
+            return {this, 0};
+        }
+
+        [[nodiscard]] Iterator end() const
+        {
+            return {};
+        }
+
+        // same as iterating, but faster, func is called with every allocated id in ascending order, the manager must not be modified by func
+        template <typename F> void ForEachAllocated(F &&func) const
+        {
+            for (uiw level0Index = 0; level0Index < 4; ++level0Index)
+            {
+                for (ui64 mask0 = _level0AllocatedMasks[level0Index]; mask0; mask0 &= mask0 - 1)
+                {
+                    uiw level1Index = Funcs::IndexOfLeastSignificantNonZeroBit(mask0);
+                    const Level1 &level1 = _level0Levels[level0Index][level1Index];
+                    for (ui64 mask1 = level1.allocatedMask; mask1; mask1 &= mask1 - 1)
+                    {
+                        uiw level2Index = Funcs::IndexOfLeastSignificantNonZeroBit(mask1);
+                        const Level2 &level2 = level1.level->operator[](level2Index);
+                        for (ui64 mask2 = level2.allocatedMask; mask2; mask2 &= mask2 - 1)
+                        {
+                            uiw level3Index = Funcs::IndexOfLeastSignificantNonZeroBit(mask2);
+                            const Level3 &level3 = level2.level->operator[](level3Index);
+                            uiw base = (((level0Index * 64 + level1Index) * 64 + level2Index) * 64 + level3Index) * 64 * 64;
+                            for (ui64 mask3 = level3.allocatedMask; mask3; mask3 &= mask3 - 1)
+                            {
+                                uiw level4Index = Funcs::IndexOfLeastSignificantNonZeroBit(mask3);
+                                for (ui64 allocated = ~level3.level->operator[](level4Index); allocated; allocated &= allocated - 1)
+                                {
+                                    func(static_cast<ui32>(base + level4Index * 64 + Funcs::IndexOfLeastSignificantNonZeroBit(allocated)));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        [[nodiscard]] ui64 NextAllocated(ui64 from) const; // Iterator::endId if there are no allocated ids starting from the specified one
+    };
+
+    // same as UniqueIdManager, but every method can be called from multiple threads without locking,
+    // the levels are never released until the manager is destroyed, so there's no ShrinkToFit,
+    // Allocate can return invalidId while the last free ids are being claimed and released by other threads
+    class ConcurrentUniqueIdManager
+    {
+        using Level4 = std::array<std::atomic<ui64>, 64>;
+
+        struct Level3
+        {
+            std::atomic<ui64> mask{ui64_max};
+            std::atomic<Level4 *> level{nullptr};
+        };
+
+        struct Level2
+        {
+            std::atomic<ui64> mask{ui64_max};
+            std::atomic<std::array<Level3, 64> *> level{nullptr};
+        };
+
+        struct Level1
+        {
+            std::atomic<ui64> mask{ui64_max};
+            std::atomic<std::array<Level2, 64> *> level{nullptr};
+        };
+
+        std::array<std::atomic<ui64>, 4> _level0Masks{ui64_max, ui64_max, ui64_max, ui64_max};
+        std::array<std::array<Level1, 64>, 4> _level0Levels{};
+
+        template <typename T> [[nodiscard]] static auto LevelAcquire(T &level);
+        [[nodiscard]] std::optional<ui32> AllocateFrom(ui32 level0Index); // nullopt if the masks were stale and have been fixed
+
+    public:
+        static constexpr ui32 invalidId = ui32_max;
+
+        ConcurrentUniqueIdManager() = default;
+        ~ConcurrentUniqueIdManager();
+        ConcurrentUniqueIdManager(const ConcurrentUniqueIdManager &) = delete;
+        ConcurrentUniqueIdManager &operator = (const ConcurrentUniqueIdManager &) = delete;
+
         [[nodiscard]] ui32 Allocate();
         [[nodiscard]] bool Allocate(ui32 id);
         bool Free(ui32 id);
         [[nodiscard]] bool IsAllocated(ui32 id) const;
-        // TODO: shrink_to_fit
-        // TODO: enumerate allocated ids
     };
 }
\ No newline at end of file
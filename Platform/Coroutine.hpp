@@ -0,0 +1,363 @@
+#pragma once
+
+#ifdef __cpp_impl_coroutine
+
+#include <coroutine>
+#include <MessagePool.hpp>
+#include <IFile.hpp>
+#include "TimedMessageQueue.hpp"
+
+namespace StdLib
+{
+	/* C++20 coroutines on top of the message queues and the thread pool.
+	   Task<T> is a lazily started coroutine, it starts when it's awaited or spawned. Awaiting a task resumes the awaiting
+	   coroutine right after the task finishes on the thread that finished it, without going through any queue.
+	   Spawn starts a task on an executor and lets it destroy itself when it's done, the task's result is discarded.
+	   Executor is a reference to anything that has the Add(FuncType func, VArgs &&... args) of MTMessageQueue, such as
+	   MTMessageQueue, MPSCMessageQueue, TimedMessageQueue and ThreadPool, the executor must outlive the coroutines that use it.
+	   Executor::Inline resumes the coroutine on the thread that completed the operation.
+	   Coroutine frames are allocated from MessagePool, like the queued messages. There are no exceptions, an exception
+	   that escapes a coroutine terminates the program.
+	   The awaitables (ResumeOn, RunOn, Delay, FileRead) keep their state in the coroutine frame, so awaiting them doesn't
+	   allocate anything besides the message that is posted to the executor.
+	*/
+
+	class Executor
+	{
+		void *_target = nullptr;
+		void (*_post)(void *target, void (*func)(void *argument), void *argument) = nullptr;
+
+	public:
+		Executor() = default; // inline
+
+		template <typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, Executor>>> Executor(T &target) : _target(&target)
+		{
+			_post = [](void *postTarget, void (*func)(void *argument), void *argument)
+			{
+				static_cast<T *>(postTarget)->Add(func, argument);
+			};
+		}
+
+		[[nodiscard]] static Executor Inline()
+		{
+			return {};
+		}
+
+		[[nodiscard]] bool IsInline() const
+		{
+			return _post == nullptr;
+		}
+
+		// calls func(argument) on the executor, or right away if it's inline
+		void Post(void (*func)(void *argument), void *argument) const
+		{
+			if (_post)
+			{
+				_post(_target, func, argument);
+			}
+			else
+			{
+				func(argument);
+			}
+		}
+
+		void Resume(std::coroutine_handle<> handle) const
+		{
+			Post([](void *address) { std::coroutine_handle<>::from_address(address).resume(); }, handle.address());
+		}
+	};
+
+	struct _TaskPromiseBase
+	{
+		std::coroutine_handle<> continuation{};
+		bool isDetached = false;
+
+		struct FinalAwaiter
+		{
+			[[nodiscard]] bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			template <typename Promise> std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+			{
+				_TaskPromiseBase &promise = handle.promise();
+				if (promise.continuation)
+				{
+					return promise.continuation;
+				}
+				if (promise.isDetached)
+				{
+					handle.destroy();
+				}
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept
+			{}
+		};
+
+		[[nodiscard]] std::suspend_always initial_suspend() const noexcept
+		{
+			return {};
+		}
+
+		[[nodiscard]] FinalAwaiter final_suspend() const noexcept
+		{
+			return {};
+		}
+
+		void unhandled_exception()
+		{
+			std::terminate();
+		}
+
+		[[nodiscard]] static void *operator new(std::size_t size)
+		{
+			return MessagePool::Allocate(size);
+		}
+
+		static void operator delete(void *memory, std::size_t size)
+		{
+			MessagePool::Free(memory, size);
+		}
+	};
+
+	template <typename T> struct _TaskPromise : _TaskPromiseBase
+	{
+		std::optional<T> value{};
+
+		template <typename U> void return_value(U &&result)
+		{
+			value.emplace(std::forward<U>(result));
+		}
+
+		T Take()
+		{
+			ASSUME(value);
+			return std::move(*value);
+		}
+	};
+
+	template <> struct _TaskPromise<void> : _TaskPromiseBase
+	{
+		void return_void()
+		{}
+
+		void Take()
+		{}
+	};
+
+	template <typename T = void> class [[nodiscard]] Task
+	{
+	public:
+		struct promise_type : _TaskPromise<T>
+		{
+			Task get_return_object()
+			{
+				return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+		};
+
+	private:
+		std::coroutine_handle<promise_type> _handle{};
+
+		explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle)
+		{}
+
+	public:
+		Task() = default;
+
+		~Task()
+		{
+			if (_handle)
+			{
+				_handle.destroy();
+			}
+		}
+
+		Task(Task &&source) noexcept : _handle(std::exchange(source._handle, nullptr))
+		{}
+
+		Task &operator = (Task &&source) noexcept
+		{
+			ASSUME(this != &source);
+			if (_handle)
+			{
+				_handle.destroy();
+			}
+			_handle = std::exchange(source._handle, nullptr);
+			return *this;
+		}
+
+		[[nodiscard]] bool IsDone() const
+		{
+			return _handle && _handle.done();
+		}
+
+		auto operator co_await () && noexcept
+		{
+			struct Awaiter
+			{
+				std::coroutine_handle<promise_type> handle;
+
+				[[nodiscard]] bool await_ready() const noexcept
+				{
+					return false;
+				}
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume()
+				{
+					return handle.promise().Take();
+				}
+			};
+
+			ASSUME(_handle && !_handle.done());
+			return Awaiter{_handle};
+		}
+
+		// starts the task on the executor, the task destroys itself when it's done
+		friend void Spawn(Executor executor, Task task)
+		{
+			ASSUME(task._handle);
+			task._handle.promise().isDetached = true;
+			executor.Resume(std::exchange(task._handle, nullptr));
+		}
+	};
+
+	// moves the coroutine to the executor
+	[[nodiscard]] inline auto ResumeOn(Executor executor)
+	{
+		struct Awaiter
+		{
+			Executor executor;
+
+			[[nodiscard]] bool await_ready() const noexcept
+			{
+				return executor.IsInline();
+			}
+
+			void await_suspend(std::coroutine_handle<> handle) const
+			{
+				executor.Resume(handle);
+			}
+
+			void await_resume() const noexcept
+			{}
+		};
+
+		return Awaiter{executor};
+	}
+
+	// executes func on the target executor and resumes the coroutine with its result on resumeOn when it's done
+	template <typename F> [[nodiscard]] auto RunOn(Executor target, Executor resumeOn, F &&func)
+	{
+		using resultType = std::invoke_result_t<F &>;
+
+		struct Awaiter
+		{
+			Executor target, resumeOn;
+			std::decay_t<F> func;
+			std::conditional_t<std::is_void_v<resultType>, bool, std::optional<resultType>> result{};
+			std::coroutine_handle<> handle{};
+
+			[[nodiscard]] bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			void await_suspend(std::coroutine_handle<> awaiting)
+			{
+				handle = awaiting;
+				target.Post([](void *argument)
+				{
+					auto *awaiter = static_cast<Awaiter *>(argument);
+					if constexpr (std::is_void_v<resultType>)
+					{
+						awaiter->func();
+					}
+					else
+					{
+						awaiter->result.emplace(awaiter->func());
+					}
+					awaiter->resumeOn.Resume(awaiter->handle); // the awaiter can be destroyed right after this call
+				}, this);
+			}
+
+			resultType await_resume()
+			{
+				if constexpr (!std::is_void_v<resultType>)
+				{
+					return std::move(*result);
+				}
+			}
+		};
+
+		return Awaiter{target, resumeOn, std::forward<F>(func)};
+	}
+
+	template <typename F> [[nodiscard]] auto RunOn(Executor target, F &&func)
+	{
+		return RunOn(target, Executor::Inline(), std::forward<F>(func));
+	}
+
+	// the timers fire on the thread that executes the queue, then the coroutine is resumed on resumeOn
+	[[nodiscard]] inline auto DelayUntil(TimedMessageQueue &timers, TimeMoment when, Executor resumeOn = Executor::Inline())
+	{
+		struct Awaiter
+		{
+			TimedMessageQueue &timers;
+			TimeMoment when;
+			Executor resumeOn;
+			std::coroutine_handle<> handle{};
+
+			[[nodiscard]] bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			void await_suspend(std::coroutine_handle<> awaiting)
+			{
+				handle = awaiting;
+				timers.AddAt(when, [](void *argument)
+				{
+					auto *awaiter = static_cast<Awaiter *>(argument);
+					awaiter->resumeOn.Resume(awaiter->handle);
+				}, static_cast<void *>(this));
+			}
+
+			void await_resume() const noexcept
+			{}
+		};
+
+		return Awaiter{timers, when, resumeOn};
+	}
+
+	[[nodiscard]] inline auto Delay(TimedMessageQueue &timers, TimeDifference delay, Executor resumeOn = Executor::Inline())
+	{
+		return DelayUntil(timers, TimeMoment::Now() + delay, resumeOn);
+	}
+
+	// the read is executed on ioExecutor, it returns how many bytes were read or nullopt if the read failed,
+	// the file must not be used by anything else until the read is done
+	[[nodiscard]] inline auto FileRead(IFile &file, void *target, ui32 len, Executor ioExecutor, Executor resumeOn = Executor::Inline())
+	{
+		return RunOn(ioExecutor, resumeOn, [&file, target, len]() -> std::optional<ui32>
+		{
+			ui32 read = 0;
+			if (!file.Read(target, len, &read))
+			{
+				return std::nullopt;
+			}
+			return read;
+		});
+	}
+}
+
+#endif
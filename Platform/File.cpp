@@ -1,8 +1,17 @@
 #include "_PreHeader.hpp"
 #include "File.hpp"
+#include <ShardedCounter.hpp>
 
 using namespace StdLib;
 
+#ifdef STDLIB_ENABLE_FILE_STATS
+namespace
+{
+    // files can be used from any thread, so the global stats are sharded to keep the updates from contending
+    ShardedStats<File::FileStats> GlobalStats;
+}
+#endif
+
 File::~File()
 {
     Close();
@@ -78,6 +87,22 @@ void File::StatsReset()
     ASSUME(IsOpen());
     _stats = {};
 }
+
+auto File::GlobalStatsGet() -> FileStats
+{
+    return GlobalStats.Load();
+}
+
+auto File::GlobalStatsReset() -> FileStats
+{
+    return GlobalStats.Reset();
+}
+
+void File::StatsAdd(FileStats::countert FileStats::*field, FileStats::countert value)
+{
+    _stats.*field += value;
+    GlobalStats.Add(field, value);
+}
 #endif
 
 FileOpenMode File::OpenMode() const
@@ -127,8 +152,8 @@ NOINLINE bool File::Read(void *RSTR target, ui32 len, ui32 *RSTR read)
         MemOps::Copy(static_cast<std::byte *>(target), _internalBuffer.get() + _bufferPos, len);
         _bufferPos += len;
     #ifdef STDLIB_ENABLE_FILE_STATS
-        ++_stats.readsFromBufferCount;
-        _stats.bytesFromBufferRead += len;
+        StatsAdd(&FileStats::readsFromBufferCount);
+        StatsAdd(&FileStats::bytesFromBufferRead, len);
     #endif
     };
 
@@ -151,7 +176,7 @@ NOINLINE bool File::Read(void *RSTR target, ui32 len, ui32 *RSTR read)
         if (len >= _bufferSize)
         {
 			#ifdef STDLIB_ENABLE_FILE_STATS
-				++_stats.unbufferedReads;
+				StatsAdd(&FileStats::unbufferedReads);
 			#endif
             return ReadFromFile(target, len, read);
         }
@@ -170,7 +195,7 @@ NOINLINE bool File::Read(void *RSTR target, ui32 len, ui32 *RSTR read)
     if (read) *read += cpyLen;
 
 	#ifdef STDLIB_ENABLE_FILE_STATS
-		++_stats.bufferedReads;
+		StatsAdd(&FileStats::bufferedReads);
 	#endif
 
     return true;
@@ -197,20 +222,20 @@ NOINLINE bool File::Write(const void *RSTR source, ui32 len, ui32 *RSTR written)
             return false;
         }
 		#ifdef STDLIB_ENABLE_FILE_STATS
-			++_stats.unbufferedWrites;
+			StatsAdd(&FileStats::unbufferedWrites);
 		#endif
         return WriteToFile(source, len, written);
     }
 
 	#ifdef STDLIB_ENABLE_FILE_STATS
-		++_stats.bufferedWrites;
+		StatsAdd(&FileStats::bufferedWrites);
 	#endif
 
     MemOps::Copy(_internalBuffer.get() + _bufferPos, static_cast<const std::byte *>(source), len);
     _bufferPos += len;
 	#ifdef STDLIB_ENABLE_FILE_STATS
-		++_stats.writesToBufferCount;
-		_stats.bytesToBufferWritten += len;
+		StatsAdd(&FileStats::writesToBufferCount);
+		StatsAdd(&FileStats::bytesToBufferWritten, len);
 	#endif
 
     if (written) *written = len;
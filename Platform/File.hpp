@@ -67,6 +67,8 @@ namespace StdLib
     #ifdef STDLIB_ENABLE_FILE_STATS
 		[[must_be_open]] [[nodiscard]] FileStats StatsGet() const;
 		[[must_be_open]] void StatsReset();
+		[[nodiscard]] static FileStats GlobalStatsGet(); // the sum of the stats of all files, including the closed ones
+		static FileStats GlobalStatsReset(); // returns the stats before the reset
     #endif
 
 		[[must_be_open]] [[nodiscard]] FileOpenMode OpenMode() const;
@@ -111,6 +113,9 @@ namespace StdLib
 		[[nodiscard]] bool ReadFromFile(void *target, ui32 len, ui32 *read);
 		[[nodiscard]] bool CancelCachedRead();
 		[[nodiscard]] Result<i64> CurrentFileOffset() const;
+    #ifdef STDLIB_ENABLE_FILE_STATS
+		void StatsAdd(FileStats::countert FileStats::*field, FileStats::countert value = 1);
+    #endif
     };
 }
 
@@ -0,0 +1,78 @@
+#include "_PreHeader.hpp"
+#include "ParallelAlgorithms.hpp"
+#include <Futex.hpp>
+
+using namespace StdLib;
+
+namespace
+{
+	constexpr uiw ChunksPerThread = 8;
+
+	// the helper tasks may start after the call has already returned, the shared state keeps them safe,
+	// they touch the caller's context only after they've claimed a chunk, which can't happen after the return
+	struct ChunksState
+	{
+		void (*chunkFunc)(void *context, uiw chunk);
+		void *context;
+		uiw chunksCount;
+		std::atomic<uiw> nextChunk{0};
+		std::atomic<ui32> finishedChunks{0};
+	};
+
+	void ExecuteChunks(ChunksState &state, bool isHelper)
+	{
+		for (uiw chunk; (chunk = state.nextChunk.fetch_add(1, std::memory_order_relaxed)) < state.chunksCount; )
+		{
+			state.chunkFunc(state.context, chunk);
+			if (state.finishedChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == state.chunksCount && isHelper)
+			{
+				Futex::WakeAll(state.finishedChunks);
+			}
+		}
+	}
+
+	void HelperTask(const std::shared_ptr<ChunksState> &state)
+	{
+		ExecuteChunks(*state, true);
+	}
+}
+
+void StdLib::_ParallelForChunks(ThreadPool &pool, uiw chunksCount, void (*chunkFunc)(void *context, uiw chunk), void *context)
+{
+	ASSUME(chunksCount <= ui32_max);
+
+	if (chunksCount == 1)
+	{
+		chunkFunc(context, 0);
+		return;
+	}
+
+	auto state = std::make_shared<ChunksState>();
+	state->chunkFunc = chunkFunc;
+	state->context = context;
+	state->chunksCount = chunksCount;
+
+	uiw helpersCount = std::min<uiw>(chunksCount - 1, pool.ThreadsCount());
+	for (uiw index = 0; index < helpersCount; ++index)
+	{
+		pool.Add<HelperTask>(state);
+	}
+
+	ExecuteChunks(*state, false);
+
+	// nothing is left to claim, only the chunks that the helpers are executing right now are waited for
+	for (ui32 finished; (finished = state->finishedChunks.load(std::memory_order_acquire)) != chunksCount; )
+	{
+		Futex::Wait(state->finishedChunks, finished);
+	}
+}
+
+uiw StdLib::_ParallelGrain(const ThreadPool &pool, uiw length, uiw grain)
+{
+	if (grain == 0)
+	{
+		grain = length / ((pool.ThreadsCount() + 1) * ChunksPerThread);
+	}
+	// the chunks are counted in 32 bits to be able to wait on them with a futex
+	return std::max({grain, (length + ui32_max - 1) / ui32_max, uiw(1)});
+}
\ No newline at end of file
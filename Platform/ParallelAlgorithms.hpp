@@ -0,0 +1,252 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+namespace StdLib
+{
+	/* The range is split into chunks that are claimed from a shared counter by the calling thread and by the pool's
+	   workers, so faster threads process more chunks. grain is the chunk length, 0 picks one so that every worker
+	   gets several chunks.
+	   The calling thread participates and only waits for the chunks that are already being executed, so these can be
+	   called from the pool's own tasks too.
+	*/
+
+	void _ParallelForChunks(ThreadPool &pool, uiw chunksCount, void (*chunkFunc)(void *context, uiw chunk), void *context);
+	[[nodiscard]] uiw _ParallelGrain(const ThreadPool &pool, uiw length, uiw grain);
+
+	// func is either void(uiw index) or void(uiw chunkBegin, uiw chunkEnd), the latter lets it keep state across the chunk
+	template <typename F> void ParallelFor(ThreadPool &pool, uiw begin, uiw end, uiw grain, F &&func)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		uiw length = end - begin;
+		grain = _ParallelGrain(pool, length, grain);
+
+		struct Context
+		{
+			F &func;
+			uiw begin, end, grain;
+		} context{func, begin, end, grain};
+
+		auto chunkFunc = [](void *contextPointer, uiw chunk)
+		{
+			auto &chunkContext = *static_cast<Context *>(contextPointer);
+			uiw chunkBegin = chunkContext.begin + chunk * chunkContext.grain;
+			uiw chunkEnd = chunkContext.end - chunkBegin > chunkContext.grain ? chunkBegin + chunkContext.grain : chunkContext.end;
+			if constexpr (std::is_invocable_v<F &, uiw, uiw>)
+			{
+				chunkContext.func(chunkBegin, chunkEnd);
+			}
+			else
+			{
+				for (uiw index = chunkBegin; index < chunkEnd; ++index)
+				{
+					chunkContext.func(index);
+				}
+			}
+		};
+
+		_ParallelForChunks(pool, (length + grain - 1) / grain, chunkFunc, &context);
+	}
+
+	// reduceChunk is T(uiw chunkBegin, uiw chunkEnd), combine is T(T, T), the partial results are combined in the order of
+	// the chunks, so the result doesn't depend on which threads executed them (but it does depend on the grain)
+	template <typename T, typename ReduceChunk, typename Combine> [[nodiscard]] T ParallelReduce(ThreadPool &pool, uiw begin, uiw end, uiw grain, T identity, ReduceChunk &&reduceChunk, Combine &&combine)
+	{
+		if (begin >= end)
+		{
+			return identity;
+		}
+
+		uiw length = end - begin;
+		grain = _ParallelGrain(pool, length, grain);
+		std::vector<T> partials((length + grain - 1) / grain, identity);
+
+		ParallelFor(pool, 0, partials.size(), 1, [&](uiw chunk)
+		{
+			uiw chunkBegin = begin + chunk * grain;
+			uiw chunkEnd = end - chunkBegin > grain ? chunkBegin + grain : end;
+			partials[chunk] = reduceChunk(chunkBegin, chunkEnd);
+		});
+
+		T result = std::move(identity);
+		for (T &partial : partials)
+		{
+			result = combine(std::move(result), std::move(partial));
+		}
+		return result;
+	}
+
+	// returns how many elements of first precede the output position in a stable merge of first and second
+	template <typename T, typename Compare> [[nodiscard]] uiw _MergePathSplit(const T *first, uiw firstLength, const T *second, uiw secondLength, uiw position, Compare &compare)
+	{
+		uiw low = position > secondLength ? position - secondLength : 0;
+		uiw high = std::min(position, firstLength);
+		while (low < high)
+		{
+			uiw middle = (low + high) / 2;
+			if (compare(second[position - middle - 1], first[middle]))
+			{
+				high = middle;
+			}
+			else
+			{
+				low = middle + 1;
+			}
+		}
+		return low;
+	}
+
+	constexpr uiw ParallelSortSequentialThreshold = 1 << 14;
+
+	// stable merge sort, the runs are sorted with std::stable_sort and then merged pairwise, every merge is split into
+	// pieces along the merge path, so the last passes that have only a couple of runs left still use all the workers
+	// T must be default constructible and movable, an intermediate buffer of count elements is allocated
+	template <typename T, typename Compare = std::less<>> void ParallelSort(ThreadPool &pool, T *data, uiw count, Compare compare = Compare())
+	{
+		uiw threadsCount = pool.ThreadsCount() + 1;
+		if (count <= ParallelSortSequentialThreshold || threadsCount <= 2)
+		{
+			std::stable_sort(data, data + count, compare);
+			return;
+		}
+
+		uiw runsCount = std::min(threadsCount * 2, count / (ParallelSortSequentialThreshold / 4));
+		uiw runLength = (count + runsCount - 1) / runsCount;
+		ParallelFor(pool, 0, count, runLength, [data, &compare](uiw runBegin, uiw runEnd)
+		{
+			std::stable_sort(data + runBegin, data + runEnd, compare);
+		});
+
+		std::vector<T> buffer(count);
+		T *source = data, *target = buffer.data();
+		uiw pieceLength = std::max<uiw>(count / (threadsCount * 4), ParallelSortSequentialThreshold / 4);
+
+		for (; runLength < count; runLength *= 2)
+		{
+			uiw pairLength = runLength * 2;
+			uiw piecesPerPair = (pairLength + pieceLength - 1) / pieceLength;
+			uiw pairsCount = (count + pairLength - 1) / pairLength;
+
+			ParallelFor(pool, 0, pairsCount * piecesPerPair, 1, [&](uiw piece)
+			{
+				uiw pairBegin = piece / piecesPerPair * pairLength;
+				uiw pairEnd = std::min(pairBegin + pairLength, count);
+				uiw middle = std::min(pairBegin + runLength, count);
+				uiw outputBegin = pairBegin + piece % piecesPerPair * pieceLength;
+				if (outputBegin >= pairEnd)
+				{
+					return;
+				}
+				uiw outputEnd = std::min(outputBegin + pieceLength, pairEnd);
+
+				const T *first = source + pairBegin, *second = source + middle;
+				uiw firstLength = middle - pairBegin, secondLength = pairEnd - middle;
+				uiw firstFrom = _MergePathSplit(first, firstLength, second, secondLength, outputBegin - pairBegin, compare);
+				uiw firstTo = _MergePathSplit(first, firstLength, second, secondLength, outputEnd - pairBegin, compare);
+				uiw secondFrom = outputBegin - pairBegin - firstFrom, secondTo = outputEnd - pairBegin - firstTo;
+
+				std::merge(
+					std::make_move_iterator(source + pairBegin + firstFrom), std::make_move_iterator(source + pairBegin + firstTo),
+					std::make_move_iterator(source + middle + secondFrom), std::make_move_iterator(source + middle + secondTo),
+					target + outputBegin, compare);
+			});
+
+			std::swap(source, target);
+		}
+
+		if (source != data)
+		{
+			ParallelFor(pool, 0, count, pieceLength, [data, source](uiw chunkBegin, uiw chunkEnd)
+			{
+				std::move(source + chunkBegin, source + chunkEnd, data + chunkBegin);
+			});
+		}
+	}
+
+	// LSD radix sort with 8 bit digits, stable, key is KeyType(const T &) and must return an unsigned integer,
+	// the passes where all the keys have the same digit are skipped, so small keys in wide types are cheap
+	// T must be default constructible and movable, an intermediate buffer of count elements is allocated
+	template <typename T, typename KeyFunc> void ParallelRadixSort(ThreadPool &pool, T *data, uiw count, KeyFunc &&key)
+	{
+		using keyType = std::decay_t<decltype(key(*data))>;
+		static_assert(std::is_unsigned_v<keyType>, "the key must be an unsigned integer");
+		constexpr uiw digitBits = 8, digitsCount = 1 << digitBits;
+
+		if (count < 2)
+		{
+			return;
+		}
+
+		// the chunks must stay the same between counting and scattering, so they're fixed up front
+		uiw chunksCount = std::min<uiw>((pool.ThreadsCount() + 1) * 4, (count + 1023) / 1024);
+		uiw chunkLength = (count + chunksCount - 1) / chunksCount;
+		chunksCount = (count + chunkLength - 1) / chunkLength;
+
+		std::vector<std::array<uiw, digitsCount>> offsets(chunksCount);
+		std::vector<T> buffer(count);
+		T *source = data, *target = buffer.data();
+
+		for (uiw shift = 0; shift < sizeof(keyType) * 8; shift += digitBits)
+		{
+			ParallelFor(pool, 0, chunksCount, 1, [&](uiw chunk)
+			{
+				auto &histogram = offsets[chunk];
+				histogram.fill(0);
+				for (uiw index = chunk * chunkLength, end = std::min(index + chunkLength, count); index < end; ++index)
+				{
+					++histogram[(key(source[index]) >> shift) & (digitsCount - 1)];
+				}
+			});
+
+			// digit major, then chunk order, which keeps the sort stable
+			uiw offset = 0;
+			bool isSingleDigit = false;
+			for (uiw digit = 0; digit < digitsCount; ++digit)
+			{
+				uiw digitBegin = offset;
+				for (auto &histogram : offsets)
+				{
+					uiw digitCount = histogram[digit];
+					histogram[digit] = offset;
+					offset += digitCount;
+				}
+				if (offset - digitBegin == count)
+				{
+					isSingleDigit = true;
+				}
+			}
+			if (isSingleDigit)
+			{
+				continue;
+			}
+
+			ParallelFor(pool, 0, chunksCount, 1, [&](uiw chunk)
+			{
+				auto &chunkOffsets = offsets[chunk];
+				for (uiw index = chunk * chunkLength, end = std::min(index + chunkLength, count); index < end; ++index)
+				{
+					target[chunkOffsets[(key(source[index]) >> shift) & (digitsCount - 1)]++] = std::move(source[index]);
+				}
+			});
+
+			std::swap(source, target);
+		}
+
+		if (source != data)
+		{
+			ParallelFor(pool, 0, count, chunkLength, [data, source](uiw chunkBegin, uiw chunkEnd)
+			{
+				std::move(source + chunkBegin, source + chunkEnd, data + chunkBegin);
+			});
+		}
+	}
+
+	template <typename T> void ParallelRadixSort(ThreadPool &pool, T *data, uiw count)
+	{
+		ParallelRadixSort(pool, data, count, [](const T &value) { return value; });
+	}
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "_PreHeader.hpp"
+#include "ParallelHashing.hpp"
+#include "SystemInfo.hpp"
+#include <thread>
+
+using namespace StdLib;
+
+// the jobs are taken from a shared counter, so faster threads process more jobs
+template <typename Job> static void RunJobs(uiw jobsCount, ui32 threadsCount, Job &&job)
+{
+	if (threadsCount == 0)
+	{
+		threadsCount = SystemInfo::LogicalCPUCores();
+	}
+	threadsCount = static_cast<ui32>(std::max<uiw>(std::min<uiw>(threadsCount, jobsCount), 1));
+
+	std::atomic<uiw> nextJob{0};
+	auto worker = [&nextJob, &job, jobsCount]
+	{
+		for (uiw index; (index = nextJob.fetch_add(1, std::memory_order_relaxed)) < jobsCount; )
+		{
+			job(index);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadsCount - 1);
+	for (ui32 index = 1; index < threadsCount; ++index)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+ui32 Hash::CRC32Parallel(const void *source, uiw length, ui32 threadsCount)
+{
+	const ui8 *p = static_cast<const ui8 *>(source);
+	uiw chunksCount = (length + CRC32ParallelChunkLength - 1) / CRC32ParallelChunkLength;
+	if (chunksCount <= 1)
+	{
+		return CRC32(p, length);
+	}
+
+	std::vector<ui32> chunks(chunksCount);
+	RunJobs(chunksCount, threadsCount, [p, length, &chunks](uiw index)
+	{
+		uiw offset = index * CRC32ParallelChunkLength;
+		chunks[index] = CRC32(p + offset, std::min(CRC32ParallelChunkLength, length - offset));
+	});
+
+	ui32 crc = chunks[0];
+	for (uiw index = 1; index < chunksCount; ++index)
+	{
+		uiw offset = index * CRC32ParallelChunkLength;
+		crc = CRC32Combine(crc, chunks[index], std::min(CRC32ParallelChunkLength, length - offset));
+	}
+	return crc;
+}
+
+Result<ui32> Hash::CRC32Parallel(File &file, ui32 threadsCount)
+{
+	MemoryMappedFile mapping;
+	if (auto error = _MapFileForHashing(file, mapping); error)
+	{
+		return error;
+	}
+	if (!mapping.IsOpen())
+	{
+		return CRC32Parallel(nullptr, 0, threadsCount);
+	}
+	return CRC32Parallel(mapping.CMemory(), mapping.Size(), threadsCount);
+}
+
+void Hash::_FastHashTreeLeavesParallel(const ui8 *source, uiw length, uiw leafLength, Hash128 *leaves, ui32 threadsCount)
+{
+	uiw leavesCount = (length + leafLength - 1) / leafLength;
+	RunJobs(leavesCount, threadsCount, [source, length, leafLength, leaves](uiw index)
+	{
+		uiw offset = index * leafLength;
+		leaves[index] = FastHash<Precision::P128>(source + offset, std::min(leafLength, length - offset));
+	});
+}
+
+Error<> Hash::_MapFileForHashing(File &file, MemoryMappedFile &mapping)
+{
+	auto sizeResult = file.Size();
+	if (!sizeResult)
+	{
+		return sizeResult.GetError();
+	}
+	if (sizeResult.Unwrap() == 0)
+	{
+		return DefaultError::Ok();
+	}
+	return mapping.Open(file, 0, uiw_max, false, false);
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "MemoryMappedFile.hpp"
+
+namespace StdLib::Hash
+{
+	// the input is split into chunks that are hashed on multiple threads and then combined, the results
+	// are identical to the single threaded CRC32 and FastHashTree
+	// threadsCount 0 means SystemInfo::LogicalCPUCores, the calling thread participates in hashing too
+	// the File overloads map the whole file regardless of its current offset, so the file must be open for reading
+
+	constexpr uiw CRC32ParallelChunkLength = 1 << 22;
+
+	[[nodiscard]] ui32 CRC32Parallel(const void *source, uiw length, ui32 threadsCount = 0);
+	[[nodiscard]] Result<ui32> CRC32Parallel(File &file, ui32 threadsCount = 0);
+
+	void _FastHashTreeLeavesParallel(const ui8 *source, uiw length, uiw leafLength, Hash128 *leaves, ui32 threadsCount);
+	[[nodiscard]] Error<> _MapFileForHashing(File &file, MemoryMappedFile &mapping); // an empty file leaves the mapping closed
+
+	template <Precision precision> [[nodiscard]] auto FastHashTreeParallel(const void *source, uiw length, uiw leafLength = FastHashTreeDefaultLeafLength, ui32 threadsCount = 0)
+	{
+		ASSUME(leafLength > 0);
+		std::vector<Hash128> leaves((length + leafLength - 1) / leafLength);
+		_FastHashTreeLeavesParallel(static_cast<const ui8 *>(source), length, leafLength, leaves.data(), threadsCount);
+		return FastHashTreeCombine<precision>(leaves.data(), leaves.size(), length, leafLength);
+	}
+
+	template <Precision precision> [[nodiscard]] auto FastHashTreeParallel(File &file, uiw leafLength = FastHashTreeDefaultLeafLength, ui32 threadsCount = 0) -> Result<decltype(FastHashTreeParallel<precision>(nullptr, 0))>
+	{
+		MemoryMappedFile mapping;
+		if (auto error = _MapFileForHashing(file, mapping); error)
+		{
+			return error;
+		}
+		if (!mapping.IsOpen())
+		{
+			return FastHashTreeParallel<precision>(nullptr, 0, leafLength, threadsCount);
+		}
+		return FastHashTreeParallel<precision>(mapping.CMemory(), mapping.Size(), leafLength, threadsCount);
+	}
+}
\ No newline at end of file
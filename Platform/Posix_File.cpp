@@ -320,7 +320,7 @@ bool File::WriteToFile(const void *source, ui32 len, ui32 *written)
     ASSUME(source || len == 0);
 
 #ifdef STDLIB_ENABLE_FILE_STATS
-    ++_stats.writesToFileCount;
+    StatsAdd(&FileStats::writesToFileCount);
 #endif
 
     ssize_t sswritten = write(_handle, source, len);
@@ -331,7 +331,7 @@ bool File::WriteToFile(const void *source, ui32 len, ui32 *written)
     }
 
 #ifdef STDLIB_ENABLE_FILE_STATS
-    _stats.bytesToFileWritten += sswritten;
+    StatsAdd(&FileStats::bytesToFileWritten, sswritten);
 #endif
 
     if (written) *written = static_cast<ui32>(sswritten);
@@ -344,7 +344,7 @@ bool File::ReadFromFile(void *target, ui32 len, ui32 *readRet)
     ASSUME(target || len == 0);
 
 #ifdef STDLIB_ENABLE_FILE_STATS
-    ++_stats.readsFromFileCount;
+    StatsAdd(&FileStats::readsFromFileCount);
 #endif
 
     ssize_t actuallyRead = read(_handle, target, len);
@@ -355,7 +355,7 @@ bool File::ReadFromFile(void *target, ui32 len, ui32 *readRet)
     }
 
 #ifdef STDLIB_ENABLE_FILE_STATS
-    _stats.bytesFromFileRead += actuallyRead;
+    StatsAdd(&FileStats::bytesFromFileRead, actuallyRead);
 #endif
 
     if (readRet) *readRet = static_cast<ui32>(actuallyRead);
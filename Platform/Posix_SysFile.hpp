@@ -0,0 +1,21 @@
+#pragma once
+
+namespace StdLib
+{
+	// reads the first line of a sysfs or procfs file, the trailing newline is removed
+	inline bool ReadSysFile(const char *path, char *buffer, int bufferSize)
+	{
+		FILE *file = fopen(path, "r");
+		if (!file)
+		{
+			return false;
+		}
+		bool isRead = fgets(buffer, bufferSize, file) != nullptr;
+		fclose(file);
+		if (isRead)
+		{
+			buffer[strcspn(buffer, "\n")] = '\0';
+		}
+		return isRead;
+	}
+}
\ No newline at end of file
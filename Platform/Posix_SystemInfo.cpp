@@ -1,6 +1,7 @@
 #include "_PreHeader.hpp"
 #include "SystemInfo.hpp"
 #include "VirtualMemory.hpp"
+#include "Posix_SysFile.hpp"
 #include <unistd.h>
 #include <sys/resource.h>
 
@@ -14,7 +15,114 @@ namespace
 {
     uiw AllocationAlignmentValue;
     ui32 LogicalCPUCoresValue;
+    ui32 PhysicalCPUCoresValue;
     uiw PageSizeValue;
+    std::vector<SystemInfo::CacheInfo> CacheInfos;
+
+    // sysfs exposes the topology on Linux and Android, every cache instance is counted once by its shared_cpu_list
+    void AcquireTopology()
+    {
+        char path[128], buffer[256];
+        std::vector<std::string> coreIds, cacheInstances;
+
+        for (ui32 core = 0; core < LogicalCPUCoresValue; ++core)
+        {
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", core);
+            if (ReadSysFile(path, buffer, sizeof(buffer)))
+            {
+                std::string coreId = buffer;
+                snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", core);
+                if (ReadSysFile(path, buffer, sizeof(buffer)))
+                {
+                    coreId += ":"s + buffer;
+                }
+                if (std::find(coreIds.begin(), coreIds.end(), coreId) == coreIds.end())
+                {
+                    coreIds.push_back(std::move(coreId));
+                }
+            }
+
+            for (ui32 index = 0;; ++index)
+            {
+                auto readIndexFile = [core, index, &path, &buffer](const char *name)
+                {
+                    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/%s", core, index, name);
+                    return ReadSysFile(path, buffer, sizeof(buffer));
+                };
+
+                SystemInfo::CacheInfo info;
+                if (!readIndexFile("level"))
+                {
+                    break;
+                }
+                info.level = static_cast<ui32>(atoi(buffer));
+                if (!readIndexFile("type"))
+                {
+                    continue;
+                }
+                if (!strcmp(buffer, "Data"))
+                {
+                    info.type = SystemInfo::CacheInfo::Type::Data;
+                }
+                else if (!strcmp(buffer, "Instruction"))
+                {
+                    info.type = SystemInfo::CacheInfo::Type::Instruction;
+                }
+                else
+                {
+                    info.type = SystemInfo::CacheInfo::Type::Unified;
+                }
+                if (readIndexFile("size"))
+                {
+                    char *suffix;
+                    info.size = static_cast<uiw>(strtoull(buffer, &suffix, 10));
+                    info.size *= *suffix == 'K' ? 1024 : *suffix == 'M' ? 1024 * 1024 : 1;
+                }
+                if (readIndexFile("coherency_line_size"))
+                {
+                    info.lineSize = static_cast<ui32>(atoi(buffer));
+                }
+                if (readIndexFile("ways_of_associativity"))
+                {
+                    info.associativity = static_cast<ui32>(atoi(buffer));
+                }
+                if (!readIndexFile("shared_cpu_list"))
+                {
+                    continue;
+                }
+
+                std::string instance = std::to_string(info.level) + ":" + std::to_string(static_cast<ui32>(info.type)) + ":" + buffer;
+                if (std::find(cacheInstances.begin(), cacheInstances.end(), instance) != cacheInstances.end())
+                {
+                    continue;
+                }
+                cacheInstances.push_back(std::move(instance));
+
+                bool isFound = false;
+                for (auto &stored : CacheInfos)
+                {
+                    if (stored.associativity == info.associativity &&
+                        stored.level == info.level &&
+                        stored.lineSize == info.lineSize &&
+                        stored.size == info.size &&
+                        stored.type == info.type)
+                    {
+                        isFound = true;
+                        ++stored.count;
+                        break;
+                    }
+                }
+                if (!isFound)
+                {
+                    info.count = 1;
+                    CacheInfos.push_back(info);
+                }
+            }
+        }
+
+        CacheInfos.shrink_to_fit();
+        PhysicalCPUCoresValue = coreIds.empty() ? LogicalCPUCoresValue : static_cast<ui32>(coreIds.size());
+    }
 }
 
 auto SystemInfo::CPUArchitecture() -> Arch
@@ -42,17 +150,17 @@ ui32 SystemInfo::LogicalCPUCores()
     return LogicalCPUCoresValue;
 }
 
-// TODO: retrive actual physical cores count
+// equals LogicalCPUCores if the topology isn't available
 ui32 SystemInfo::PhysicalCPUCores()
 {
-    ASSUME(LogicalCPUCoresValue > 0);
-    return LogicalCPUCoresValue;
+    ASSUME(PhysicalCPUCoresValue > 0);
+    return PhysicalCPUCoresValue;
 }
 
-// TODO: implementation
+// empty if the topology isn't available
 auto SystemInfo::AcquireCacheInfo() -> std::pair<const CacheInfo *, uiw>
 {
-	return {nullptr, 0u};
+	return {CacheInfos.data(), CacheInfos.size()};
 }
 
 uiw SystemInfo::AllocationAlignment()
@@ -140,5 +248,8 @@ namespace StdLib::SystemInfo
 		{
 			LogicalCPUCoresValue = static_cast<ui32>(logicalCPUCores);
 		}
+
+		CacheInfos.clear();
+		AcquireTopology();
     }
 }
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include "_PreHeader.hpp"
+#include "ThreadControl.hpp"
+#include "PlatformErrorResolve.hpp"
+#include "Posix_SysFile.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID)
+	#define HAS_LINUX_SCHEDULING
+	#include <sys/syscall.h>
+#endif
+
+using namespace StdLib;
+using namespace ThreadControl;
+
+namespace
+{
+	// pthread functions return the error code instead of setting errno
+	Error<> PthreadErrorResolve(int code, const char *message)
+	{
+		errno = code;
+		return PlatformErrorResolve(message);
+	}
+
+	std::optional<int> PolicyToPosix(Policy policy)
+	{
+		switch (policy)
+		{
+		case Policy::Normal:
+			return SCHED_OTHER;
+	#ifdef HAS_LINUX_SCHEDULING
+		case Policy::Batch:
+			return SCHED_BATCH;
+		case Policy::Idle:
+			return SCHED_IDLE;
+	#endif
+		case Policy::FIFO:
+			return SCHED_FIFO;
+		case Policy::RoundRobin:
+			return SCHED_RR;
+		default:
+			return std::nullopt;
+		}
+	}
+
+	// spread over the policy's range, Lowest is the minimum and Highest is the maximum
+	int RealTimePriority(int policy, Priority priority)
+	{
+		int minimum = sched_get_priority_min(policy);
+		int maximum = sched_get_priority_max(policy);
+		return minimum + (maximum - minimum) * static_cast<int>(priority) / static_cast<int>(Priority::Highest);
+	}
+
+	Error<> SchedulingSetPosix(pthread_t thread, bool isCurrentThread, Policy policy, Priority priority)
+	{
+		auto posixPolicy = PolicyToPosix(policy);
+		if (!posixPolicy)
+		{
+			return DefaultError::Unsupported("the scheduling policy isn't supported on this platform");
+		}
+
+		bool isRealTime = policy == Policy::FIFO || policy == Policy::RoundRobin;
+		bool isNiceRequired = !isRealTime && policy != Policy::Idle;
+	#ifdef HAS_LINUX_SCHEDULING
+		// nice values are per thread on Linux, but they can be set only through a thread id, which pthread_t doesn't expose
+		if (isNiceRequired && priority != Priority::Normal && !isCurrentThread)
+		{
+			return DefaultError::Unsupported("the priority of the time-sharing policies can be changed only for the calling thread");
+		}
+	#else
+		if (isNiceRequired && priority != Priority::Normal)
+		{
+			return DefaultError::Unsupported("the priority of the time-sharing policies can't be changed on this platform");
+		}
+	#endif
+
+		sched_param param{};
+		param.sched_priority = isRealTime ? RealTimePriority(*posixPolicy, priority) : 0;
+		if (int result = pthread_setschedparam(thread, *posixPolicy, &param); result != 0)
+		{
+			return PthreadErrorResolve(result, "pthread_setschedparam failed");
+		}
+
+	#ifdef HAS_LINUX_SCHEDULING
+		if (isNiceRequired && isCurrentThread)
+		{
+			static constexpr int niceValues[] = {19, 10, 0, -10, -20};
+			if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), niceValues[static_cast<uiw>(priority)]) != 0)
+			{
+				return PlatformErrorResolve("setpriority failed");
+			}
+		}
+	#endif
+
+		return DefaultError::Ok();
+	}
+
+	Error<> NameSetPosix([[maybe_unused]] pthread_t thread, [[maybe_unused]] bool isCurrentThread, std::string_view name)
+	{
+		char truncated[MaxNameLength + 1];
+		uiw length = std::min(name.size(), MaxNameLength);
+		MemOps::Copy(truncated, name.data(), length);
+		truncated[length] = '\0';
+
+	#if defined(PLATFORM_MACOS) || defined(PLATFORM_IOS)
+		if (!isCurrentThread)
+		{
+			return DefaultError::Unsupported("only the calling thread can be named on this platform");
+		}
+		if (int result = pthread_setname_np(truncated); result != 0)
+		{
+			return PthreadErrorResolve(result, "pthread_setname_np failed");
+		}
+		return DefaultError::Ok();
+	#elif defined(HAS_LINUX_SCHEDULING)
+		if (int result = pthread_setname_np(thread, truncated); result != 0)
+		{
+			return PthreadErrorResolve(result, "pthread_setname_np failed");
+		}
+		return DefaultError::Ok();
+	#else
+		return DefaultError::Unsupported();
+	#endif
+	}
+
+#ifdef HAS_LINUX_SCHEDULING
+	cpu_set_t CPUSetToPosix(const CPUSet &cores)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (ui32 core = 0; core < std::min<ui32>(CPUSet::MaxCores, CPU_SETSIZE); ++core)
+		{
+			if (cores.Contains(core))
+			{
+				CPU_SET(core, &set);
+			}
+		}
+		return set;
+	}
+
+	CPUSet CPUSetFromPosix(const cpu_set_t &set)
+	{
+		CPUSet cores;
+		for (ui32 core = 0; core < std::min<ui32>(CPUSet::MaxCores, CPU_SETSIZE); ++core)
+		{
+			if (CPU_ISSET(core, &set))
+			{
+				cores.Add(core);
+			}
+		}
+		return cores;
+	}
+
+	// sysfs lists look like "0-3,8,10-11"
+	CPUSet ParseCPUList(const char *list)
+	{
+		CPUSet cores;
+		while (*list)
+		{
+			char *end;
+			ui32 first = static_cast<ui32>(strtoul(list, &end, 10));
+			if (end == list)
+			{
+				break;
+			}
+			ui32 last = first;
+			if (*end == '-')
+			{
+				list = end + 1;
+				last = static_cast<ui32>(strtoul(list, &end, 10));
+			}
+			for (ui32 core = first; core <= last && core < CPUSet::MaxCores; ++core)
+			{
+				cores.Add(core);
+			}
+			list = *end == ',' ? end + 1 : end;
+		}
+		return cores;
+	}
+#endif
+}
+
+Error<> ThreadControl::AffinitySet(const CPUSet &cores)
+{
+	if (cores.IsEmpty())
+	{
+		return DefaultError::InvalidArgument("the set of cores is empty");
+	}
+#ifdef HAS_LINUX_SCHEDULING
+	cpu_set_t set = CPUSetToPosix(cores);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+	{
+		return PlatformErrorResolve("sched_setaffinity failed");
+	}
+	return DefaultError::Ok();
+#else
+	return DefaultError::Unsupported();
+#endif
+}
+
+Error<> ThreadControl::AffinitySet(std::thread &thread, const CPUSet &cores)
+{
+	ASSUME(thread.joinable());
+	if (cores.IsEmpty())
+	{
+		return DefaultError::InvalidArgument("the set of cores is empty");
+	}
+#if defined(PLATFORM_ANDROID)
+	cpu_set_t set = CPUSetToPosix(cores);
+	if (sched_setaffinity(pthread_gettid_np(thread.native_handle()), sizeof(set), &set) != 0)
+	{
+		return PlatformErrorResolve("sched_setaffinity failed");
+	}
+	return DefaultError::Ok();
+#elif defined(HAS_LINUX_SCHEDULING)
+	cpu_set_t set = CPUSetToPosix(cores);
+	if (int result = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set); result != 0)
+	{
+		return PthreadErrorResolve(result, "pthread_setaffinity_np failed");
+	}
+	return DefaultError::Ok();
+#else
+	return DefaultError::Unsupported();
+#endif
+}
+
+Result<CPUSet> ThreadControl::AffinityGet()
+{
+#ifdef HAS_LINUX_SCHEDULING
+	cpu_set_t set;
+	if (sched_getaffinity(0, sizeof(set), &set) != 0)
+	{
+		return PlatformErrorResolve("sched_getaffinity failed");
+	}
+	return CPUSetFromPosix(set);
+#else
+	return DefaultError::Unsupported();
+#endif
+}
+
+Result<CPUSet> ThreadControl::AffinityGet(std::thread &thread)
+{
+	ASSUME(thread.joinable());
+#if defined(PLATFORM_ANDROID)
+	cpu_set_t set;
+	if (sched_getaffinity(pthread_gettid_np(thread.native_handle()), sizeof(set), &set) != 0)
+	{
+		return PlatformErrorResolve("sched_getaffinity failed");
+	}
+	return CPUSetFromPosix(set);
+#elif defined(HAS_LINUX_SCHEDULING)
+	cpu_set_t set;
+	if (int result = pthread_getaffinity_np(thread.native_handle(), sizeof(set), &set); result != 0)
+	{
+		return PthreadErrorResolve(result, "pthread_getaffinity_np failed");
+	}
+	return CPUSetFromPosix(set);
+#else
+	return DefaultError::Unsupported();
+#endif
+}
+
+Error<> ThreadControl::NameSet(std::string_view name)
+{
+	return NameSetPosix(pthread_self(), true, name);
+}
+
+Error<> ThreadControl::NameSet(std::thread &thread, std::string_view name)
+{
+	ASSUME(thread.joinable());
+	return NameSetPosix(thread.native_handle(), false, name);
+}
+
+Error<> ThreadControl::SchedulingSet(Policy policy, Priority priority)
+{
+	return SchedulingSetPosix(pthread_self(), true, policy, priority);
+}
+
+Error<> ThreadControl::SchedulingSet(std::thread &thread, Policy policy, Priority priority)
+{
+	ASSUME(thread.joinable());
+	return SchedulingSetPosix(thread.native_handle(), false, policy, priority);
+}
+
+CPUSet ThreadControl::CoresSharingCache(ui32 core, ui32 cacheLevel)
+{
+#ifdef HAS_LINUX_SCHEDULING
+	char path[128], buffer[256];
+	for (ui32 index = 0;; ++index)
+	{
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", core, index);
+		if (!ReadSysFile(path, buffer, sizeof(buffer)))
+		{
+			break;
+		}
+		if (static_cast<ui32>(atoi(buffer)) != cacheLevel)
+		{
+			continue;
+		}
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", core, index);
+		if (ReadSysFile(path, buffer, sizeof(buffer)))
+		{
+			CPUSet cores = ParseCPUList(buffer);
+			if (cores.Contains(core))
+			{
+				return cores;
+			}
+		}
+		break;
+	}
+#endif
+	return CPUSet::Single(core);
+}
+
+CPUSet ThreadControl::SiblingCores(ui32 core)
+{
+#ifdef HAS_LINUX_SCHEDULING
+	char path[128], buffer[256];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list", core);
+	if (ReadSysFile(path, buffer, sizeof(buffer)))
+	{
+		CPUSet cores = ParseCPUList(buffer);
+		if (cores.Contains(core))
+		{
+			return cores;
+		}
+	}
+#endif
+	return CPUSet::Single(core);
+}
+
+std::optional<ui32> ThreadControl::CurrentCore()
+{
+#ifdef HAS_LINUX_SCHEDULING
+	int core = sched_getcpu();
+	if (core >= 0)
+	{
+		return static_cast<ui32>(core);
+	}
+#endif
+	return std::nullopt;
+}
@@ -24,7 +24,7 @@ namespace StdLib::SystemInfo
 		ui32 associativity{};
 		uiw size{}; // in bytes
 		Type type{};
-		ui32 count{}; // always 0 on POSIX
+		ui32 count{}; // how many instances of the cache the system has
 	};
 
 	struct MonitorInfo
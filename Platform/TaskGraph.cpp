@@ -0,0 +1,135 @@
+#include "_PreHeader.hpp"
+#include "TaskGraph.hpp"
+#include <Futex.hpp>
+
+using namespace StdLib;
+
+TaskGraph::TaskGraph(ThreadPool &pool) : _pool(pool)
+{}
+
+TaskGraph::~TaskGraph()
+{
+	Wait();
+}
+
+void TaskGraph::Wait()
+{
+	ASSUME(_pool.CurrentWorkerIndex() == std::nullopt); // a waiting task would occupy the worker, use dependencies instead
+
+	_waiters.fetch_add(1);
+	for (ui32 unfinished; (unfinished = _unfinishedNodes.load()) != 0; )
+	{
+		Futex::Wait(_unfinishedNodes, unfinished);
+	}
+	_waiters.fetch_sub(1);
+
+	// the last finished task might still be waking us up, the graph can be destroyed only after it's done with it
+	while (_finishingNodes.load(std::memory_order_acquire) != 0)
+	{
+		CPU_PAUSE();
+	}
+}
+
+void TaskGraph::Reset()
+{
+	ASSUME(_unfinishedNodes.load() == 0);
+	std::scoped_lock lock(_nodesLock);
+	_nodes.clear();
+}
+
+uiw TaskGraph::TasksCount() const
+{
+	std::scoped_lock lock(_nodesLock);
+	return _nodes.size();
+}
+
+auto TaskGraph::AddNode(Work &&work, const TaskHandle *dependencies, uiw dependenciesCount, Node *parent) -> TaskHandle
+{
+	Node *node;
+	{
+		auto newNode = std::make_unique<Node>();
+		node = newNode.get();
+		std::scoped_lock lock(_nodesLock);
+		_nodes.emplace_back(std::move(newNode));
+	}
+
+	node->work = std::move(work);
+	node->parent = parent;
+	if (parent)
+	{
+		ASSUME(parent->unfinishedParts.load() > 0);
+		parent->unfinishedParts.fetch_add(1);
+	}
+	_unfinishedNodes.fetch_add(1);
+
+	node->unfinishedDependencies.fetch_add(static_cast<ui32>(dependenciesCount));
+	for (uiw index = 0; index < dependenciesCount; ++index)
+	{
+		Node *dependency = dependencies[index]._node;
+		ASSUME(dependency);
+
+		bool isAlreadyCompleted;
+		{
+			std::scoped_lock lock(dependency->lock);
+			isAlreadyCompleted = dependency->isCompleted;
+			if (!isAlreadyCompleted)
+			{
+				dependency->successors.push_back(node);
+			}
+		}
+		if (isAlreadyCompleted)
+		{
+			node->unfinishedDependencies.fetch_sub(1);
+		}
+	}
+
+	ReleaseDependency(node); // the one that was held while the dependencies were being added
+	return node;
+}
+
+void TaskGraph::ReleaseDependency(Node *node)
+{
+	if (node->unfinishedDependencies.fetch_sub(1) == 1)
+	{
+		_pool.Add<&TaskGraph::Execute>(this, node);
+	}
+}
+
+void TaskGraph::Execute(Node *node)
+{
+	node->work(*this, node);
+	node->work = nullptr; // the captures are released as soon as possible
+	FinishPart(node);
+}
+
+void TaskGraph::FinishPart(Node *node)
+{
+	if (node->unfinishedParts.fetch_sub(1) != 1)
+	{
+		return;
+	}
+
+	// the work and all the children are done, the node is completed
+	std::vector<Node *> successors;
+	{
+		std::scoped_lock lock(node->lock);
+		node->isCompleted = true;
+		successors.swap(node->successors);
+	}
+	for (Node *successor : successors)
+	{
+		ReleaseDependency(successor);
+	}
+
+	if (node->parent)
+	{
+		FinishPart(node->parent);
+	}
+
+	_finishingNodes.fetch_add(1);
+	if (_unfinishedNodes.fetch_sub(1) == 1 && _waiters.load() != 0)
+	{
+		Futex::WakeAll(_unfinishedNodes);
+	}
+	_finishingNodes.fetch_sub(1, std::memory_order_release); // the graph must not be touched after this
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+namespace StdLib
+{
+	/* Tasks are executed on a ThreadPool as soon as all their dependencies have completed, the graph can be extended
+	   at any moment, including from the tasks themselves.
+	   A task can fork children with AddChild, the task is considered completed only after its own work and all its
+	   children have completed, so its dependents and continuations serve as the join without blocking any worker.
+	   The work is a callable that either takes no arguments or takes (TaskGraph &, TaskGraph::TaskHandle self),
+	   the latter is needed to add children.
+	   Don't call Wait from the tasks, express the waiting through dependencies instead.
+	*/
+	class TaskGraph
+	{
+		struct Node;
+
+	public:
+		class TaskHandle
+		{
+			friend TaskGraph;
+			Node *_node = nullptr;
+
+			TaskHandle(Node *node) : _node(node)
+			{}
+
+		public:
+			TaskHandle() = default;
+
+			[[nodiscard]] bool IsValid() const
+			{
+				return _node != nullptr;
+			}
+		};
+
+	private:
+		using Work = std::function<void(TaskGraph &, TaskHandle)>;
+
+		struct Node
+		{
+			Work work{};
+			Node *parent = nullptr;
+			std::atomic<ui32> unfinishedDependencies{1}; // the extra one is held while the node is being added
+			std::atomic<ui32> unfinishedParts{1}; // the node's own work and its children
+			SpinLock lock{};
+			bool isCompleted = false; // guarded by lock
+			std::vector<Node *> successors{}; // guarded by lock
+		};
+
+		ThreadPool &_pool;
+		SpinLock _nodesLock{};
+		std::vector<std::unique_ptr<Node>> _nodes{};
+		alignas(64) std::atomic<ui32> _unfinishedNodes{0};
+		std::atomic<ui32> _waiters{0};
+		std::atomic<ui32> _finishingNodes{0}; // nodes that are still touching the graph after they've been counted as finished
+
+	public:
+		explicit TaskGraph(ThreadPool &pool);
+		~TaskGraph(); // waits for all the tasks to complete
+		TaskGraph(const TaskGraph &) = delete;
+		TaskGraph &operator = (const TaskGraph &) = delete;
+
+		// the dependencies may already be completed, in that case they're ignored
+		template <typename F> TaskHandle Add(F &&work, std::initializer_list<TaskHandle> dependencies = {})
+		{
+			return AddNode(MakeWork(std::forward<F>(work)), dependencies.begin(), dependencies.size(), nullptr);
+		}
+
+		template <typename F> TaskHandle Add(F &&work, const TaskHandle *dependencies, uiw dependenciesCount)
+		{
+			return AddNode(MakeWork(std::forward<F>(work)), dependencies, dependenciesCount, nullptr);
+		}
+
+		// the parent must not be completed yet, so it's usually called from the parent's own work or from its other children
+		template <typename F> TaskHandle AddChild(TaskHandle parent, F &&work, std::initializer_list<TaskHandle> dependencies = {})
+		{
+			ASSUME(parent.IsValid());
+			return AddNode(MakeWork(std::forward<F>(work)), dependencies.begin(), dependencies.size(), parent._node);
+		}
+
+		// runs after the task and all its children have completed
+		template <typename F> TaskHandle Then(TaskHandle task, F &&work)
+		{
+			return Add(std::forward<F>(work), {task});
+		}
+
+		void Wait(); // blocks until every added task has completed
+		void Reset(); // releases the completed tasks, the handles become invalid, there must be no unfinished tasks
+		[[nodiscard]] uiw TasksCount() const;
+
+	private:
+		template <typename F> static Work MakeWork(F &&work)
+		{
+			if constexpr (std::is_invocable_v<F &, TaskGraph &, TaskHandle>)
+			{
+				return Work(std::forward<F>(work));
+			}
+			else
+			{
+				return [work = std::forward<F>(work)](TaskGraph &, TaskHandle) mutable { work(); };
+			}
+		}
+
+		TaskHandle AddNode(Work &&work, const TaskHandle *dependencies, uiw dependenciesCount, Node *parent);
+		void ReleaseDependency(Node *node);
+		void Execute(Node *node);
+		void FinishPart(Node *node);
+	};
+}
\ No newline at end of file
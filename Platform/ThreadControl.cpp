@@ -0,0 +1,104 @@
+#include "_PreHeader.hpp"
+#include "ThreadControl.hpp"
+#include "SystemInfo.hpp"
+
+using namespace StdLib;
+using namespace ThreadControl;
+
+CPUSet::CPUSet(std::initializer_list<ui32> cores)
+{
+	for (ui32 core : cores)
+	{
+		Add(core);
+	}
+}
+
+CPUSet CPUSet::All()
+{
+	CPUSet set;
+	ui32 count = std::min(SystemInfo::LogicalCPUCores(), MaxCores);
+	for (ui32 core = 0; core < count; ++core)
+	{
+		set.Add(core);
+	}
+	return set;
+}
+
+CPUSet CPUSet::Single(ui32 core)
+{
+	CPUSet set;
+	set.Add(core);
+	return set;
+}
+
+CPUSet &CPUSet::Add(ui32 core)
+{
+	ASSUME(core < MaxCores);
+	_cores.set(core);
+	return *this;
+}
+
+CPUSet &CPUSet::Remove(ui32 core)
+{
+	ASSUME(core < MaxCores);
+	_cores.reset(core);
+	return *this;
+}
+
+bool CPUSet::Contains(ui32 core) const
+{
+	return core < MaxCores && _cores.test(core);
+}
+
+ui32 CPUSet::Count() const
+{
+	return static_cast<ui32>(_cores.count());
+}
+
+bool CPUSet::IsEmpty() const
+{
+	return _cores.none();
+}
+
+std::optional<ui32> CPUSet::First() const
+{
+	for (ui32 core = 0; core < MaxCores; ++core)
+	{
+		if (_cores.test(core))
+		{
+			return core;
+		}
+	}
+	return std::nullopt;
+}
+
+CPUSet CPUSet::Combined(const CPUSet &other) const
+{
+	CPUSet result;
+	result._cores = _cores | other._cores;
+	return result;
+}
+
+CPUSet CPUSet::Intersection(const CPUSet &other) const
+{
+	CPUSet result;
+	result._cores = _cores & other._cores;
+	return result;
+}
+
+CPUSet CPUSet::Excluded(const CPUSet &other) const
+{
+	CPUSet result;
+	result._cores = _cores & ~other._cores;
+	return result;
+}
+
+bool CPUSet::operator == (const CPUSet &other) const
+{
+	return _cores == other._cores;
+}
+
+bool CPUSet::operator != (const CPUSet &other) const
+{
+	return _cores != other._cores;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <bitset>
+#include <thread>
+
+namespace StdLib::ThreadControl
+{
+	/*
+	Cores are the logical cores in the same order SystemInfo::LogicalCPUCores counts them.
+	Every function has an overload for the calling thread and one for a std::thread that hasn't been joined or detached.
+	Affinity is supported on Windows (only the first 64 cores, processor groups aren't supported), Linux and Android,
+	  other platforms return Unsupported.
+	Names longer than MaxNameLength are truncated because that's the limit on Linux. Windows requires Windows 10 1607 or
+	  later, returns Unsupported on older versions. macOS and iOS can only name the calling thread.
+	Policies:
+	  Normal, Batch and Idle are the time-sharing policies (SCHED_OTHER, SCHED_BATCH and SCHED_IDLE on Linux), the priority is
+	    applied as a nice value on Linux and Android, which is possible only for the calling thread, for another thread only
+	    Priority::Normal is accepted. Idle ignores the priority. Windows doesn't have Batch, Idle uses THREAD_PRIORITY_IDLE.
+	  FIFO and RoundRobin are the POSIX real-time policies, the priorities are spread over the policy's range, they usually
+	    require elevated privileges, Windows returns Unsupported for them.
+	CoresSharingCache and SiblingCores use the topology that SystemInfo::AcquireCacheInfo is built from, use them to keep
+	  cooperating threads on the cores that share a cache and to keep noisy threads away from the latency-critical ones.
+	*/
+
+	class CPUSet
+	{
+	public:
+		static constexpr ui32 MaxCores = 1024;
+
+	private:
+		std::bitset<MaxCores> _cores{};
+
+	public:
+		CPUSet() = default;
+		CPUSet(std::initializer_list<ui32> cores);
+
+		[[nodiscard]] static CPUSet All(); // every core the system has
+		[[nodiscard]] static CPUSet Single(ui32 core);
+
+		CPUSet &Add(ui32 core);
+		CPUSet &Remove(ui32 core);
+		[[nodiscard]] bool Contains(ui32 core) const;
+		[[nodiscard]] ui32 Count() const;
+		[[nodiscard]] bool IsEmpty() const;
+		[[nodiscard]] std::optional<ui32> First() const;
+
+		[[nodiscard]] CPUSet Combined(const CPUSet &other) const;
+		[[nodiscard]] CPUSet Intersection(const CPUSet &other) const;
+		[[nodiscard]] CPUSet Excluded(const CPUSet &other) const; // the cores that aren't in other
+
+		[[nodiscard]] bool operator == (const CPUSet &other) const;
+		[[nodiscard]] bool operator != (const CPUSet &other) const;
+	};
+
+	enum class Policy : ui8
+	{
+		Normal, Batch, Idle, FIFO, RoundRobin
+	};
+
+	enum class Priority : ui8
+	{
+		Lowest, Low, Normal, High, Highest
+	};
+
+	constexpr uiw MaxNameLength = 15;
+
+	Error<> AffinitySet(const CPUSet &cores);
+	Error<> AffinitySet(std::thread &thread, const CPUSet &cores);
+	[[nodiscard]] Result<CPUSet> AffinityGet();
+	[[nodiscard]] Result<CPUSet> AffinityGet(std::thread &thread);
+
+	Error<> NameSet(std::string_view name);
+	Error<> NameSet(std::thread &thread, std::string_view name);
+
+	Error<> SchedulingSet(Policy policy, Priority priority = Priority::Normal);
+	Error<> SchedulingSet(std::thread &thread, Policy policy, Priority priority = Priority::Normal);
+
+	// the cores that share the cache of the specified level with the core, including the core itself,
+	// only the core itself if the topology isn't known
+	[[nodiscard]] CPUSet CoresSharingCache(ui32 core, ui32 cacheLevel);
+
+	// the logical cores that share the physical core with the core (SMT siblings), including the core itself
+	[[nodiscard]] CPUSet SiblingCores(ui32 core);
+
+	// the core the calling thread is running on, it can change at any moment unless the thread is pinned
+	[[nodiscard]] std::optional<ui32> CurrentCore();
+}
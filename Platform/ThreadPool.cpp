@@ -0,0 +1,259 @@
+#include "_PreHeader.hpp"
+#include "ThreadPool.hpp"
+#include "SystemInfo.hpp"
+#include "ThreadControl.hpp"
+#include <Futex.hpp>
+
+using namespace StdLib;
+
+namespace
+{
+	constexpr ui32 IdleSpinsBeforeSleep = 64;
+	constexpr ui64 PendingTaskUnit = 1ull << 32; // the pending tasks are in the high half of ThreadPool::_tasksState
+
+	thread_local const ThreadPool *CurrentPool = nullptr;
+	thread_local ui32 CurrentWorker = 0;
+}
+
+ThreadPool::ThreadPool(ui32 threadsCount, bool isPinningThreads)
+{
+	if (threadsCount == 0)
+	{
+		threadsCount = std::max(SystemInfo::LogicalCPUCores(), 1u);
+	}
+
+	// all the deques must exist before any worker starts stealing
+	_workers.reserve(threadsCount);
+	for (ui32 index = 0; index < threadsCount; ++index)
+	{
+		_workers.emplace_back(std::make_unique<Worker>());
+	}
+	for (ui32 index = 0; index < threadsCount; ++index)
+	{
+		_workers[index]->thread = std::thread(&ThreadPool::WorkerLoop, this, index, isPinningThreads);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	WaitIdle();
+
+	_isStopping.store(true);
+	_wakeEpoch.fetch_add(1);
+	Futex::WakeAll(_wakeEpoch);
+
+	for (auto &worker : _workers)
+	{
+		worker->thread.join();
+	}
+}
+
+void ThreadPool::WaitIdle()
+{
+	if (CurrentPool == this)
+	{
+		// the calling task is pending too, so are the tasks that wait here on the other workers,
+		// waiting for them would never end, so only the rest is waited for
+		_tasksState.fetch_add(1);
+		for (;;)
+		{
+			ui64 state = _tasksState.load(std::memory_order_acquire);
+			if ((state >> 32) == (state & ui32_max))
+			{
+				break;
+			}
+			if (Task *task = FindTask(CurrentWorker))
+			{
+				Run(task);
+			}
+			else
+			{
+				CPU_PAUSE();
+			}
+		}
+		_tasksState.fetch_sub(1);
+		return;
+	}
+
+	_idleWaiters.fetch_add(1);
+	for (;;)
+	{
+		ui32 epoch = _idleEpoch.load();
+		if (_tasksState.load() >> 32 == 0)
+		{
+			break;
+		}
+		Futex::Wait(_idleEpoch, epoch);
+	}
+	_idleWaiters.fetch_sub(1);
+}
+
+ui32 ThreadPool::ThreadsCount() const
+{
+	return static_cast<ui32>(_workers.size());
+}
+
+std::optional<ui32> ThreadPool::CurrentWorkerIndex() const
+{
+	if (CurrentPool == this)
+	{
+		return CurrentWorker;
+	}
+	return std::nullopt;
+}
+
+void ThreadPool::Submit(Task *task)
+{
+	_tasksState.fetch_add(PendingTaskUnit, std::memory_order_relaxed);
+
+	if (CurrentPool == this)
+	{
+		_workers[CurrentWorker]->tasks.Push(task);
+	}
+	else
+	{
+		std::scoped_lock lock(_injectedLock);
+		if (_injectedLast)
+		{
+			_injectedLast->nextTask = task;
+		}
+		else
+		{
+			_injectedFirst = task;
+		}
+		_injectedLast = task;
+		_injectedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// pairs with the fence in WorkerLoop, either we see the sleeping worker or it sees the new task
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (_sleepingWorkers.load(std::memory_order_relaxed) != 0)
+	{
+		_wakeEpoch.fetch_add(1, std::memory_order_relaxed);
+		Futex::WakeOne(_wakeEpoch);
+	}
+}
+
+void ThreadPool::WorkerLoop(ui32 workerIndex, bool isPinning)
+{
+	CurrentPool = this;
+	CurrentWorker = workerIndex;
+
+	if (isPinning)
+	{
+		ui32 core = workerIndex % std::max(SystemInfo::LogicalCPUCores(), 1u);
+		[[maybe_unused]] Error<> error = ThreadControl::AffinitySet(ThreadControl::CPUSet::Single(core)); // unsupported platforms are silently ignored
+	}
+
+	for (ui32 idleSpins = 0;;)
+	{
+		if (Task *task = FindTask(workerIndex))
+		{
+			Run(task);
+			idleSpins = 0;
+			continue;
+		}
+
+		if (_isStopping.load(std::memory_order_acquire))
+		{
+			break;
+		}
+
+		if (++idleSpins < IdleSpinsBeforeSleep)
+		{
+			CPU_PAUSE();
+			continue;
+		}
+
+		ui32 epoch = _wakeEpoch.load(std::memory_order_relaxed);
+		_sleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!HasVisibleWork() && !_isStopping.load(std::memory_order_relaxed))
+		{
+			Futex::Wait(_wakeEpoch, epoch);
+		}
+		_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+		idleSpins = 0;
+	}
+
+	CurrentPool = nullptr;
+}
+
+auto ThreadPool::FindTask(ui32 workerIndex) -> Task *
+{
+	if (auto task = _workers[workerIndex]->tasks.Pop())
+	{
+		return *task;
+	}
+
+	if (Task *task = TakeInjected())
+	{
+		return task;
+	}
+
+	// steal from the others starting with the next worker, so the thieves don't all go after the same victim
+	uiw workersCount = _workers.size();
+	for (uiw offset = 1; offset < workersCount; ++offset)
+	{
+		if (auto task = _workers[(workerIndex + offset) % workersCount]->tasks.Steal())
+		{
+			return *task;
+		}
+	}
+
+	return nullptr;
+}
+
+auto ThreadPool::TakeInjected() -> Task *
+{
+	if (_injectedCount.load(std::memory_order_relaxed) == 0)
+	{
+		return nullptr;
+	}
+
+	std::scoped_lock lock(_injectedLock);
+	Task *task = _injectedFirst;
+	if (task)
+	{
+		_injectedFirst = task->nextTask;
+		if (_injectedFirst == nullptr)
+		{
+			_injectedLast = nullptr;
+		}
+		_injectedCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return task;
+}
+
+bool ThreadPool::HasVisibleWork() const
+{
+	if (_injectedCount.load(std::memory_order_relaxed) != 0)
+	{
+		return true;
+	}
+	for (const auto &worker : _workers)
+	{
+		if (!worker->tasks.IsEmptyApprox())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::Run(Task *task)
+{
+	uiw size = task->allocatedSize; // the task is destroyed by Execute
+	task->Execute(Task::Action::ProcessAndDestroy);
+	MessagePool::Free(task, size);
+
+	if (_tasksState.fetch_sub(PendingTaskUnit, std::memory_order_acq_rel) >> 32 == 1)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (_idleWaiters.load(std::memory_order_relaxed) != 0)
+		{
+			_idleEpoch.fetch_add(1, std::memory_order_relaxed);
+			Futex::WakeAll(_idleEpoch);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Message.hpp>
+#include <MessagePool.hpp>
+#include <SpinLock.hpp>
+#include <WorkStealingDeque.hpp>
+#include <thread>
+
+namespace StdLib
+{
+	/* Every worker owns a work stealing deque, tasks added from a worker go to its own deque and are executed in LIFO order,
+	   idle workers steal the oldest tasks from the others. Tasks added from outside the pool go to a shared injection list.
+	   Workers that can't find anything to do spin for a bit and then sleep on a futex, adding a task wakes a sleeping worker
+	   only if there is one.
+	   Tasks use the same delegate types as MTMessageQueue and are allocated from MessagePool.
+	   threadsCount 0 means SystemInfo::LogicalCPUCores, pinned workers are bound to cores in order
+	   (silently ignored on platforms that don't support it).
+	   The destructor waits for all the tasks to finish.
+	*/
+	class ThreadPool
+	{
+		struct TaskHeader
+		{
+			MessageBase<TaskHeader> *nextTask = nullptr; // used only by the injection list
+			ui32 allocatedSize = 0;
+		};
+
+		using Task = MessageBase<TaskHeader>;
+
+		struct alignas(64) Worker
+		{
+			WorkStealingDeque<Task *> tasks{};
+			std::thread thread{};
+		};
+
+		std::vector<std::unique_ptr<Worker>> _workers{};
+		SpinLock _injectedLock{};
+		Task *_injectedFirst{}, *_injectedLast{};
+		std::atomic<ui32> _injectedCount{0}; // lets the workers check the injection list without locking it
+		// the tasks that are added but not yet finished in the high half, the tasks that called WaitIdle from a worker in the low half,
+		// WaitIdle compares them, so they must be read together
+		alignas(64) std::atomic<ui64> _tasksState{0};
+		std::atomic<ui32> _idleEpoch{0}; // incremented when the last pending task finishes, WaitIdle from outside of the pool sleeps on it
+		std::atomic<ui32> _idleWaiters{0};
+		alignas(64) std::atomic<ui32> _wakeEpoch{0};
+		std::atomic<ui32> _sleepingWorkers{0};
+		std::atomic<bool> _isStopping{false};
+
+	public:
+		explicit ThreadPool(ui32 threadsCount = 0, bool isPinningThreads = false);
+		~ThreadPool();
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator = (const ThreadPool &) = delete;
+
+		template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> void Add(Caller &&caller, VArgs &&... args)
+		{
+			using taskType = MessageDelegate<TaskHeader, Caller, Method, VArgs...>;
+			Submit(AllocateTask<taskType>(std::forward<Caller>(caller), std::forward<VArgs>(args)...));
+		}
+
+		template <auto Func, typename... VArgs> void Add(VArgs &&... args)
+		{
+			using taskType = MessageFuncInline<TaskHeader, Func, VArgs...>;
+			Submit(AllocateTask<taskType>(std::forward<VArgs>(args)...));
+		}
+
+		template <typename FuncType, typename... VArgs> void Add(FuncType func, VArgs &&... args)
+		{
+			using taskType = MessageFuncPointer<TaskHeader, FuncType, VArgs...>;
+			Submit(AllocateTask<taskType>(func, std::forward<VArgs>(args)...));
+		}
+
+		// blocks until every added task has finished, including the tasks added by the tasks,
+		// if it's called from a task, the worker keeps executing other tasks while waiting, and the tasks
+		// that are themselves waiting in WaitIdle (including the calling one) aren't waited for
+		void WaitIdle();
+
+		[[nodiscard]] ui32 ThreadsCount() const;
+
+		// returns the index of the calling worker thread, nullopt if it isn't one of this pool's workers
+		[[nodiscard]] std::optional<ui32> CurrentWorkerIndex() const;
+
+	private:
+		template <typename T, typename... Args> static T *AllocateTask(Args &&... args)
+		{
+			T *task = MessagePool::New<T>(std::forward<Args>(args)...);
+			task->allocatedSize = sizeof(T);
+			return task;
+		}
+
+		void Submit(Task *task);
+		void WorkerLoop(ui32 workerIndex, bool isPinning);
+		[[nodiscard]] Task *FindTask(ui32 workerIndex);
+		[[nodiscard]] Task *TakeInjected();
+		[[nodiscard]] bool HasVisibleWork() const;
+		void Run(Task *task);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,540 @@
+#include "_PreHeader.hpp"
+#include "TimedMessageQueue.hpp"
+
+using namespace StdLib;
+
+TimedMessageQueue::TimedMessageQueue(TimeDifference resolution) : _start(TimeMoment::Now()), _tickUSec(std::max<i64>(resolution.ToUSec_i64(), 1))
+{
+	_slots.fill(InvalidIndex);
+}
+
+TimedMessageQueue::~TimedMessageQueue()
+{
+	Clear();
+}
+
+bool TimedMessageQueue::Cancel(TimerHandle handle)
+{
+	Message *message;
+
+	{
+		std::scoped_lock lock{_mutex};
+
+		if (handle._index >= _timers.size())
+		{
+			return false;
+		}
+		Timer &timer = _timers[handle._index];
+		if (timer.generation != handle._generation || timer.state == TimerState::Free || timer.isCancelled)
+		{
+			return false;
+		}
+
+		if (timer.state != TimerState::Armed)
+		{
+			// the message is in the list or is being executed, whoever takes it next will destroy it
+			timer.isCancelled = true;
+			return true;
+		}
+
+		Unlink(handle._index);
+		--_armedTimers;
+		message = timer.message;
+		FreeTimer(handle._index);
+	}
+
+	DestroyMessage(message);
+	return true;
+}
+
+void TimedMessageQueue::ExecWait()
+{
+	Message *message;
+	Message *cancelledMessages = nullptr;
+
+	{
+		std::unique_lock lock{_mutex};
+		for (;;)
+		{
+			Collect(TicksUntil(TimeMoment::Now(), false));
+			message = TakeMessage(cancelledMessages);
+			if (message)
+			{
+				break;
+			}
+
+			ui64 nextTick = _armedTimers ? NextEventTick() : ui64_max;
+			_wakeTick = std::min(_wakeTick, nextTick);
+			++_sleepingConsumers;
+			if (nextTick == ui64_max)
+			{
+				_newWorkNotifier.wait(lock);
+			}
+			else
+			{
+				TimeMoment deadline = _start + TimeDifference(TimeMicroSecondsI64(static_cast<i64>(nextTick) * _tickUSec));
+				i64 remaining = (deadline - TimeMoment::Now()).ToUSec_i64();
+				if (remaining > 0)
+				{
+					_newWorkNotifier.wait_for(lock, std::chrono::microseconds(remaining));
+				}
+			}
+			if (--_sleepingConsumers == 0)
+			{
+				_wakeTick = ui64_max;
+			}
+		}
+	}
+
+	DestroyMessages(cancelledMessages);
+	Execute(message);
+}
+
+bool TimedMessageQueue::ExecNoWait()
+{
+	Message *message;
+	Message *cancelledMessages = nullptr;
+
+	{
+		std::scoped_lock lock{_mutex};
+		Collect(TicksUntil(TimeMoment::Now(), false));
+		message = TakeMessage(cancelledMessages);
+	}
+
+	DestroyMessages(cancelledMessages);
+	if (message == nullptr)
+	{
+		return false;
+	}
+	Execute(message);
+	return true;
+}
+
+void TimedMessageQueue::Clear()
+{
+	Message *message;
+
+	{
+		std::scoped_lock lock{_mutex};
+
+		message = _firstMessage;
+		_firstMessage = _lastMessage = nullptr;
+
+		// the timer messages in the list are destroyed along with the rest, so their timers are released
+		for (Message *current = message; current; current = current->nextMessage)
+		{
+			if (current->timer != InvalidIndex)
+			{
+				FreeTimer(current->timer);
+			}
+		}
+
+		for (ui32 index = 0; index < _timers.size(); ++index)
+		{
+			Timer &timer = _timers[index];
+			if (timer.state == TimerState::Armed)
+			{
+				timer.message->nextMessage = message;
+				message = timer.message;
+				FreeTimer(index);
+			}
+			else if (timer.state == TimerState::Executing)
+			{
+				timer.isCancelled = true;
+			}
+		}
+
+		_slots.fill(InvalidIndex);
+		_armedTimers = 0;
+	}
+
+	DestroyMessages(message);
+}
+
+uiw TimedMessageQueue::ArmedTimersCount() const
+{
+	std::scoped_lock lock{_mutex};
+	return _armedTimers;
+}
+
+void TimedMessageQueue::DestroyMessage(Message *message)
+{
+	uiw size = message->allocatedSize;
+	message->Execute(Message::Action::Destroy);
+	MessagePool::Free(message, size);
+}
+
+void TimedMessageQueue::DestroyMessages(Message *message)
+{
+	while (message)
+	{
+		Message *nextMessage = message->nextMessage;
+		DestroyMessage(message);
+		message = nextMessage;
+	}
+}
+
+void TimedMessageQueue::Post(Message *message)
+{
+	std::scoped_lock lock{_mutex};
+	PostLocked(message);
+	if (_sleepingConsumers)
+	{
+		_newWorkNotifier.notify_all();
+	}
+}
+
+auto TimedMessageQueue::Arm(Message *message, TimeMoment when, std::optional<TimeDifference> period) -> TimerHandle
+{
+	ui64 expiresTick = TicksUntil(when, true);
+	ui64 periodTicks = 0;
+	if (period)
+	{
+		periodTicks = std::max<ui64>((period->ToUSec_i64() + _tickUSec - 1) / _tickUSec, 1);
+	}
+
+	std::scoped_lock lock{_mutex};
+
+	ui32 timerIndex = AllocateTimer();
+	Timer &timer = _timers[timerIndex];
+	timer.message = message;
+	timer.expiresTick = expiresTick;
+	timer.periodTicks = periodTicks;
+	timer.state = TimerState::Armed;
+	timer.isCancelled = false;
+	message->timer = timerIndex;
+
+	TimerHandle handle{timerIndex, timer.generation};
+	Schedule(timerIndex);
+	return handle;
+}
+
+void TimedMessageQueue::Execute(Message *message)
+{
+	ui32 timerIndex = message->timer;
+	bool isCancelled = false;
+	bool isPeriodic = false;
+
+	if (timerIndex != InvalidIndex)
+	{
+		std::scoped_lock lock{_mutex};
+		Timer &timer = _timers[timerIndex];
+		isCancelled = timer.isCancelled;
+		isPeriodic = timer.periodTicks != 0;
+		if (isCancelled || !isPeriodic)
+		{
+			// a one shot timer can't be cancelled once its message starts executing
+			FreeTimer(timerIndex);
+		}
+	}
+
+	if (isCancelled)
+	{
+		DestroyMessage(message);
+		return;
+	}
+
+	if (!isPeriodic)
+	{
+		uiw size = message->allocatedSize; // the message is destroyed by Execute
+		message->Execute(Message::Action::ProcessAndDestroy);
+		MessagePool::Free(message, size);
+		return;
+	}
+
+	message->Execute(Message::Action::Process);
+
+	{
+		std::scoped_lock lock{_mutex};
+		Timer &timer = _timers[timerIndex];
+		if (timer.isCancelled)
+		{
+			FreeTimer(timerIndex);
+			timerIndex = InvalidIndex;
+		}
+		else
+		{
+			// the next execution is counted from the previous deadline, the periods that are already missed are skipped
+			ui64 nowTick = TicksUntil(TimeMoment::Now(), false);
+			ui64 nextTick = timer.expiresTick + timer.periodTicks;
+			if (nextTick <= nowTick)
+			{
+				nextTick += ((nowTick - nextTick) / timer.periodTicks + 1) * timer.periodTicks;
+			}
+			timer.expiresTick = nextTick;
+			timer.state = TimerState::Armed;
+			Schedule(timerIndex);
+		}
+	}
+	if (timerIndex == InvalidIndex)
+	{
+		DestroyMessage(message);
+	}
+}
+
+auto TimedMessageQueue::TakeMessage(Message *&cancelledMessages) -> Message *
+{
+	while (Message *message = _firstMessage)
+	{
+		_firstMessage = message->nextMessage;
+		if (_firstMessage == nullptr)
+		{
+			_lastMessage = nullptr;
+		}
+		message->nextMessage = nullptr;
+
+		if (message->timer == InvalidIndex)
+		{
+			return message;
+		}
+
+		Timer &timer = _timers[message->timer];
+		if (!timer.isCancelled)
+		{
+			timer.state = TimerState::Executing;
+			return message;
+		}
+
+		// the timer was cancelled after it became due, the message is destroyed by the caller once the lock is released
+		FreeTimer(message->timer);
+		message->nextMessage = cancelledMessages;
+		cancelledMessages = message;
+	}
+	return nullptr;
+}
+
+ui64 TimedMessageQueue::TicksUntil(TimeMoment moment, bool isRoundingUp) const
+{
+	TimeDifference difference = moment - _start;
+	i64 usec = difference.ToUSec_i64();
+	if (isRoundingUp && TimeDifference(TimeMicroSecondsI64(usec)) < difference)
+	{
+		++usec; // the fraction of a microsecond must not make the timer early
+	}
+	if (usec <= 0)
+	{
+		return 0;
+	}
+	return static_cast<ui64>(isRoundingUp ? (usec + _tickUSec - 1) / _tickUSec : usec / _tickUSec);
+}
+
+void TimedMessageQueue::PostLocked(Message *message)
+{
+	if (_lastMessage)
+	{
+		_lastMessage->nextMessage = message;
+	}
+	else
+	{
+		_firstMessage = message;
+	}
+	_lastMessage = message;
+}
+
+void TimedMessageQueue::Schedule(ui32 timerIndex)
+{
+	ui64 expiresTick = _timers[timerIndex].expiresTick;
+	if (expiresTick < _currentTick)
+	{
+		// the ticks up to the deadline have already been processed, so it wouldn't be found in the wheel until the next tick
+		Fire(timerIndex);
+		expiresTick = 0;
+	}
+	else
+	{
+		Place(timerIndex);
+		++_armedTimers;
+	}
+
+	if (_sleepingConsumers && expiresTick < _wakeTick)
+	{
+		_newWorkNotifier.notify_all();
+	}
+}
+
+void TimedMessageQueue::Fire(ui32 timerIndex)
+{
+	Timer &timer = _timers[timerIndex];
+	PostLocked(timer.message);
+	timer.state = TimerState::Ready; // the timer stays allocated so the message can still be cancelled
+}
+
+// a timer goes to the finest level that can hold its distance from the current tick, it's cascaded to the finer
+// levels when the current tick reaches its slot, the slot of the finest level is the exact deadline
+void TimedMessageQueue::Place(ui32 timerIndex)
+{
+	Timer &timer = _timers[timerIndex];
+
+	ui64 expiresTick = std::max(timer.expiresTick, _currentTick);
+	ui64 distance = expiresTick - _currentTick;
+	ui32 level = 0;
+	while (level + 1 < LevelsCount && distance >= (1ull << (SlotBits * (level + 1))))
+	{
+		++level;
+	}
+	if (distance >= (1ull << (SlotBits * LevelsCount)))
+	{
+		expiresTick = _currentTick + (1ull << (SlotBits * LevelsCount)) - 1; // gets placed again when it's cascaded
+	}
+
+	ui32 slot = level * SlotsPerLevel + static_cast<ui32>((expiresTick >> (SlotBits * level)) & (SlotsPerLevel - 1));
+	timer.slot = slot;
+	timer.previous = InvalidIndex;
+	timer.next = _slots[slot];
+	if (timer.next != InvalidIndex)
+	{
+		_timers[timer.next].previous = timerIndex;
+	}
+	_slots[slot] = timerIndex;
+}
+
+void TimedMessageQueue::Unlink(ui32 timerIndex)
+{
+	Timer &timer = _timers[timerIndex];
+	if (timer.previous != InvalidIndex)
+	{
+		_timers[timer.previous].next = timer.next;
+	}
+	else
+	{
+		_slots[timer.slot] = timer.next;
+	}
+	if (timer.next != InvalidIndex)
+	{
+		_timers[timer.next].previous = timer.previous;
+	}
+}
+
+void TimedMessageQueue::Collect(ui64 nowTick)
+{
+	// the ticks without anything to expire or cascade are skipped
+	while (_currentTick <= nowTick)
+	{
+		ui64 nextTick = _armedTimers ? NextEventTick() : ui64_max;
+		if (nextTick > nowTick)
+		{
+			_currentTick = nowTick + 1;
+			break;
+		}
+		_currentTick = nextTick;
+		ProcessTick();
+	}
+}
+
+void TimedMessageQueue::ProcessTick()
+{
+	ui64 tick = _currentTick;
+	ui32 slotIndex = static_cast<ui32>(tick & (SlotsPerLevel - 1));
+
+	// the coarser levels are cascaded before the finest slot is expired, so the timers that are due right now get there in time
+	if (slotIndex == 0)
+	{
+		for (ui32 level = 1; level < LevelsCount; ++level)
+		{
+			ui32 levelSlotIndex = static_cast<ui32>((tick >> (SlotBits * level)) & (SlotsPerLevel - 1));
+			Cascade(level, levelSlotIndex);
+			if (levelSlotIndex != 0)
+			{
+				break;
+			}
+		}
+	}
+
+	// the list is built by pushing to the front, it's reversed so the timers that were armed first are posted first
+	ui32 timerIndex = std::exchange(_slots[slotIndex], InvalidIndex);
+	ui32 reversed = InvalidIndex;
+	while (timerIndex != InvalidIndex)
+	{
+		ui32 next = _timers[timerIndex].next;
+		_timers[timerIndex].next = reversed;
+		reversed = timerIndex;
+		timerIndex = next;
+	}
+
+	for (timerIndex = reversed; timerIndex != InvalidIndex; )
+	{
+		ui32 next = _timers[timerIndex].next;
+		--_armedTimers;
+		Fire(timerIndex);
+		timerIndex = next;
+	}
+
+	_currentTick = tick + 1;
+}
+
+void TimedMessageQueue::Cascade(ui32 level, ui32 slotIndex)
+{
+	ui32 timerIndex = std::exchange(_slots[level * SlotsPerLevel + slotIndex], InvalidIndex);
+	while (timerIndex != InvalidIndex)
+	{
+		ui32 next = _timers[timerIndex].next;
+		Place(timerIndex);
+		timerIndex = next;
+	}
+}
+
+ui64 TimedMessageQueue::NextEventTick() const
+{
+	ui64 result = ui64_max;
+
+	// the finest level holds the timers that are due within the next SlotsPerLevel ticks, each in the slot of its deadline
+	for (ui32 offset = 0; offset < SlotsPerLevel; ++offset)
+	{
+		if (_slots[(_currentTick + offset) & (SlotsPerLevel - 1)] != InvalidIndex)
+		{
+			result = _currentTick + offset;
+			break;
+		}
+	}
+
+	// a coarser level's slots are cascaded one by one at the multiples of the level's span
+	for (ui32 level = 1; level < LevelsCount; ++level)
+	{
+		ui64 span = 1ull << (SlotBits * level);
+		ui64 firstCascade = (_currentTick + span - 1) & ~(span - 1);
+		if (firstCascade >= result)
+		{
+			break; // the coarser levels can't cascade any earlier than this one
+		}
+		for (ui32 offset = 0; offset < SlotsPerLevel; ++offset)
+		{
+			ui64 cascadeTick = firstCascade + offset * span;
+			if (cascadeTick >= result)
+			{
+				break;
+			}
+			if (_slots[level * SlotsPerLevel + ((cascadeTick >> (SlotBits * level)) & (SlotsPerLevel - 1))] != InvalidIndex)
+			{
+				result = cascadeTick;
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+ui32 TimedMessageQueue::AllocateTimer()
+{
+	if (_freeTimer != InvalidIndex)
+	{
+		ui32 timerIndex = _freeTimer;
+		_freeTimer = _timers[timerIndex].next;
+		return timerIndex;
+	}
+
+	ASSUME(_timers.size() < InvalidIndex);
+	_timers.emplace_back();
+	return static_cast<ui32>(_timers.size() - 1);
+}
+
+void TimedMessageQueue::FreeTimer(ui32 timerIndex)
+{
+	Timer &timer = _timers[timerIndex];
+	timer.message = nullptr;
+	timer.state = TimerState::Free;
+	timer.isCancelled = false;
+	++timer.generation; // the old handles stop matching
+	timer.next = _freeTimer;
+	_freeTimer = timerIndex;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <Message.hpp>
+#include <MessagePool.hpp>
+#include <SpinLock.hpp>
+#include "TimeMoment.hpp"
+
+namespace StdLib
+{
+	/* MTMessageQueue with delayed and periodic messages.
+	   The timers are kept in a hierarchical timing wheel (4 levels of 256 slots, the finest level has the resolution
+	   passed to the constructor), arming and cancelling a timer are O(1), the timers are moved to the finer levels
+	   as their deadlines get closer. Deadlines further than 2^32 ticks are supported, they're just cascaded more times.
+	   ExecWait sleeps until a message is added or the next timer is due, adding a timer wakes the sleeping consumers
+	   only if it's due before they would wake anyway.
+	   A timer that is due is executed in the order of its deadline relative to the other timers, but after the messages
+	   that were added before it became due. Periodic messages are executed until they're cancelled, the next execution
+	   is scheduled after the previous one has finished, missed periods are skipped.
+	*/
+	class TimedMessageQueue
+	{
+		struct MessageHeader
+		{
+			MessageBase<MessageHeader> *nextMessage = nullptr;
+			ui32 allocatedSize = 0; // messages are allocated from MessagePool, it needs the size to free them
+			ui32 timer = ui32_max; // the timer that owns the message until it's executed, periodic messages aren't destroyed after execution
+		};
+
+		using Message = MessageBase<MessageHeader>;
+
+		static constexpr ui32 InvalidIndex = ui32_max;
+		static constexpr ui32 LevelsCount = 4;
+		static constexpr ui32 SlotBits = 8;
+		static constexpr ui32 SlotsPerLevel = 1 << SlotBits;
+
+		enum class TimerState : ui8 { Free, Armed, Ready, Executing };
+
+		struct Timer
+		{
+			Message *message = nullptr;
+			ui64 expiresTick = 0;
+			ui64 periodTicks = 0; // 0 for the one shot timers
+			ui32 previous = InvalidIndex, next = InvalidIndex; // the slot list when it's armed, the free list when it's free
+			ui32 generation = 0;
+			ui32 slot = 0;
+			TimerState state = TimerState::Free;
+			bool isCancelled = false; // for timers that are ready or executing, the message is destroyed instead of being executed
+		};
+
+	public:
+		class TimerHandle
+		{
+			friend TimedMessageQueue;
+			ui32 _index = InvalidIndex;
+			ui32 _generation = 0;
+
+			TimerHandle(ui32 index, ui32 generation) : _index(index), _generation(generation)
+			{}
+
+		public:
+			TimerHandle() = default;
+
+			[[nodiscard]] bool IsValid() const
+			{
+				return _index != InvalidIndex;
+			}
+		};
+
+	private:
+		Message *_firstMessage{}, *_lastMessage{};
+		SpinLock _mutex{};
+		std::condition_variable_any _newWorkNotifier{};
+
+		TimeMoment _start{};
+		i64 _tickUSec = 1000;
+		ui64 _currentTick = 0; // the next tick to be processed
+		ui64 _wakeTick = ui64_max; // when the sleeping consumers will wake up by themselves
+		ui32 _sleepingConsumers = 0;
+		ui32 _armedTimers = 0;
+		std::array<ui32, LevelsCount * SlotsPerLevel> _slots{};
+		std::vector<Timer> _timers{};
+		ui32 _freeTimer = InvalidIndex;
+
+	public:
+		explicit TimedMessageQueue(TimeDifference resolution = TimeMilliSecondsI64(1));
+		~TimedMessageQueue();
+		TimedMessageQueue(const TimedMessageQueue &) = delete;
+		TimedMessageQueue &operator = (const TimedMessageQueue &) = delete;
+
+		template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> void Add(Caller &&caller, VArgs &&... args)
+		{
+			using messageType = MessageDelegate<MessageHeader, Caller, Method, VArgs...>;
+			Post(AllocateMessage<messageType>(std::forward<Caller>(caller), std::forward<VArgs>(args)...));
+		}
+
+		template <auto Func, typename... VArgs> void Add(VArgs &&... args)
+		{
+			using messageType = MessageFuncInline<MessageHeader, Func, VArgs...>;
+			Post(AllocateMessage<messageType>(std::forward<VArgs>(args)...));
+		}
+
+		template <typename FuncType, typename... VArgs> void Add(FuncType func, VArgs &&... args)
+		{
+			using messageType = MessageFuncPointer<MessageHeader, FuncType, VArgs...>;
+			Post(AllocateMessage<messageType>(func, std::forward<VArgs>(args)...));
+		}
+
+		// a moment in the past makes the message due immediately
+		template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> TimerHandle AddAt(TimeMoment when, Caller &&caller, VArgs &&... args)
+		{
+			using messageType = MessageDelegate<MessageHeader, Caller, Method, VArgs...>;
+			return Arm(AllocateMessage<messageType>(std::forward<Caller>(caller), std::forward<VArgs>(args)...), when, {});
+		}
+
+		template <auto Func, typename... VArgs> TimerHandle AddAt(TimeMoment when, VArgs &&... args)
+		{
+			using messageType = MessageFuncInline<MessageHeader, Func, VArgs...>;
+			return Arm(AllocateMessage<messageType>(std::forward<VArgs>(args)...), when, {});
+		}
+
+		template <typename FuncType, typename... VArgs> TimerHandle AddAt(TimeMoment when, FuncType func, VArgs &&... args)
+		{
+			using messageType = MessageFuncPointer<MessageHeader, FuncType, VArgs...>;
+			return Arm(AllocateMessage<messageType>(func, std::forward<VArgs>(args)...), when, {});
+		}
+
+		template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> TimerHandle AddAfter(TimeDifference delay, Caller &&caller, VArgs &&... args)
+		{
+			return AddAt<Method>(TimeMoment::Now() + delay, std::forward<Caller>(caller), std::forward<VArgs>(args)...);
+		}
+
+		template <auto Func, typename... VArgs> TimerHandle AddAfter(TimeDifference delay, VArgs &&... args)
+		{
+			return AddAt<Func>(TimeMoment::Now() + delay, std::forward<VArgs>(args)...);
+		}
+
+		template <typename FuncType, typename... VArgs> TimerHandle AddAfter(TimeDifference delay, FuncType func, VArgs &&... args)
+		{
+			return AddAt(TimeMoment::Now() + delay, func, std::forward<VArgs>(args)...);
+		}
+
+		// the first execution happens after one period
+		template <auto Method, typename Caller, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(Method)>>, typename... VArgs> TimerHandle AddPeriodic(TimeDifference period, Caller &&caller, VArgs &&... args)
+		{
+			using messageType = MessageDelegate<MessageHeader, Caller, Method, VArgs...>;
+			return Arm(AllocateMessage<messageType>(std::forward<Caller>(caller), std::forward<VArgs>(args)...), TimeMoment::Now() + period, period);
+		}
+
+		template <auto Func, typename... VArgs> TimerHandle AddPeriodic(TimeDifference period, VArgs &&... args)
+		{
+			using messageType = MessageFuncInline<MessageHeader, Func, VArgs...>;
+			return Arm(AllocateMessage<messageType>(std::forward<VArgs>(args)...), TimeMoment::Now() + period, period);
+		}
+
+		template <typename FuncType, typename... VArgs> TimerHandle AddPeriodic(TimeDifference period, FuncType func, VArgs &&... args)
+		{
+			using messageType = MessageFuncPointer<MessageHeader, FuncType, VArgs...>;
+			return Arm(AllocateMessage<messageType>(func, std::forward<VArgs>(args)...), TimeMoment::Now() + period, period);
+		}
+
+		// returns false if the message has already been executed or cancelled, a message that is due but
+		// hasn't been executed yet is cancelled, a periodic message that is being executed right now isn't executed again
+		bool Cancel(TimerHandle handle);
+
+		void ExecWait();
+		bool ExecNoWait(); // returns true if something had been executed
+		void Clear(); // destroys the pending messages and cancels all the timers
+
+		[[nodiscard]] uiw ArmedTimersCount() const;
+
+	private:
+		template <typename T, typename... Args> static T *AllocateMessage(Args &&... args)
+		{
+			T *message = MessagePool::New<T>(std::forward<Args>(args)...);
+			message->allocatedSize = sizeof(T);
+			return message;
+		}
+
+		static void DestroyMessage(Message *message);
+		static void DestroyMessages(Message *message); // the whole list linked with nextMessage
+
+		void Post(Message *message);
+		TimerHandle Arm(Message *message, TimeMoment when, std::optional<TimeDifference> period);
+		void Execute(Message *message);
+		[[nodiscard]] Message *TakeMessage(Message *&cancelledMessages); // the lock must be held, the skipped cancelled messages are added to cancelledMessages
+		[[nodiscard]] ui64 TicksUntil(TimeMoment moment, bool isRoundingUp) const;
+		void PostLocked(Message *message);
+
+		// the wheel, the lock must be held
+		void Schedule(ui32 timerIndex); // places the armed timer or posts it right away if it's already due
+		void Fire(ui32 timerIndex); // posts the timer's message, the timer must not be in the wheel, it's freed when the message is executed
+		void Place(ui32 timerIndex);
+		void Unlink(ui32 timerIndex);
+		void Collect(ui64 nowTick); // moves the due timers into the message list
+		void ProcessTick();
+		void Cascade(ui32 level, ui32 slotIndex);
+		[[nodiscard]] ui64 NextEventTick() const;
+		[[nodiscard]] ui32 AllocateTimer();
+		void FreeTimer(ui32 timerIndex);
+	};
+}
\ No newline at end of file
@@ -381,8 +381,8 @@ bool File::WriteToFile(const void *source, ui32 len, ui32 *written)
 	BOOL result = WriteFile(_handle, source, len, &wapiWritten, 0);
 
 	#if STDLIB_ENABLE_FILE_STATS
-		++_stats.writesToFileCount;
-		_stats.bytesToFileWritten += wapiWritten;
+		StatsAdd(&FileStats::writesToFileCount);
+		StatsAdd(&FileStats::bytesToFileWritten, wapiWritten);
 	#endif
 
     if (written) *written = wapiWritten;
@@ -399,8 +399,8 @@ bool File::ReadFromFile(void *target, ui32 len, ui32 *read)
 	BOOL result = ReadFile(_handle, target, len, &wapiRead, 0);
 
 	#if STDLIB_ENABLE_FILE_STATS
-		++_stats.readsFromFileCount;
-		_stats.bytesFromFileRead += wapiRead;
+		StatsAdd(&FileStats::readsFromFileCount);
+		StatsAdd(&FileStats::bytesFromFileRead, wapiRead);
 	#endif
 
 	if (read) *read = wapiRead;
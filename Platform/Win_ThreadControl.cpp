@@ -0,0 +1,236 @@
+#include "_PreHeader.hpp"
+#include "ThreadControl.hpp"
+#include "PlatformErrorResolve.hpp"
+
+using namespace StdLib;
+using namespace ThreadControl;
+
+namespace
+{
+	constexpr ui32 MaskCores = sizeof(DWORD_PTR) * 8;
+
+	Result<DWORD_PTR> CPUSetToMask(const CPUSet &cores)
+	{
+		if (cores.IsEmpty())
+		{
+			return DefaultError::InvalidArgument("the set of cores is empty");
+		}
+		DWORD_PTR mask = 0;
+		for (ui32 core = 0; core < CPUSet::MaxCores; ++core)
+		{
+			if (cores.Contains(core))
+			{
+				if (core >= MaskCores)
+				{
+					return DefaultError::InvalidArgument("processor groups aren't supported");
+				}
+				mask |= static_cast<DWORD_PTR>(1) << core;
+			}
+		}
+		return mask;
+	}
+
+	CPUSet CPUSetFromMask(DWORD_PTR mask)
+	{
+		CPUSet cores;
+		for (ui32 core = 0; core < MaskCores; ++core)
+		{
+			if (Funcs::IsBitSet(mask, core))
+			{
+				cores.Add(core);
+			}
+		}
+		return cores;
+	}
+
+	Error<> AffinitySetWindows(HANDLE thread, const CPUSet &cores)
+	{
+		auto mask = CPUSetToMask(cores);
+		if (!mask)
+		{
+			return mask.GetError();
+		}
+		if (!SetThreadAffinityMask(thread, mask.Unwrap()))
+		{
+			return PlatformErrorResolve("SetThreadAffinityMask failed");
+		}
+		return DefaultError::Ok();
+	}
+
+	// there's no GetThreadAffinityMask, the mask is swapped with the process one and then restored
+	Result<CPUSet> AffinityGetWindows(HANDLE thread)
+	{
+		DWORD_PTR processMask, systemMask;
+		if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+		{
+			return PlatformErrorResolve("GetProcessAffinityMask failed");
+		}
+		DWORD_PTR threadMask = SetThreadAffinityMask(thread, processMask);
+		if (!threadMask)
+		{
+			return PlatformErrorResolve("SetThreadAffinityMask failed");
+		}
+		SetThreadAffinityMask(thread, threadMask);
+		return CPUSetFromMask(threadMask);
+	}
+
+	Error<> NameSetWindows(HANDLE thread, std::string_view name)
+	{
+		// exists since Windows 10 1607
+		using type = HRESULT(WINAPI *)(HANDLE hThread, PCWSTR lpThreadDescription);
+		static type setThreadDescription = []
+		{
+			HMODULE k32 = GetModuleHandleA("kernel32.dll");
+			return k32 ? reinterpret_cast<type>(GetProcAddress(k32, "SetThreadDescription")) : nullptr;
+		}();
+		if (!setThreadDescription)
+		{
+			return DefaultError::Unsupported("SetThreadDescription isn't available");
+		}
+
+		// the names are expected to be ASCII
+		wchar_t wideName[MaxNameLength + 1];
+		uiw length = std::min(name.size(), MaxNameLength);
+		for (uiw index = 0; index < length; ++index)
+		{
+			wideName[index] = static_cast<wchar_t>(static_cast<unsigned char>(name[index]));
+		}
+		wideName[length] = L'\0';
+
+		if (FAILED(setThreadDescription(thread, wideName)))
+		{
+			return DefaultError::UnknownError("SetThreadDescription failed");
+		}
+		return DefaultError::Ok();
+	}
+
+	Error<> SchedulingSetWindows(HANDLE thread, Policy policy, Priority priority)
+	{
+		int windowsPriority;
+		switch (policy)
+		{
+		case Policy::Normal:
+		{
+			static constexpr int priorities[] = {THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST};
+			windowsPriority = priorities[static_cast<uiw>(priority)];
+			break;
+		}
+		case Policy::Idle:
+			windowsPriority = THREAD_PRIORITY_IDLE;
+			break;
+		default:
+			return DefaultError::Unsupported("the scheduling policy isn't supported on Windows");
+		}
+
+		if (!SetThreadPriority(thread, windowsPriority))
+		{
+			return PlatformErrorResolve("SetThreadPriority failed");
+		}
+		return DefaultError::Ok();
+	}
+
+	// calls the callback with the processor mask of every entry of the relationship, cacheLevel is used only by RelationCache
+	template <typename F> void EnumerateProcessorMasks(LOGICAL_PROCESSOR_RELATIONSHIP relationship, ui32 cacheLevel, F &&callback)
+	{
+		DWORD bufferSize = 0;
+		GetLogicalProcessorInformation(nullptr, &bufferSize);
+		if (bufferSize == 0)
+		{
+			return;
+		}
+		uiw informationCount = bufferSize / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+		auto buffer = std::make_unique<SYSTEM_LOGICAL_PROCESSOR_INFORMATION[]>(informationCount);
+		if (!GetLogicalProcessorInformation(buffer.get(), &bufferSize))
+		{
+			return;
+		}
+		for (uiw index = 0; index < informationCount; ++index)
+		{
+			const auto &info = buffer[index];
+			if (info.Relationship == relationship && (relationship != RelationCache || info.Cache.Level == cacheLevel))
+			{
+				callback(info.ProcessorMask);
+			}
+		}
+	}
+
+	CPUSet CoresSharingMask(ui32 core, LOGICAL_PROCESSOR_RELATIONSHIP relationship, ui32 cacheLevel)
+	{
+		CPUSet result = CPUSet::Single(core);
+		if (core >= MaskCores)
+		{
+			return result;
+		}
+		EnumerateProcessorMasks(relationship, cacheLevel, [core, &result](ULONG_PTR mask)
+		{
+			if (Funcs::IsBitSet(mask, core))
+			{
+				result = CPUSetFromMask(mask);
+			}
+		});
+		return result;
+	}
+}
+
+Error<> ThreadControl::AffinitySet(const CPUSet &cores)
+{
+	return AffinitySetWindows(GetCurrentThread(), cores);
+}
+
+Error<> ThreadControl::AffinitySet(std::thread &thread, const CPUSet &cores)
+{
+	ASSUME(thread.joinable());
+	return AffinitySetWindows(thread.native_handle(), cores);
+}
+
+Result<CPUSet> ThreadControl::AffinityGet()
+{
+	return AffinityGetWindows(GetCurrentThread());
+}
+
+Result<CPUSet> ThreadControl::AffinityGet(std::thread &thread)
+{
+	ASSUME(thread.joinable());
+	return AffinityGetWindows(thread.native_handle());
+}
+
+Error<> ThreadControl::NameSet(std::string_view name)
+{
+	return NameSetWindows(GetCurrentThread(), name);
+}
+
+Error<> ThreadControl::NameSet(std::thread &thread, std::string_view name)
+{
+	ASSUME(thread.joinable());
+	return NameSetWindows(thread.native_handle(), name);
+}
+
+Error<> ThreadControl::SchedulingSet(Policy policy, Priority priority)
+{
+	return SchedulingSetWindows(GetCurrentThread(), policy, priority);
+}
+
+Error<> ThreadControl::SchedulingSet(std::thread &thread, Policy policy, Priority priority)
+{
+	ASSUME(thread.joinable());
+	return SchedulingSetWindows(thread.native_handle(), policy, priority);
+}
+
+CPUSet ThreadControl::CoresSharingCache(ui32 core, ui32 cacheLevel)
+{
+	return CoresSharingMask(core, RelationCache, cacheLevel);
+}
+
+CPUSet ThreadControl::SiblingCores(ui32 core)
+{
+	return CoresSharingMask(core, RelationProcessorCore, 0);
+}
+
+std::optional<ui32> ThreadControl::CurrentCore()
+{
+#ifdef PLATFORM_WINXP
+	return std::nullopt; // GetCurrentProcessorNumber exists since Vista
+#else
+	return static_cast<ui32>(GetCurrentProcessorNumber());
+#endif
+}
@@ -0,0 +1,138 @@
+#include "_PreHeader.hpp"
+
+using namespace StdLib;
+
+static void CompareWithReference(const FlatHashMap<ui32, ui64> &map, const std::unordered_map<ui32, ui64> &reference)
+{
+    UTest(Equal, map.Size(), reference.size());
+    for (const auto &[key, value] : reference)
+    {
+        auto it = map.Find(key);
+        UTest(true, it != map.end());
+        UTest(Equal, it->second, value);
+    }
+    uiw iterated = 0;
+    for (const auto &[key, value] : map)
+    {
+        UTest(Equal, reference.at(key), value);
+        ++iterated;
+    }
+    UTest(Equal, iterated, reference.size());
+}
+
+static void RandomOperationsTest()
+{
+    FlatHashMap<ui32, ui64> map;
+    std::unordered_map<ui32, ui64> reference;
+    std::mt19937 generator(12345);
+    std::uniform_int_distribution<ui32> keyDistribution(0, 4095);
+
+    // small key range, so there's a lot of erasures of existing keys and reuse of deleted slots
+    for (ui32 index = 0; index < 100'000; ++index)
+    {
+        ui32 key = keyDistribution(generator);
+        switch (generator() % 3)
+        {
+        case 0:
+        {
+            auto [it, isInserted] = map.Insert(key, index);
+            auto [referenceIt, isReferenceInserted] = reference.insert({key, index});
+            UTest(Equal, isInserted, isReferenceInserted);
+            UTest(Equal, it->second, referenceIt->second);
+        } break;
+        case 1:
+            UTest(Equal, map.Erase(key), reference.erase(key) != 0);
+            break;
+        case 2:
+            map[key] += index;
+            reference[key] += index;
+            break;
+        }
+    }
+
+    CompareWithReference(map, reference);
+
+    FlatHashMap<ui32, ui64> copy = map;
+    CompareWithReference(copy, reference);
+
+    FlatHashMap<ui32, ui64> moved = std::move(copy);
+    CompareWithReference(moved, reference);
+    UTest(true, copy.IsEmpty());
+
+    for (auto it = moved.begin(); it != moved.end(); )
+    {
+        if (it->first % 2)
+        {
+            reference.erase(it->first);
+            it = moved.Erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    CompareWithReference(moved, reference);
+
+    moved.Clear();
+    UTest(true, moved.IsEmpty());
+    UTest(true, moved.begin() == moved.end());
+    UTest(false, moved.Contains(0));
+}
+
+static void GrowthTest()
+{
+    FlatHashMap<ui64, ui32> map;
+    UTest(Equal, map.Capacity(), 0);
+    UTest(true, map.Find(5) == map.end());
+    UTest(false, map.Erase(5));
+
+    map.Reserve(1000);
+    uiw reserved = map.Capacity();
+    UTest(LeftGreaterEqual, reserved, 1000);
+    for (ui64 index = 0; index < 1000; ++index)
+    {
+        UTest(true, map.Insert(index * 0x1'0000'0000ull, static_cast<ui32>(index)).second);
+    }
+    UTest(Equal, map.Capacity(), reserved);
+
+    // inserting and erasing with a constant size must not grow the table because of tombstones
+    for (ui64 index = 1000; index < 100'000; ++index)
+    {
+        UTest(true, map.Erase((index - 1000) * 0x1'0000'0000ull));
+        UTest(true, map.Insert(index * 0x1'0000'0000ull, static_cast<ui32>(index)).second);
+    }
+    UTest(Equal, map.Size(), 1000);
+    UTest(Equal, map.Capacity(), reserved);
+}
+
+static void StringKeysTest()
+{
+    FlatHashMap<std::string, std::string, HashPolicy::FNV, Allocator::MallocAlignedPredefined<64>> map;
+    for (ui32 index = 0; index < 500; ++index)
+    {
+        std::string key = "key " + std::to_string(index);
+        map.TryEmplace(key, key.length(), 'v');
+    }
+    UTest(Equal, map.Size(), 500);
+    UTest(Equal, map.Find("key 123")->second, std::string(7, 'v'));
+    UTest(false, map.Contains("key 500"));
+    UTest(false, map.TryEmplace("key 7", "other").second);
+    UTest(Equal, map["key 7"], std::string(5, 'v'));
+
+    FlatHashSet<ui32> set;
+    UTest(true, set.Insert(15).second);
+    UTest(false, set.Insert(15).second);
+    UTest(true, set.Contains(15));
+    UTest(Equal, *set.begin(), 15);
+    UTest(true, set.Erase(15));
+    UTest(true, set.IsEmpty());
+}
+
+void FlatHashMapTests()
+{
+    RandomOperationsTest();
+    GrowthTest();
+    StringKeysTest();
+
+    UnitTestsLogger::Message("finished flat hash map tests\n");
+}
\ No newline at end of file
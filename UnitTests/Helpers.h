@@ -53,8 +53,16 @@
 
 #include <StdMiscLib.hpp>
 #include <DIWRSpinLock.hpp>
+#include <DIWRSpinLockDistributed.hpp>
 #include <MTMessageQueue.hpp>
+#include <MPSCMessageQueue.hpp>
+#include <RingQueue.hpp>
+#include <SeqLock.hpp>
+#include <ShardedCounter.hpp>
+#include <EpochDomain.hpp>
+#include <FlatHashMap.hpp>
 #include <MemoryStreamFile.hpp>
+#include <StreamHashing.hpp>
 #include <MathFunctions.hpp>
 #include <ApproxMath.hpp>
 #include <FunctionInfo.hpp>
@@ -68,6 +76,13 @@
 #include <StandardFile.hpp>
 #include <File.hpp>
 #include <MemoryMappedFile.hpp>
+#include <ParallelHashing.hpp>
+#include <ThreadPool.hpp>
+#include <ThreadControl.hpp>
+#include <TaskGraph.hpp>
+#include <ParallelAlgorithms.hpp>
+#include <TimedMessageQueue.hpp>
+#include <Coroutine.hpp>
 #include <VirtualKeys.hpp>
 #include <NativeConsole.hpp>
 
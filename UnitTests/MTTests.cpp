@@ -4,15 +4,15 @@ using namespace StdLib;
 using std::nullopt;
 using Funcs::Reinitialize;
 
-static void DIWRSpinLockTests()
+template <typename LockT, typename... Args> static void DIWRSpinLockTests(Args... args)
 {
-	DIWRSpinLock spin;
+	LockT spin(args...);
 	auto attemptReadLocks = [&spin](uiw count, bool expectToSucceed)
 	{
-		auto locks = ALLOCA_TYPED(count, std::optional<DIWRSpinLock::Unlocker>);
+		auto locks = ALLOCA_TYPED(count, std::optional<typename LockT::Unlocker>);
 		for (uiw index = 0; index < count; ++index)
 		{
-			new (&locks[index]) std::optional<DIWRSpinLock::Unlocker>(spin.TryLock(DIWRSpinLock::LockType::Read));
+			new (&locks[index]) std::optional<typename LockT::Unlocker>(spin.TryLock(LockT::LockType::Read));
 			if (expectToSucceed)
 			{
 				UTest(NotEqual, locks[index], nullopt);
@@ -32,68 +32,162 @@ static void DIWRSpinLockTests()
 		}
 	};
 
-	auto lock = spin.Lock(DIWRSpinLock::LockType::Read);
-	std::optional<DIWRSpinLock::Unlocker> lock2, lock3;
+	auto lock = spin.Lock(LockT::LockType::Read);
+	std::optional<typename LockT::Unlocker> lock2, lock3;
 
 	auto testForRead = [&spin, &lock, &lock2, &lock3, attemptReadLocks]
 	{
 		attemptReadLocks(10, true);
-		Reinitialize(lock2, spin.TryLock(DIWRSpinLock::LockType::Inclusive));
+		Reinitialize(lock2, spin.TryLock(LockT::LockType::Inclusive));
 		UTest(NotEqual, lock2, nullopt);
-		Reinitialize(lock3, spin.TryLock(DIWRSpinLock::LockType::Inclusive));
+		Reinitialize(lock3, spin.TryLock(LockT::LockType::Inclusive));
 		UTest(Equal, lock3, nullopt);
-		Reinitialize(lock3, spin.TryLock(DIWRSpinLock::LockType::Exclusive));
+		Reinitialize(lock3, spin.TryLock(LockT::LockType::Exclusive));
 		UTest(Equal, lock3, nullopt);
 		lock2->Unlock();
-		Reinitialize(lock3, spin.TryLock(DIWRSpinLock::LockType::Exclusive));
+		Reinitialize(lock3, spin.TryLock(LockT::LockType::Exclusive));
 		UTest(Equal, lock3, nullopt);
 	};
 	auto testForInclusive = [&spin, &lock, &lock2, attemptReadLocks]
 	{
 		attemptReadLocks(10, true);
-		Reinitialize(lock2, spin.TryLock(DIWRSpinLock::LockType::Inclusive));
+		Reinitialize(lock2, spin.TryLock(LockT::LockType::Inclusive));
 		UTest(Equal, lock2, nullopt);
-		Reinitialize(lock2, spin.TryLock(DIWRSpinLock::LockType::Exclusive));
+		Reinitialize(lock2, spin.TryLock(LockT::LockType::Exclusive));
 		UTest(Equal, lock2, nullopt);
 	};
 	auto testForExclusive = [&spin, &lock, &lock2, attemptReadLocks]
 	{
 		attemptReadLocks(10, false);
-		Reinitialize(lock2, spin.TryLock(DIWRSpinLock::LockType::Inclusive));
+		Reinitialize(lock2, spin.TryLock(LockT::LockType::Inclusive));
 		UTest(Equal, lock2, nullopt);
-		Reinitialize(lock2, spin.TryLock(DIWRSpinLock::LockType::Exclusive));
+		Reinitialize(lock2, spin.TryLock(LockT::LockType::Exclusive));
 		UTest(Equal, lock2, nullopt);
 	};
 
 	testForRead();
 	lock.Unlock();
-	Reinitialize(lock3, spin.TryLock(DIWRSpinLock::LockType::Exclusive));
+	Reinitialize(lock3, spin.TryLock(LockT::LockType::Exclusive));
 	UTest(NotEqual, lock3, nullopt);
 	lock3->Unlock();
 
-	Reinitialize(lock, spin.Lock(DIWRSpinLock::LockType::Inclusive));
+	Reinitialize(lock, spin.Lock(LockT::LockType::Inclusive));
 	testForInclusive();
 	lock.Unlock();
 
-	Reinitialize(lock, spin.Lock(DIWRSpinLock::LockType::Exclusive));
+	Reinitialize(lock, spin.Lock(LockT::LockType::Exclusive));
 	testForExclusive();
 
-	lock.Transition(DIWRSpinLock::LockType::Inclusive); // Exclusive->Inclusive
+	lock.Transition(LockT::LockType::Inclusive); // Exclusive->Inclusive
 	testForInclusive();
-	lock.Transition(DIWRSpinLock::LockType::Exclusive); // Inclusive->Exclusive
+	lock.Transition(LockT::LockType::Exclusive); // Inclusive->Exclusive
 	testForExclusive();
-	lock.Transition(DIWRSpinLock::LockType::Read); // Exclusive->Read
+	lock.Transition(LockT::LockType::Read); // Exclusive->Read
 	testForRead();
-	lock.Transition(DIWRSpinLock::LockType::Inclusive); // Read->Inclusive
+	lock.Transition(LockT::LockType::Inclusive); // Read->Inclusive
 	testForInclusive();
-	lock.Transition(DIWRSpinLock::LockType::Read); // Inclusive->Read
+	lock.Transition(LockT::LockType::Read); // Inclusive->Read
 	testForRead();
-	lock.Transition(DIWRSpinLock::LockType::Exclusive); // Read->Exclusive
+	lock.Transition(LockT::LockType::Exclusive); // Read->Exclusive
 	testForExclusive();
 
 	lock.Unlock();
 }
 
+static void DIWRSpinLockTimedTests()
+{
+	for (auto mode : {DIWRSpinLock::Mode::Spin, DIWRSpinLock::Mode::Blocking})
+	{
+		DIWRSpinLock spin(mode);
+		UTest(Equal, spin.LockMode(), mode);
+
+		auto exclusive = spin.Lock(DIWRSpinLock::LockType::Exclusive);
+		auto start = std::chrono::steady_clock::now();
+		auto failed = spin.TryLock(DIWRSpinLock::LockType::Read, TimeDifference(10_ms));
+		UTest(Equal, failed, nullopt);
+		UTest(LeftGreaterEqual, std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+
+		std::thread unlocker([&exclusive]
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			exclusive.Unlock();
+		});
+		auto read = spin.TryLock(DIWRSpinLock::LockType::Read, TimeDifference(10_s));
+		unlocker.join();
+		UTest(NotEqual, read, nullopt);
+		UTest(Equal, spin.TryLock(DIWRSpinLock::LockType::Exclusive, TimeDifference(1_ms)), nullopt);
+		read->Unlock();
+
+		auto exclusive2 = spin.TryLock(DIWRSpinLock::LockType::Exclusive, TimeDifference(1_ms));
+		UTest(NotEqual, exclusive2, nullopt);
+		exclusive2->Unlock();
+	}
+}
+
+// readers check that the two halves of the protected value are always equal, writers and upgraders change them
+template <typename LockT, typename... Args> static void DIWRSpinLockStressTests(Args... args)
+{
+	LockT spin(args...);
+	ui64 first = 0, second = 0;
+	std::atomic<bool> isTorn{false};
+
+	auto read = [&]
+	{
+		if (first != second)
+		{
+			isTorn = true;
+		}
+	};
+	auto write = [&]
+	{
+		++first;
+		++second;
+	};
+
+	constexpr uiw threadsCount = 8, iterations = 2000;
+	std::vector<std::thread> threads;
+	for (uiw threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+	{
+		threads.emplace_back([&spin, &read, &write, threadIndex]
+		{
+			for (uiw index = 0; index < iterations; ++index)
+			{
+				auto operation = (threadIndex + index) % 8;
+				if (operation == 0)
+				{
+					auto lock = spin.Lock(LockT::LockType::Exclusive);
+					write();
+					lock.Unlock();
+				}
+				else if (operation == 1)
+				{
+					auto lock = spin.Lock(LockT::LockType::Inclusive);
+					read();
+					lock.Transition(LockT::LockType::Exclusive);
+					write();
+					lock.Transition(LockT::LockType::Read);
+					read();
+					lock.Unlock();
+				}
+				else
+				{
+					auto lock = spin.Lock(LockT::LockType::Read);
+					read();
+					lock.Unlock();
+				}
+			}
+		});
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	UTest(false, isTorn.load());
+	UTest(Equal, first, threadsCount * iterations / 4); // an exclusive and an inclusive-upgrade write for every 8 iterations
+	UTest(Equal, second, first);
+}
+
 static void SpinLockTests()
 {
 	SpinLock spinLock;
@@ -105,6 +199,436 @@ static void SpinLockTests()
 	auto unlocker3 = spinLock.TryLock();
 	UTest(NotEqual, unlocker3, nullopt);
 	unlocker3->Unlock();
+
+	SpinLock hybridLock(SpinLock::Mode::Hybrid);
+	UTest(Equal, hybridLock.LockMode(), SpinLock::Mode::Hybrid);
+	auto hybridUnlocker = hybridLock.Lock();
+	UTest(Equal, hybridLock.TryLock(), nullopt);
+	hybridUnlocker.Unlock();
+	auto hybridUnlocker2 = hybridLock.TryLock();
+	UTest(NotEqual, hybridUnlocker2, nullopt);
+	hybridUnlocker2->Unlock();
+
+	// more threads than a typical test machine has cores, so some of them have to park
+	constexpr uiw threadsCount = 16, incrementsPerThread = 10000;
+	uiw counter = 0;
+	std::vector<std::thread> threads;
+	for (uiw threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+	{
+		threads.emplace_back([&hybridLock, &counter]
+		{
+			for (uiw index = 0; index < incrementsPerThread; ++index)
+			{
+				std::scoped_lock lock(hybridLock);
+				++counter;
+			}
+		});
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+	UTest(Equal, counter, threadsCount * incrementsPerThread);
+}
+
+static void LockProfilerTests()
+{
+#ifdef STDLIB_ENABLE_LOCK_PROFILING
+	SpinLock spinLock;
+	spinLock.ProfilingNameSet("profiled spin lock");
+	DIWRSpinLock diwrLock;
+	diwrLock.ProfilingNameSet("profiled DIWR lock");
+
+	// the waits are measured from the first failed attempt, so the locks are held for a while after the waiter is blocked
+	auto waitUntilBlocked = [](const auto &lock)
+	{
+		while (lock.ProfilingStatsGet().waitingThreads == 0)
+		{
+			std::this_thread::yield();
+		}
+	};
+
+	auto unlocker = spinLock.Lock();
+	auto diwrUnlocker = diwrLock.Lock(DIWRSpinLock::LockType::Exclusive);
+	std::thread waiter([&spinLock, &diwrLock]
+	{
+		auto readUnlocker = diwrLock.Lock(DIWRSpinLock::LockType::Read);
+		auto spinUnlocker = spinLock.Lock();
+		spinUnlocker.Unlock();
+		readUnlocker.Unlock();
+	});
+	waitUntilBlocked(diwrLock);
+	std::this_thread::sleep_for(10ms);
+	diwrUnlocker.Unlock();
+	waitUntilBlocked(spinLock);
+	std::this_thread::sleep_for(20ms);
+	unlocker.Unlock();
+	waiter.join();
+	UTest(Equal, spinLock.ProfilingStatsGet().waitingThreads, 0);
+
+	LockProfiler::Stats stats = spinLock.ProfilingStatsGet();
+	UTest(Equal, stats.acquisitions, 2);
+	UTest(Equal, stats.contendedAcquisitions, 1);
+	UTest(true, stats.spinIterations > 0);
+	UTest(true, stats.waitUSec >= 10'000);
+
+	auto tryUnlocker = spinLock.TryLock();
+	UTest(NotEqual, tryUnlocker, nullopt);
+	tryUnlocker->Unlock();
+	UTest(Equal, spinLock.ProfilingStatsGet().acquisitions, 3);
+	UTest(Equal, spinLock.ProfilingStatsGet().contendedAcquisitions, 1);
+
+	LockProfiler::Stats diwrStats = diwrLock.ProfilingStatsGet();
+	UTest(Equal, diwrStats.acquisitions, 2);
+	UTest(Equal, diwrStats.contendedAcquisitions, 1);
+
+	// the spin lock was waited for longer
+	auto reports = LockProfiler::MostContended(uiw_max);
+	auto spinLockReport = std::find_if(reports.begin(), reports.end(), [&spinLock](const LockProfiler::Report &report) { return report.lock == &spinLock; });
+	auto diwrLockReport = std::find_if(reports.begin(), reports.end(), [&diwrLock](const LockProfiler::Report &report) { return report.lock == &diwrLock; });
+	UTest(true, spinLockReport != reports.end() && diwrLockReport != reports.end());
+	UTest(Equal, spinLockReport->name, std::string{"profiled spin lock"});
+	UTest(Equal, diwrLockReport->name, std::string{"profiled DIWR lock"});
+	UTest(true, spinLockReport < diwrLockReport);
+
+	LockProfiler::Reset();
+	UTest(Equal, spinLock.ProfilingStatsGet().acquisitions, 0);
+	UTest(Equal, LockProfiler::MostContended(uiw_max).size(), 0);
+#endif
+}
+
+static void SeqLockTests()
+{
+	// the size isn't a multiple of the word size, so the last word is partially used
+	struct Snapshot
+	{
+		ui32 values[5];
+		ui8 tag;
+	};
+
+	SeqLock<Snapshot> seqLock(Snapshot{{1, 2, 3, 4, 5}, 6});
+	Snapshot loaded = seqLock.Load();
+	UTest(Equal, loaded.values[4], 5);
+	UTest(Equal, loaded.tag, 6);
+	UTest(Equal, seqLock.Sequence(), 0);
+
+	seqLock.Update([](Snapshot &value) { value.tag = 7; });
+	UTest(Equal, seqLock.Sequence(), 2);
+	auto tryLoaded = seqLock.TryLoad();
+	UTest(true, tryLoaded.has_value());
+	UTest(Equal, tryLoaded->values[0], 1);
+	UTest(Equal, tryLoaded->tag, 7);
+
+	SeqLock<ui64> defaultLock;
+	UTest(Equal, defaultLock.Load(), 0);
+
+	// every snapshot the writers store has all the values equal, a torn read would mix two snapshots
+	seqLock.Store(Snapshot{{0, 0, 0, 0, 0}, 0});
+	constexpr ui32 writesPerThread = 20000, writersCount = 2, readersCount = 4;
+	std::atomic<ui32> finishedWriters{0};
+	std::atomic<bool> isTorn{false};
+	std::vector<std::thread> threads;
+	for (ui32 writerIndex = 0; writerIndex < writersCount; ++writerIndex)
+	{
+		threads.emplace_back([&seqLock, &finishedWriters]
+		{
+			for (ui32 index = 0; index < writesPerThread; ++index)
+			{
+				seqLock.Update([](Snapshot &value)
+				{
+					ui32 next = value.values[0] + 1;
+					std::fill(std::begin(value.values), std::end(value.values), next);
+					value.tag = static_cast<ui8>(next);
+				});
+			}
+			finishedWriters.fetch_add(1);
+		});
+	}
+	for (ui32 readerIndex = 0; readerIndex < readersCount; ++readerIndex)
+	{
+		threads.emplace_back([&seqLock, &finishedWriters, &isTorn]
+		{
+			ui32 previous = 0;
+			while (finishedWriters.load() != writersCount)
+			{
+				Snapshot snapshot = seqLock.Load();
+				bool isConsistent = std::all_of(std::begin(snapshot.values), std::end(snapshot.values), [&snapshot](ui32 value) { return value == snapshot.values[0]; });
+				isConsistent &= snapshot.tag == static_cast<ui8>(snapshot.values[0]);
+				isConsistent &= snapshot.values[0] >= previous; // the snapshots never go back in time
+				if (!isConsistent)
+				{
+					isTorn = true;
+				}
+				previous = snapshot.values[0];
+			}
+		});
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+	UTest(false, isTorn.load());
+	UTest(Equal, seqLock.Load().values[0], writesPerThread * writersCount); // the updates from different writers are serialized
+	UTest(Equal, seqLock.Sequence(), 2 + 2 + 2 * writesPerThread * writersCount);
+}
+
+static void ShardedCounterTests()
+{
+	struct TestStats
+	{
+		using countert = ui32;
+		countert first;
+		countert second;
+		countert third;
+	};
+
+	ShardedCounter<> counter;
+	ShardedStats<TestStats> stats;
+	counter.Add(5);
+	counter.Increment();
+	stats.Add(&TestStats::second, 3);
+	UTest(Equal, counter.Load(), 6);
+	UTest(Equal, stats.Load().second, 3);
+	UTest(Equal, stats.Load().first, 0);
+
+	// more threads than shards, so some of the shards are shared
+	constexpr ui32 threadsCount = CounterShardsCount + 8, incrementsPerThread = 10000;
+	std::vector<std::thread> threads;
+	for (ui32 threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+	{
+		threads.emplace_back([&counter, &stats]
+		{
+			for (ui32 index = 0; index < incrementsPerThread; ++index)
+			{
+				counter.Increment();
+				stats.Add(&TestStats::first);
+				stats.Add(&TestStats::third, 2);
+			}
+		});
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	UTest(Equal, counter.Reset(), 6 + threadsCount * incrementsPerThread);
+	UTest(Equal, counter.Load(), 0);
+	TestStats reset = stats.Reset();
+	UTest(Equal, reset.first, threadsCount * incrementsPerThread);
+	UTest(Equal, reset.second, 3);
+	UTest(Equal, reset.third, threadsCount * incrementsPerThread * 2);
+	UTest(Equal, stats.Load().third, 0);
+
+#ifdef STDLIB_ENABLE_QUEUE_STATS
+	{
+		MTMessageQueue queue;
+		ui32 calledTimes = 0;
+		auto increment = [](ui32 &calledTimes) { ++calledTimes; };
+		for (ui32 index = 0; index < 4; ++index)
+		{
+			queue.Add(increment, std::ref(calledTimes));
+		}
+		MTMessageQueue::Batch batch;
+		batch.Add(increment, std::ref(calledTimes));
+		batch.Add(increment, std::ref(calledTimes));
+		queue.AddBatch(std::move(batch));
+		UTest(true, queue.ExecNoWait());
+		UTest(Equal, queue.ExecUpTo(2), 2);
+		queue.Clear();
+		MessageQueueStats queueStats = queue.StatsReset();
+		UTest(Equal, queueStats.added, 6);
+		UTest(Equal, queueStats.executed, 3);
+		UTest(Equal, queueStats.destroyed, 3);
+		UTest(Equal, queue.StatsGet().added, 0);
+	}
+
+	{
+		MPSCMessageQueue queue;
+		std::atomic<ui32> calledTimes{0};
+		std::vector<std::thread> producers;
+		for (ui32 threadIndex = 0; threadIndex < 4; ++threadIndex)
+		{
+			producers.emplace_back([&queue, &calledTimes]
+			{
+				for (ui32 index = 0; index < 1000; ++index)
+				{
+					queue.Add([](std::atomic<ui32> &calledTimes) { ++calledTimes; }, std::ref(calledTimes));
+				}
+			});
+		}
+		for (auto &thread : producers)
+		{
+			thread.join();
+		}
+		while (queue.ExecNoWait())
+		{}
+		UTest(Equal, calledTimes.load(), 4000);
+		UTest(Equal, queue.StatsGet().added, 4000);
+		UTest(Equal, queue.StatsGet().executed, 4000);
+	}
+#endif
+
+#ifdef STDLIB_ENABLE_ALLOCATOR_STATS
+	{
+		MessagePool::Stats before = MessagePool::StatsGet();
+		void *small = MessagePool::Allocate(16);
+		void *large = MessagePool::Allocate(MessagePool::MaxPooledSize + 1);
+		MessagePool::Free(small, 16);
+		MessagePool::Free(large, MessagePool::MaxPooledSize + 1);
+		MessagePool::Stats after = MessagePool::StatsGet();
+		UTest(Equal, after.pooledAllocations - before.pooledAllocations, 1);
+		UTest(Equal, after.pooledFrees - before.pooledFrees, 1);
+		UTest(Equal, after.largeAllocations - before.largeAllocations, 1);
+		UTest(Equal, after.largeFrees - before.largeFrees, 1);
+	}
+#endif
+}
+
+static void EpochDomainTests()
+{
+	struct Node
+	{
+		std::atomic<bool> isDestroyed{false};
+		ui64 value = 0;
+	};
+
+	{
+		EpochDomain domain;
+		std::atomic<ui32> freedCount{0};
+		auto retireCounted = [&domain](std::atomic<ui32> &freedCount)
+		{
+			static std::atomic<ui32> *counter;
+			counter = &freedCount;
+			auto guard = domain.Pin();
+			domain.Retire(new ui32(0), [](void *object)
+			{
+				delete static_cast<ui32 *>(object);
+				++*counter;
+			});
+			guard.Unpin();
+		};
+
+		// nested pins, the object retired while pinned can't be freed until the outermost guard is unpinned
+		auto outer = domain.Pin();
+		auto inner = domain.Pin();
+		retireCounted(freedCount);
+		inner.Unpin();
+		for (ui32 index = 0; index < 5; ++index)
+		{
+			domain.Collect();
+		}
+		UTest(Equal, freedCount.load(), 0);
+		UTest(Equal, domain.PendingCount(), 1);
+		outer.Unpin();
+		domain.Synchronize();
+		UTest(Equal, freedCount.load(), 1);
+		UTest(Equal, domain.PendingCount(), 0);
+
+		// a thread pinned in another thread blocks the reclamation of everything retired after its pin
+		std::atomic<bool> isPinned{false}, isReleased{false};
+		std::thread pinner([&domain, &isPinned, &isReleased]
+		{
+			auto guard = domain.Pin();
+			isPinned = true;
+			while (!isReleased)
+			{
+				std::this_thread::yield();
+			}
+			guard.Unpin();
+		});
+		while (!isPinned)
+		{
+			std::this_thread::yield();
+		}
+		retireCounted(freedCount);
+		for (ui32 index = 0; index < 5; ++index)
+		{
+			domain.Collect();
+		}
+		UTest(Equal, freedCount.load(), 1);
+		isReleased = true;
+		pinner.join();
+		domain.Synchronize();
+		UTest(Equal, freedCount.load(), 2);
+
+		// the typed version destroys the object and frees it with the allocator
+		auto guard = domain.Pin();
+		domain.Retire<Node, Allocator::Malloc>(new (Allocator::Malloc::Allocate<Node>(1)) Node);
+		domain.RetireDelete(new Node);
+		guard.Unpin();
+		UTest(Equal, domain.PendingCount(), 2);
+		domain.Synchronize();
+		UTest(Equal, domain.PendingCount(), 0);
+	}
+
+	// readers never see a node that has been destroyed, the nodes are kept in a graveyard instead of being freed to check it
+	{
+		EpochDomain domain;
+		std::atomic<Node *> current{new Node};
+		static SpinLock graveyardLock;
+		static std::vector<Node *> graveyard;
+
+		constexpr ui32 readersCount = 4, writersCount = 2, writesPerThread = 5000;
+		std::atomic<ui32> finishedWriters{0};
+		std::atomic<bool> isUseAfterFree{false};
+		std::vector<std::thread> threads;
+		for (ui32 writerIndex = 0; writerIndex < writersCount; ++writerIndex)
+		{
+			threads.emplace_back([&domain, &current, &finishedWriters]
+			{
+				for (ui32 index = 0; index < writesPerThread; ++index)
+				{
+					Node *node = new Node;
+					node->value = index;
+					auto guard = domain.Pin();
+					Node *previous = current.exchange(node);
+					domain.Retire(previous, [](void *object)
+					{
+						auto *node = static_cast<Node *>(object);
+						node->isDestroyed = true;
+						std::scoped_lock lock(graveyardLock);
+						graveyard.push_back(node);
+					});
+					guard.Unpin();
+				}
+				domain.Synchronize();
+				UTest(Equal, domain.PendingCount(), 0);
+				finishedWriters.fetch_add(1);
+			});
+		}
+		for (ui32 readerIndex = 0; readerIndex < readersCount; ++readerIndex)
+		{
+			threads.emplace_back([&domain, &current, &finishedWriters, &isUseAfterFree]
+			{
+				while (finishedWriters.load() != writersCount)
+				{
+					auto guard = domain.Pin();
+					Node *node = current.load();
+					for (ui32 index = 0; index < 16; ++index)
+					{
+						if (node->isDestroyed.load())
+						{
+							isUseAfterFree = true;
+						}
+					}
+					guard.Unpin();
+				}
+			});
+		}
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+
+		UTest(false, isUseAfterFree.load());
+		UTest(Equal, graveyard.size(), writersCount * writesPerThread);
+		for (Node *node : graveyard)
+		{
+			delete node;
+		}
+		graveyard.clear();
+		delete current.load();
+	}
 }
 
 struct MessageQueueTestStruct
@@ -120,9 +644,9 @@ static void MessageQueueTestFunc(ui32 &calledTimes)
 	++calledTimes;
 }
 
-static void MessageQueueTests()
+template <typename QueueT> static void MessageQueueTests()
 {
-	MTMessageQueue messageQueue;
+	QueueT messageQueue;
 
 	ui32 calledTimes = 0;
 
@@ -182,22 +706,971 @@ static void MessageQueueTests()
 	messageQueue.Add(funcWithUniqueArgument, move(uniqueArgument));
 	messageQueue.Add(funcWithArray, arr);
 	messageQueue.Add(funcWithArrayRef, std::ref(arr));
-	messageQueue.Add<MessageQueueTestFunc>(std::ref(calledTimes));
-	messageQueue.Add<&MessageQueueTestStruct::Call>(object, std::ref(calledTimes));
-	messageQueue.Add<&MessageQueueTestStruct::Call>(sharedObject, std::ref(calledTimes));
-	messageQueue.Add<&MessageQueueTestStruct::Call>(uniqueObject, std::ref(calledTimes));
-	messageQueue.Add<&MessageQueueTestStruct::Call>(move(uniqueObject), std::ref(calledTimes));
+	messageQueue.template Add<MessageQueueTestFunc>(std::ref(calledTimes));
+	messageQueue.template Add<&MessageQueueTestStruct::Call>(object, std::ref(calledTimes));
+	messageQueue.template Add<&MessageQueueTestStruct::Call>(sharedObject, std::ref(calledTimes));
+	messageQueue.template Add<&MessageQueueTestStruct::Call>(uniqueObject, std::ref(calledTimes));
+	messageQueue.template Add<&MessageQueueTestStruct::Call>(move(uniqueObject), std::ref(calledTimes));
 	
 	while (messageQueue.ExecNoWait());
 
 	UTest(Equal, calledTimes, 7);
 }
 
+static void MessageQueueBatchTests()
+{
+	MTMessageQueue queue;
+	ui32 calledTimes = 0;
+	auto increment = [](ui32 &calledTimes) { ++calledTimes; };
+
+	UTest(Equal, queue.ExecAll(), 0);
+	UTest(Equal, queue.ExecUpTo(5), 0);
+
+	MTMessageQueue::Batch batch;
+	for (uiw index = 0; index < 10; ++index)
+	{
+		batch.Add(increment, std::ref(calledTimes));
+	}
+	batch.Add<MessageQueueTestFunc>(std::ref(calledTimes));
+	UTest(Equal, batch.Size(), 11);
+	queue.AddBatch(std::move(batch));
+	UTest(Equal, batch.Size(), 0);
+	queue.Add(increment, std::ref(calledTimes));
+
+	UTest(Equal, queue.ExecUpTo(0), 0);
+	UTest(Equal, queue.ExecUpTo(3), 3);
+	UTest(Equal, calledTimes, 3);
+	UTest(Equal, queue.ExecAll(), 9);
+	UTest(Equal, calledTimes, 12);
+	UTest(false, queue.ExecNoWait());
+
+	// messages that were never posted are destroyed with the batch
+	auto counter = std::make_shared<int>(0);
+	{
+		MTMessageQueue::Batch unposted;
+		unposted.Add([](std::shared_ptr<int> value) { ++*value; }, counter);
+		UTest(Equal, counter.use_count(), 2);
+	}
+	UTest(Equal, counter.use_count(), 1);
+	UTest(Equal, *counter, 0);
+
+	// producers post batches while the consumer drains everything at once
+	constexpr uiw producersCount = 4, batchesPerProducer = 500, batchSize = 16;
+	uiw executed = 0;
+	std::vector<std::thread> producers;
+	for (uiw producer = 0; producer < producersCount; ++producer)
+	{
+		producers.emplace_back([&queue, &executed]
+		{
+			for (uiw batchIndex = 0; batchIndex < batchesPerProducer; ++batchIndex)
+			{
+				MTMessageQueue::Batch producerBatch;
+				for (uiw index = 0; index < batchSize; ++index)
+				{
+					producerBatch.Add([](uiw &executed) { ++executed; }, std::ref(executed));
+				}
+				queue.AddBatch(std::move(producerBatch));
+			}
+		});
+	}
+	uiw drained = 0;
+	while (drained < producersCount * batchesPerProducer * batchSize)
+	{
+		drained += queue.ExecAll();
+	}
+	for (auto &producer : producers)
+	{
+		producer.join();
+	}
+	UTest(Equal, drained, executed);
+	UTest(Equal, executed, producersCount * batchesPerProducer * batchSize);
+}
+
+// the owner pushes and pops while thieves steal, every item must be taken exactly once
+static void WorkStealingDequeTests()
+{
+	WorkStealingDeque<uiw> deque(4); // small initial capacity to make it grow
+
+	UTest(Equal, deque.Pop(), nullopt);
+	UTest(Equal, deque.Steal(), nullopt);
+	for (uiw index = 0; index < 10; ++index)
+	{
+		deque.Push(index);
+	}
+	UTest(Equal, deque.SizeApprox(), 10);
+	UTest(Equal, deque.Pop(), 9u);
+	UTest(Equal, deque.Steal(), 0u);
+	UTest(Equal, deque.Steal(), 1u);
+	UTest(Equal, deque.Pop(), 8u);
+	while (deque.Pop());
+	UTest(true, deque.IsEmptyApprox());
+
+	constexpr uiw itemsCount = 100000, thievesCount = 3;
+	std::vector<std::atomic<ui32>> taken(itemsCount);
+	std::atomic<bool> isDone{false};
+
+	std::vector<std::thread> thieves;
+	for (uiw thief = 0; thief < thievesCount; ++thief)
+	{
+		thieves.emplace_back([&deque, &taken, &isDone]
+		{
+			while (!isDone.load())
+			{
+				if (auto item = deque.Steal())
+				{
+					taken[*item].fetch_add(1);
+				}
+			}
+		});
+	}
+
+	for (uiw index = 0; index < itemsCount; ++index)
+	{
+		deque.Push(index);
+		if (index % 3 == 0)
+		{
+			if (auto item = deque.Pop())
+			{
+				taken[*item].fetch_add(1);
+			}
+		}
+	}
+	while (auto item = deque.Pop())
+	{
+		taken[*item].fetch_add(1);
+	}
+	isDone = true;
+	for (auto &thief : thieves)
+	{
+		thief.join();
+	}
+
+	bool isEachTakenOnce = std::all_of(taken.begin(), taken.end(), [](const std::atomic<ui32> &value) { return value.load() == 1; });
+	UTest(true, isEachTakenOnce);
+}
+
+static void ThreadPoolSpawnTask(ThreadPool &pool, std::atomic<uiw> &leaves, ui32 depth)
+{
+	UTest(NotEqual, pool.CurrentWorkerIndex(), nullopt);
+	if (depth == 0)
+	{
+		leaves.fetch_add(1);
+		return;
+	}
+	pool.Add<ThreadPoolSpawnTask>(std::ref(pool), std::ref(leaves), depth - 1);
+	pool.Add<ThreadPoolSpawnTask>(std::ref(pool), std::ref(leaves), depth - 1);
+}
+
+static void ThreadPoolTests()
+{
+	for (bool isPinning : {false, true})
+	{
+		ThreadPool pool(4, isPinning);
+		UTest(Equal, pool.ThreadsCount(), 4);
+		UTest(Equal, pool.CurrentWorkerIndex(), nullopt);
+
+		std::atomic<uiw> executed{0};
+		for (uiw index = 0; index < 1000; ++index)
+		{
+			pool.Add([](std::atomic<uiw> &executed) { executed.fetch_add(1); }, std::ref(executed));
+		}
+		pool.WaitIdle();
+		UTest(Equal, executed.load(), 1000);
+
+		// tasks spawn more tasks from the workers, they go to the workers' own deques and get stolen from there
+		std::atomic<uiw> leaves{0};
+		pool.Add<ThreadPoolSpawnTask>(std::ref(pool), std::ref(leaves), 12u);
+		pool.WaitIdle();
+		UTest(Equal, leaves.load(), 1u << 12);
+
+		// WaitIdle from a worker executes tasks instead of blocking
+		std::atomic<uiw> nested{0};
+		pool.Add([](ThreadPool &pool, std::atomic<uiw> &nested)
+		{
+			for (uiw index = 0; index < 100; ++index)
+			{
+				pool.Add([](std::atomic<uiw> &nested) { nested.fetch_add(1); }, std::ref(nested));
+			}
+			pool.WaitIdle();
+		}, std::ref(pool), std::ref(nested));
+		pool.WaitIdle();
+		UTest(Equal, nested.load(), 100);
+
+		// the destructor finishes the remaining tasks
+		for (uiw index = 0; index < 100; ++index)
+		{
+			pool.Add([](std::atomic<uiw> &executed) { executed.fetch_add(1); }, std::ref(executed));
+		}
+	}
+
+	ThreadPool defaultPool;
+	UTest(Equal, defaultPool.ThreadsCount(), std::max(SystemInfo::LogicalCPUCores(), 1u));
+}
+
+static void ThreadControlTests()
+{
+	using namespace ThreadControl;
+
+	CPUSet set{1, 3};
+	UTest(Equal, set.Count(), 2);
+	UTest(true, set.Contains(3));
+	UTest(false, set.Contains(2));
+	UTest(Equal, set.First(), 1u);
+	UTest(Equal, set.Combined(CPUSet::Single(2)).Count(), 3);
+	UTest(Equal, set.Intersection(CPUSet{3, 4}), CPUSet::Single(3));
+	UTest(Equal, set.Excluded(CPUSet::Single(1)), CPUSet::Single(3));
+	UTest(true, CPUSet().IsEmpty());
+	UTest(Equal, CPUSet().First(), nullopt);
+	UTest(Equal, CPUSet::All().Count(), std::min(SystemInfo::LogicalCPUCores(), CPUSet::MaxCores));
+	UTest(Equal, AffinitySet(CPUSet()), DefaultError::InvalidArgument());
+
+	for (ui32 core = 0; core < SystemInfo::LogicalCPUCores(); ++core)
+	{
+		UTest(true, SiblingCores(core).Contains(core));
+		UTest(true, CoresSharingCache(core, 1).Contains(core));
+	}
+
+	auto affinity = AffinityGet();
+	if (!affinity)
+	{
+		UTest(Equal, affinity.GetError(), DefaultError::Unsupported());
+		return;
+	}
+	CPUSet original = affinity.Unwrap();
+	UTest(false, original.IsEmpty());
+
+	// pin the calling thread to one of the cores it's allowed to run on, then restore it
+	ui32 pinnedCore = *original.First();
+	UTest(Equal, AffinitySet(CPUSet::Single(pinnedCore)), DefaultError::Ok());
+	UTest(Equal, AffinityGet().Unwrap(), CPUSet::Single(pinnedCore));
+	if (auto currentCore = CurrentCore())
+	{
+		UTest(Equal, *currentCore, pinnedCore);
+	}
+	UTest(Equal, AffinitySet(original), DefaultError::Ok());
+	UTest(Equal, AffinityGet().Unwrap(), original);
+
+	std::atomic<bool> isFinished{false};
+	std::thread thread([&isFinished]
+	{
+		while (!isFinished)
+		{
+			std::this_thread::yield();
+		}
+	});
+	UTest(Equal, AffinitySet(thread, CPUSet::Single(pinnedCore)), DefaultError::Ok());
+	UTest(Equal, AffinityGet(thread).Unwrap(), CPUSet::Single(pinnedCore));
+	Error<> nameError = NameSet(thread, "a thread name that is too long for Linux");
+	UTest(true, nameError == DefaultError::Ok() || nameError == DefaultError::Unsupported());
+	// containers and restricted environments can refuse to change the scheduling even when it doesn't need any privileges
+	auto isSchedulingResultExpected = [](const Error<> &error)
+	{
+		return error == DefaultError::Ok() || error == DefaultError::AccessDenied() || error == DefaultError::Unsupported();
+	};
+	UTest(true, isSchedulingResultExpected(SchedulingSet(thread, Policy::Normal)));
+	isFinished = true;
+	thread.join();
+
+	Error<> currentNameError = NameSet("StdLib tests");
+	UTest(true, currentNameError == DefaultError::Ok() || currentNameError == DefaultError::Unsupported());
+	// lowering the priority doesn't require any privileges, restoring it can, so it's done on a separate thread
+	std::thread lowered([&isSchedulingResultExpected]
+	{
+		UTest(true, isSchedulingResultExpected(SchedulingSet(Policy::Normal, Priority::Low)));
+		Error<> idleError = SchedulingSet(Policy::Idle);
+		UTest(true, isSchedulingResultExpected(idleError));
+	#ifdef PLATFORM_LINUX
+		if (idleError == DefaultError::Ok())
+		{
+			UTest(Equal, sched_getscheduler(0), SCHED_IDLE);
+		}
+	#endif
+	});
+	lowered.join();
+}
+
+static void TaskGraphTests()
+{
+	ThreadPool pool(4);
+
+	for (uiw round = 0; round < 100; ++round)
+	{
+		TaskGraph graph(pool);
+
+		// diamond, the order is recorded as each task sees it
+		std::atomic<ui32> step{0};
+		ui32 aStep = 0, bStep = 0, cStep = 0, dStep = 0;
+		auto a = graph.Add([&] { aStep = step.fetch_add(1); });
+		auto b = graph.Add([&] { bStep = step.fetch_add(1); }, {a});
+		auto c = graph.Add([&] { cStep = step.fetch_add(1); }, {a});
+		graph.Add([&] { dStep = step.fetch_add(1); }, {b, c});
+
+		// fan-out followed by a join
+		std::atomic<uiw> fanned{0};
+		uiw fannedAtJoin = 0;
+		std::vector<TaskGraph::TaskHandle> fan;
+		for (uiw index = 0; index < 64; ++index)
+		{
+			fan.push_back(graph.Add([&fanned] { fanned.fetch_add(1); }));
+		}
+		graph.Add([&] { fannedAtJoin = fanned.load(); }, fan.data(), fan.size());
+
+		// fork/join through children, the continuation runs only after all of them
+		std::atomic<uiw> children{0};
+		uiw childrenAtContinuation = 0;
+		auto parent = graph.Add([&children](TaskGraph &graph, TaskGraph::TaskHandle self)
+		{
+			for (uiw index = 0; index < 16; ++index)
+			{
+				graph.AddChild(self, [&children](TaskGraph &childGraph, TaskGraph::TaskHandle child)
+				{
+					childGraph.AddChild(child, [&children] { children.fetch_add(1); });
+					children.fetch_add(1);
+				});
+			}
+		});
+		graph.Then(parent, [&] { childrenAtContinuation = children.load(); });
+
+		graph.Wait();
+		UTest(Equal, aStep, 0);
+		UTest(true, bStep > aStep && cStep > aStep);
+		UTest(Equal, dStep, 3);
+		UTest(Equal, fannedAtJoin, 64);
+		UTest(Equal, childrenAtContinuation, 32);
+
+		// depending on an already completed task doesn't delay anything
+		bool isLateExecuted = false;
+		graph.Then(a, [&isLateExecuted] { isLateExecuted = true; });
+		graph.Wait();
+		UTest(true, isLateExecuted);
+
+		UTest(Equal, graph.TasksCount(), 4u + 65u + 1u + 16u * 2u + 1u + 1u);
+		graph.Reset();
+		UTest(Equal, graph.TasksCount(), 0);
+	}
+}
+
+static void ParallelAlgorithmsTests()
+{
+	ThreadPool pool(4);
+	std::mt19937 generator(12345);
+
+	for (uiw grain : {0, 1, 7, 1000, 100000})
+	{
+		std::vector<std::atomic<ui32>> visited(10007);
+		ParallelFor(pool, 3, visited.size(), grain, [&visited](uiw index) { visited[index].fetch_add(1); });
+		bool isEachVisitedOnce = std::all_of(visited.begin() + 3, visited.end(), [](const std::atomic<ui32> &value) { return value.load() == 1; });
+		UTest(true, isEachVisitedOnce && visited[0] == 0 && visited[2] == 0);
+
+		std::atomic<uiw> chunked{0};
+		ParallelFor(pool, 0, 10007, grain, [&chunked, grain](uiw chunkBegin, uiw chunkEnd)
+		{
+			UTest(true, chunkBegin < chunkEnd && (grain == 0 || chunkEnd - chunkBegin <= grain));
+			chunked.fetch_add(chunkEnd - chunkBegin);
+		});
+		UTest(Equal, chunked.load(), 10007);
+
+		uiw sum = ParallelReduce(pool, 1, 100001, grain, uiw(0), [](uiw chunkBegin, uiw chunkEnd)
+		{
+			uiw chunkSum = 0;
+			for (uiw index = chunkBegin; index < chunkEnd; ++index)
+			{
+				chunkSum += index;
+			}
+			return chunkSum;
+		}, [](uiw left, uiw right) { return left + right; });
+		UTest(Equal, sum, uiw(100000) * 100001 / 2);
+	}
+
+	ParallelFor(pool, 5, 5, 0, [](uiw) { UTest(true, false); });
+	UTest(Equal, ParallelReduce(pool, 5, 5, 0, 42, [](uiw, uiw) { return 0; }, std::plus<>()), 42);
+
+	// nested loops from the pool's own tasks don't deadlock
+	std::atomic<uiw> nested{0};
+	ParallelFor(pool, 0, 16, 1, [&pool, &nested](uiw)
+	{
+		ParallelFor(pool, 0, 1000, 10, [&nested](uiw) { nested.fetch_add(1); });
+	});
+	UTest(Equal, nested.load(), 16000);
+
+	for (uiw count : {0, 1, 1000, 300000})
+	{
+		// the keys repeat a lot, the indexes check that the sorts are stable
+		std::vector<std::pair<ui32, ui32>> source(count);
+		for (uiw index = 0; index < count; ++index)
+		{
+			source[index] = {generator() % 1000, static_cast<ui32>(index)};
+		}
+		auto expected = source;
+		std::stable_sort(expected.begin(), expected.end(), [](const auto &left, const auto &right) { return left.first < right.first; });
+
+		auto merged = source;
+		ParallelSort(pool, merged.data(), merged.size(), [](const auto &left, const auto &right) { return left.first < right.first; });
+		UTest(true, merged == expected);
+
+		auto radixed = source;
+		ParallelRadixSort(pool, radixed.data(), radixed.size(), [](const std::pair<ui32, ui32> &value) { return value.first; });
+		UTest(true, radixed == expected);
+
+		std::vector<ui64> keys(count);
+		for (ui64 &key : keys)
+		{
+			key = (ui64(generator()) << 32) | generator();
+		}
+		auto expectedKeys = keys;
+		std::sort(expectedKeys.begin(), expectedKeys.end());
+		auto sortedKeys = keys;
+		ParallelRadixSort(pool, sortedKeys.data(), sortedKeys.size());
+		UTest(true, sortedKeys == expectedKeys);
+		ParallelSort(pool, keys.data(), keys.size());
+		UTest(true, keys == expectedKeys);
+	}
+}
+
+static void RingQueueTests()
+{
+	{
+		SPSCRingQueue<std::unique_ptr<ui32>> queue(4);
+		UTest(Equal, queue.Capacity(), 4);
+		UTest(true, queue.IsEmptyApprox());
+		UTest(Equal, queue.TryPop(), nullopt);
+
+		// goes around the ring a few times
+		for (ui32 round = 0; round < 3; ++round)
+		{
+			std::unique_ptr<ui32> values[6];
+			for (ui32 index = 0; index < 6; ++index)
+			{
+				values[index] = std::make_unique<ui32>(index);
+			}
+			UTest(Equal, queue.TryPushBatch(values, 6), 4);
+			UTest(true, queue.IsFullApprox());
+			UTest(false, queue.TryPush(std::move(values[4])));
+			UTest(true, values[4] != nullptr);
+
+			auto first = queue.TryPop();
+			UTest(true, first && **first == 0);
+			UTest(true, queue.TryPush(std::move(values[4])));
+
+			std::unique_ptr<ui32> popped[8];
+			UTest(Equal, queue.TryPopBatch(popped, 8), 4);
+			UTest(true, *popped[0] == 1 && *popped[1] == 2 && *popped[2] == 3 && *popped[3] == 4);
+			UTest(true, queue.IsEmptyApprox());
+		}
+
+		queue.Push(std::make_unique<ui32>(5)); // left in the queue to be destroyed by it
+	}
+
+	{
+		MPMCRingQueue<std::unique_ptr<ui32>> queue(4);
+		UTest(Equal, queue.Capacity(), 4);
+		UTest(Equal, queue.TryPop(), nullopt);
+		for (ui32 round = 0; round < 3; ++round)
+		{
+			std::unique_ptr<ui32> values[6];
+			for (ui32 index = 0; index < 6; ++index)
+			{
+				values[index] = std::make_unique<ui32>(index);
+			}
+			UTest(Equal, queue.TryPushBatch(values, 6), 4);
+			UTest(true, queue.IsFullApprox());
+			UTest(false, queue.TryPush(std::move(values[4])));
+			UTest(true, values[4] != nullptr);
+
+			std::unique_ptr<ui32> popped[8];
+			UTest(Equal, queue.TryPopBatch(popped, 3), 3);
+			UTest(true, *popped[0] == 0 && *popped[1] == 1 && *popped[2] == 2);
+			auto last = queue.TryPop();
+			UTest(true, last && **last == 3);
+			UTest(true, queue.IsEmptyApprox());
+		}
+		queue.Push(std::make_unique<ui32>(5));
+	}
+
+	constexpr ui32 valuesCount = 200000;
+
+	for (RingQueueMode mode : {RingQueueMode::Spin, RingQueueMode::Blocking})
+	{
+		// the consumer is slower now and then, so the producer hits the full queue and waits
+		SPSCRingQueue<ui32> spsc(64, mode);
+		std::thread producer([&spsc]
+		{
+			ui32 batch[7];
+			for (ui32 value = 0; value < valuesCount; )
+			{
+				if (value % 1000 == 0)
+				{
+					ui32 count = std::min<ui32>(7, valuesCount - value);
+					for (ui32 index = 0; index < count; ++index)
+					{
+						batch[index] = value + index;
+					}
+					spsc.PushBatch(batch, count);
+					value += count;
+				}
+				else
+				{
+					spsc.Push(value++);
+				}
+			}
+		});
+		bool isInOrder = true;
+		for (ui32 expected = 0; expected < valuesCount; )
+		{
+			if (expected % 5000 == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+			ui32 batch[16];
+			uiw count = expected % 3 ? spsc.PopBatch(batch, 16) : (batch[0] = spsc.Pop(), 1);
+			for (uiw index = 0; index < count; ++index)
+			{
+				isInOrder &= batch[index] == expected++;
+			}
+		}
+		producer.join();
+		UTest(true, isInOrder);
+		UTest(true, spsc.IsEmptyApprox());
+
+		// every value is received exactly once, each producer's values stay in order
+		constexpr ui32 producersCount = 4, consumersCount = 4, perProducer = valuesCount / producersCount;
+		MPMCRingQueue<ui32> mpmc(64, mode);
+		std::vector<std::atomic<ui32>> received(valuesCount);
+		std::atomic<ui32> receivedCount{0};
+		std::atomic<bool> isOrderBroken{false};
+		std::vector<std::thread> threads;
+		for (ui32 producerIndex = 0; producerIndex < producersCount; ++producerIndex)
+		{
+			threads.emplace_back([&mpmc, producerIndex]
+			{
+				for (ui32 value = producerIndex * perProducer, end = value + perProducer; value < end; )
+				{
+					ui32 batch[5];
+					ui32 count = std::min<ui32>(value % 2 ? 1 : 5, end - value);
+					for (ui32 index = 0; index < count; ++index)
+					{
+						batch[index] = value + index;
+					}
+					mpmc.PushBatch(batch, count);
+					value += count;
+				}
+				mpmc.Push(ui32_max); // one stop value per consumer
+			});
+		}
+		for (ui32 consumerIndex = 0; consumerIndex < consumersCount; ++consumerIndex)
+		{
+			threads.emplace_back([&]
+			{
+				ui32 last[producersCount];
+				std::fill(std::begin(last), std::end(last), ui32_max);
+				for (;;)
+				{
+					ui32 batch[8];
+					uiw count = mpmc.PopBatch(batch, 8), stopsCount = 0;
+					for (uiw index = 0; index < count; ++index)
+					{
+						if (batch[index] == ui32_max)
+						{
+							++stopsCount;
+							continue;
+						}
+						ui32 producerIndex = batch[index] / perProducer;
+						if (last[producerIndex] != ui32_max && last[producerIndex] >= batch[index])
+						{
+							isOrderBroken = true;
+						}
+						last[producerIndex] = batch[index];
+						received[batch[index]].fetch_add(1);
+						receivedCount.fetch_add(1);
+					}
+					if (stopsCount)
+					{
+						// the stop values that were meant for the other consumers are given back
+						for (uiw index = 1; index < stopsCount; ++index)
+						{
+							mpmc.Push(ui32_max);
+						}
+						return;
+					}
+				}
+			});
+		}
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+		bool isEachReceivedOnce = std::all_of(received.begin(), received.end(), [](const std::atomic<ui32> &value) { return value.load() == 1; });
+		UTest(true, isEachReceivedOnce);
+		UTest(Equal, receivedCount.load(), valuesCount);
+		UTest(false, isOrderBroken.load());
+	}
+}
+
+static void TimedMessageQueueTests()
+{
+	using namespace std::chrono;
+
+	{
+		TimedMessageQueue queue;
+		std::vector<ui32> order;
+		auto record = [](std::vector<ui32> &order, ui32 value) { order.push_back(value); };
+
+		auto start = steady_clock::now();
+		queue.AddAfter(30_ms, record, std::ref(order), 3u);
+		queue.AddAfter(10_ms, record, std::ref(order), 1u);
+		queue.AddAfter(20_ms, record, std::ref(order), 2u);
+		queue.Add(record, std::ref(order), 0u); // immediate messages don't wait for the timers
+		UTest(Equal, queue.ArmedTimersCount(), 3);
+
+		queue.ExecWait();
+		UTest(true, order == std::vector<ui32>{0});
+		queue.ExecWait();
+		UTest(LeftGreaterEqual, steady_clock::now() - start, milliseconds(10));
+		queue.ExecWait();
+		queue.ExecWait();
+		UTest(LeftGreaterEqual, steady_clock::now() - start, milliseconds(30));
+		UTest(true, order == std::vector<ui32>({0, 1, 2, 3}));
+		UTest(false, queue.ExecNoWait());
+
+		// cancelled timers are destroyed without being executed, their handles stop working
+		auto cancelled = queue.AddAfter(5_ms, record, std::ref(order), 4u);
+		auto farCancelled = queue.AddAfter(20_s, record, std::ref(order), 5u);
+		UTest(true, queue.Cancel(cancelled));
+		UTest(false, queue.Cancel(cancelled));
+		UTest(true, queue.Cancel(farCancelled));
+		UTest(false, queue.Cancel(TimedMessageQueue::TimerHandle()));
+		std::this_thread::sleep_for(milliseconds(10));
+		UTest(false, queue.ExecNoWait());
+		UTest(Equal, queue.ArmedTimersCount(), 0);
+
+		// a moment in the past is due right away
+		queue.AddAt(TimeMoment::Now() - 1_s, record, std::ref(order), 6u);
+		UTest(true, queue.ExecNoWait());
+		UTest(Equal, order.back(), 6);
+
+		// a timer that is due but hasn't been executed yet can still be cancelled
+		auto due = queue.AddAt(TimeMoment::Now() - 1_s, record, std::ref(order), 7u);
+		UTest(true, queue.Cancel(due));
+		UTest(false, queue.Cancel(due));
+		UTest(false, queue.ExecNoWait()); // the cancelled message is skipped, so nothing is executed
+		UTest(Equal, order.back(), 6);
+		UTest(Equal, queue.ArmedTimersCount(), 0);
+
+		// periodic messages run until they're cancelled
+		ui32 ticks = 0;
+		start = steady_clock::now();
+		auto periodic = queue.AddPeriodic(2_ms, [](ui32 &ticks) { ++ticks; }, std::ref(ticks));
+		while (ticks < 5)
+		{
+			queue.ExecWait();
+		}
+		UTest(LeftGreaterEqual, steady_clock::now() - start, milliseconds(10));
+		UTest(true, queue.Cancel(periodic));
+		UTest(false, queue.Cancel(periodic));
+		std::this_thread::sleep_for(milliseconds(5));
+		UTest(false, queue.ExecNoWait());
+		UTest(Equal, ticks, 5);
+
+		// the pending messages and the timers own their arguments until they're executed or cleared
+		auto owned = std::make_shared<ui32>(0);
+		queue.Add([](std::shared_ptr<ui32>) {}, owned);
+		queue.AddAfter(1_s, [](std::shared_ptr<ui32>) {}, owned);
+		queue.AddPeriodic(1_ms, [](std::shared_ptr<ui32>) {}, owned);
+		UTest(Equal, owned.use_count(), 4);
+		queue.Clear();
+		UTest(Equal, owned.use_count(), 1);
+		UTest(Equal, queue.ArmedTimersCount(), 0);
+	}
+
+	// microsecond ticks make the timers go through the coarser levels of the wheel and get cascaded
+	{
+		TimedMessageQueue queue(1_us);
+		std::mt19937 generator(12345);
+		constexpr ui32 timersCount = 3000;
+		std::vector<TimeMoment> deadlines(timersCount);
+		std::vector<TimedMessageQueue::TimerHandle> handles(timersCount);
+		std::vector<ui32> executed;
+		bool isEarly = false;
+		TimeMoment start = TimeMoment::Now();
+		for (ui32 index = 0; index < timersCount; ++index)
+		{
+			deadlines[index] = start + TimeDifference(TimeMicroSecondsI64(50'000 + generator() % 300'000)); // all are armed before the first one is due
+			handles[index] = queue.AddAt(deadlines[index], [&executed, &isEarly, &deadlines](ui32 index)
+			{
+				isEarly |= TimeMoment::Now() < deadlines[index];
+				executed.push_back(index);
+			}, index);
+		}
+		ui32 cancelledCount = 0;
+		for (ui32 index = 0; index < timersCount; index += 7, ++cancelledCount)
+		{
+			UTest(true, queue.Cancel(handles[index]));
+		}
+
+		while (executed.size() < timersCount - cancelledCount)
+		{
+			queue.ExecWait();
+		}
+		UTest(false, isEarly);
+		bool isInOrder = std::is_sorted(executed.begin(), executed.end(), [&deadlines](ui32 left, ui32 right) { return deadlines[left] < deadlines[right]; });
+		UTest(true, isInOrder);
+		bool isCancelledExecuted = std::any_of(executed.begin(), executed.end(), [](ui32 index) { return index % 7 == 0; });
+		UTest(false, isCancelledExecuted);
+		UTest(Equal, queue.ArmedTimersCount(), 0);
+	}
+
+	// a sleeping consumer is woken up by an earlier timer, a message or a cancellation doesn't matter to it
+	{
+		TimedMessageQueue queue;
+		auto far = queue.AddAfter(10_s, [] {});
+		bool isExecuted = false;
+		std::thread adder([&queue, &isExecuted]
+		{
+			std::this_thread::sleep_for(milliseconds(20));
+			queue.AddAfter(5_ms, [](bool &isExecuted) { isExecuted = true; }, std::ref(isExecuted));
+		});
+		auto start = steady_clock::now();
+		queue.ExecWait();
+		UTest(LeftLesser, steady_clock::now() - start, seconds(5));
+		UTest(true, isExecuted);
+		adder.join();
+		UTest(true, queue.Cancel(far));
+	}
+}
+
+#ifdef __cpp_impl_coroutine
+static Task<ui32> CoroutineSum(ui32 left, ui32 right)
+{
+	co_return left + right;
+}
+
+static Task<> CoroutineChain(ui32 &result)
+{
+	ui32 first = co_await CoroutineSum(1, 2);
+	ui32 second = co_await CoroutineSum(first, 3);
+	result = second;
+}
+
+static Task<> CoroutineSwitch(ThreadPool &pool, MTMessageQueue &queue, std::thread::id &poolThread, std::thread::id &resumedThread, bool &isDone)
+{
+	poolThread = co_await RunOn(pool, queue, [] { return std::this_thread::get_id(); });
+	resumedThread = std::this_thread::get_id();
+	co_await ResumeOn(pool);
+	UTest(NotEqual, std::this_thread::get_id(), resumedThread);
+	co_await ResumeOn(queue);
+	isDone = true;
+}
+
+static Task<> CoroutineDelay(TimedMessageQueue &timers, TimeMoment &resumedAt, bool &isDone)
+{
+	co_await Delay(timers, 10_ms);
+	resumedAt = TimeMoment::Now();
+	co_await DelayUntil(timers, TimeMoment::Now() - 1_s); // a moment in the past is due right away
+	isDone = true;
+}
+
+static Task<> CoroutineFileRead(IFile &file, ThreadPool &pool, MTMessageQueue &queue, std::string &result, bool &isDone)
+{
+	char buffer[16];
+	auto read = co_await FileRead(file, buffer, sizeof(buffer), pool, queue);
+	UTest(true, read);
+	result.assign(buffer, *read);
+	isDone = true;
+}
+
+static void CoroutineTests()
+{
+	// inline tasks complete before Spawn returns
+	ui32 sum = 0;
+	Spawn(Executor::Inline(), CoroutineChain(sum));
+	UTest(Equal, sum, 6);
+
+	// a task that isn't awaited or spawned never starts
+	{
+		ui32 notStarted = 0;
+		Task<> task = CoroutineChain(notStarted);
+		UTest(false, task.IsDone());
+		UTest(Equal, notStarted, 0);
+	}
+
+	ThreadPool pool(2);
+	MTMessageQueue queue;
+
+	{
+		std::thread::id poolThread, resumedThread;
+		bool isDone = false;
+		Spawn(queue, CoroutineSwitch(pool, queue, poolThread, resumedThread, isDone));
+		while (!isDone)
+		{
+			queue.ExecWait();
+		}
+		UTest(NotEqual, poolThread, std::this_thread::get_id());
+		UTest(Equal, resumedThread, std::this_thread::get_id());
+	}
+
+	{
+		TimedMessageQueue timers;
+		TimeMoment start = TimeMoment::Now(), resumedAt;
+		bool isDone = false;
+		Spawn(Executor::Inline(), CoroutineDelay(timers, resumedAt, isDone));
+		while (!isDone)
+		{
+			timers.ExecWait();
+		}
+		UTest(LeftGreaterEqual, resumedAt - start, 10_ms);
+	}
+
+	{
+		const char content[] = "coroutine file";
+		MemoryStreamFixedExternal stream(content, sizeof(content) - 1, sizeof(content) - 1);
+		MemoryStreamFile file(stream, FileProcModes::Read);
+		std::string result;
+		bool isDone = false;
+		Spawn(Executor::Inline(), CoroutineFileRead(file, pool, queue, result, isDone));
+		while (!isDone)
+		{
+			queue.ExecWait();
+		}
+		UTest(Equal, result, content);
+	}
+}
+#endif
+
+// blocks are allocated on one thread and freed on another, like queued messages are
+static void MessagePoolTests()
+{
+	constexpr uiw sizes[] = {1, 24, 32, 33, 64, 100, 256, 512, 513, 2000};
+	constexpr uiw rounds = 3, allocationsPerSize = 1000;
+
+	for (uiw round = 0; round < rounds; ++round)
+	{
+		std::vector<std::pair<std::byte *, uiw>> allocations;
+		std::thread allocator([&allocations, &sizes]
+		{
+			for (uiw size : sizes)
+			{
+				for (uiw index = 0; index < allocationsPerSize; ++index)
+				{
+					auto *memory = static_cast<std::byte *>(MessagePool::Allocate(size));
+					UTest(Equal, reinterpret_cast<uiw>(memory) % alignof(std::max_align_t), 0);
+					MemOps::Set(memory, static_cast<ui8>(size), size);
+					allocations.emplace_back(memory, size);
+				}
+			}
+		});
+		allocator.join();
+
+		bool isIntact = true;
+		for (auto[memory, size] : allocations)
+		{
+			for (uiw index = 0; index < size; ++index)
+			{
+				isIntact &= memory[index] == static_cast<std::byte>(size);
+			}
+			MessagePool::Free(memory, size);
+		}
+		UTest(true, isIntact);
+	}
+
+	auto *pair = MessagePool::New<std::pair<ui64, ui32>>(5u, 6u);
+	UTest(Equal, pair->first, 5u);
+	UTest(Equal, pair->second, 6u);
+	MessagePool::Free(pair, sizeof(*pair));
+}
+
+// every producer posts increasing sequence numbers, the consumer checks that each producer's messages arrive in order
+static void MPSCMessageQueueStressTests()
+{
+	constexpr uiw producersCount = 4, messagesPerProducer = 20000;
+
+	MPSCMessageQueue queue;
+	std::array<uiw, producersCount> lastReceived{};
+	bool isOrderCorrect = true;
+
+	auto receive = [&lastReceived, &isOrderCorrect](uiw producer, uiw sequence)
+	{
+		if (lastReceived[producer] + 1 != sequence)
+		{
+			isOrderCorrect = false;
+		}
+		lastReceived[producer] = sequence;
+	};
+
+	std::thread consumer([&queue]
+	{
+		for (uiw index = 0; index < producersCount * messagesPerProducer; ++index)
+		{
+			queue.ExecWait();
+		}
+	});
+
+	std::vector<std::thread> producers;
+	for (uiw producer = 0; producer < producersCount; ++producer)
+	{
+		producers.emplace_back([&queue, &receive, producer]
+		{
+			for (uiw sequence = 1; sequence <= messagesPerProducer; ++sequence)
+			{
+				queue.Add<&decltype(receive)::operator()>(receive, producer, sequence);
+				if (sequence % 4096 == 0)
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(100)); // lets the consumer go to sleep once in a while
+				}
+			}
+		});
+	}
+	for (auto &producer : producers)
+	{
+		producer.join();
+	}
+	consumer.join();
+
+	UTest(true, isOrderCorrect);
+	for (uiw producer = 0; producer < producersCount; ++producer)
+	{
+		UTest(Equal, lastReceived[producer], messagesPerProducer);
+	}
+	UTest(false, queue.ExecNoWait());
+
+	// the remaining messages must be destroyed without being executed
+	auto counter = std::make_shared<int>(0);
+	queue.Add([](std::shared_ptr<int> value) { ++*value; }, counter);
+	queue.Add([](std::shared_ptr<int> value) { ++*value; }, counter);
+	UTest(Equal, counter.use_count(), 3);
+	queue.Clear();
+	UTest(Equal, counter.use_count(), 1);
+	UTest(Equal, *counter, 0);
+}
+
 void MTTests()
 {
-	DIWRSpinLockTests();
+	DIWRSpinLockTests<DIWRSpinLock>();
+	DIWRSpinLockTests<DIWRSpinLockDistributed>();
+	DIWRSpinLockStressTests<DIWRSpinLock>();
+	DIWRSpinLockStressTests<DIWRSpinLockDistributed>();
+	DIWRSpinLockTests<DIWRSpinLock>(DIWRSpinLock::Mode::Blocking);
+	DIWRSpinLockStressTests<DIWRSpinLock>(DIWRSpinLock::Mode::Blocking);
+	DIWRSpinLockTimedTests();
 	SpinLockTests();
-	MessageQueueTests();
+	LockProfilerTests();
+	SeqLockTests();
+	ShardedCounterTests();
+	EpochDomainTests();
+	MessageQueueTests<MTMessageQueue>();
+	MessageQueueTests<MPSCMessageQueue>();
+	MPSCMessageQueueStressTests();
+	MessagePoolTests();
+	MessageQueueBatchTests();
+	WorkStealingDequeTests();
+	ThreadControlTests();
+	ThreadPoolTests();
+	TaskGraphTests();
+	ParallelAlgorithmsTests();
+	RingQueueTests();
+	TimedMessageQueueTests();
+#ifdef __cpp_impl_coroutine
+	CoroutineTests();
+#endif
 
     UnitTestsLogger::Message("finished multithreaded tests\n");
 }
\ No newline at end of file
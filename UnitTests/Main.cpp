@@ -8,6 +8,7 @@ void UniqueIdManagerTests();
 void UniqueIdManagerBenchmark();
 void LoggerTests();
 void MTTests();
+void FlatHashMapTests();
 
 static void MiscTests()
 {
@@ -401,6 +402,90 @@ template <Hash::Precision precision, typename T> static void TestIntegerHashes()
     UTest(Equal, Hash::IntegerInverse<precision>(hash2), 5);
 }
 
+template <Hash::Precision precision> static void TestFastHashes()
+{
+	constexpr std::array<ui8, 300> compileTimeSource = []
+	{
+		std::array<ui8, 300> result{};
+		ui32 state = 1;
+		for (ui8 &value : result)
+		{
+			state = state * 1664525u + 1013904223u;
+			value = static_cast<ui8>(state >> 24);
+		}
+		return result;
+	}();
+	constexpr auto compileTimeHash = Hash::FastHashCT<precision, ui8, compileTimeSource.size()>(compileTimeSource.data());
+	UTest(Equal, compileTimeHash, Hash::FastHash<precision>(compileTimeSource.data(), compileTimeSource.size()));
+
+	std::vector<ui8> source(3000);
+	ui32 state = 1;
+	for (ui8 &value : source)
+	{
+		state = state * 1664525u + 1013904223u;
+		value = static_cast<ui8>(state >> 24);
+	}
+
+	// lengths around the short/long, stripe and block boundaries, the SIMD path must match the scalar one
+	for (uiw length : {0, 1, 3, 4, 8, 16, 17, 48, 49, 240, 241, 1024, 1025, 2048, 3000})
+	{
+		auto hash = Hash::FastHash<precision>(source.data(), length);
+		UTest(Equal, hash, (Hash::_FastHash<precision, false>(source.data(), length)));
+		if (length)
+		{
+			source[length - 1] ^= 1;
+			UTest(NotEqual, hash, Hash::FastHash<precision>(source.data(), length));
+			source[length - 1] ^= 1;
+		}
+
+		// the incremental hasher must produce the same hash regardless of how the data is split
+		for (uiw pieceLength : {1, 63, 64, 1000, 1024, 1500})
+		{
+			Hash::FastHasher<precision> hasher;
+			for (uiw offset = 0; offset < length; offset += pieceLength)
+			{
+				hasher.Update(source.data() + offset, std::min(pieceLength, length - offset));
+			}
+			UTest(Equal, hasher.Finish(), hash);
+		}
+	}
+}
+
+template <Hash::Precision precision, typename T> static void TestIntegerBatchHashes()
+{
+	using resultType = decltype(Hash::Integer<precision>(T()));
+
+	std::vector<T> source(37);
+	ui64 state = 1;
+	for (T &value : source)
+	{
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		value = static_cast<T>(state >> 7);
+	}
+
+	// odd counts check the scalar tail after the vectorized part
+	for (uiw count : {0, 1, 3, 8, 37})
+	{
+		std::vector<resultType> hashed(count), restored(count);
+		Hash::IntegerBatch<precision>(source.data(), hashed.data(), count);
+		Hash::IntegerInverseBatch<precision>(hashed.data(), restored.data(), count);
+		for (uiw index = 0; index < count; ++index)
+		{
+			UTest(Equal, hashed[index], Hash::Integer<precision>(source[index]));
+			UTest(Equal, restored[index], Hash::IntegerInverse<precision>(hashed[index]));
+			UTest(Equal, restored[index], static_cast<resultType>(Funcs::ToFundamental(source[index])));
+		}
+	}
+
+	if constexpr (sizeof(T) == sizeof(resultType))
+	{
+		std::vector<resultType> inPlace(source.size());
+		MemOps::Copy(reinterpret_cast<std::byte *>(inPlace.data()), reinterpret_cast<const std::byte *>(source.data()), source.size() * sizeof(T));
+		Hash::IntegerBatch<precision>(inPlace.data(), inPlace.data(), inPlace.size());
+		UTest(Equal, inPlace.back(), Hash::Integer<precision>(source.back()));
+	}
+}
+
 static void HashFuncsTest()
 {
 	constexpr ui32 value = 23534;
@@ -428,6 +513,34 @@ static void HashFuncsTest()
 	crc32 = Hash::CRC32(reinterpret_cast<const ui8 *>(crc32str), strlen(crc32str));
 	UTest(Equal, crc32, 0xD85554CE);
 
+	Hash::CRC32Hasher crc32Hasher;
+	crc32Hasher.Update(crc32str, 5);
+	crc32Hasher.Update(crc32str + 5, strlen(crc32str) - 5);
+	UTest(Equal, crc32Hasher.Finish(), 0xD85554CE);
+
+	Hash::FNVHasher<Hash::Precision::P64> fnvHasher;
+	fnvHasher.Update(name, 4);
+	fnvHasher.Update(name + 4, CountOf(name) - 4);
+	UTest(Equal, fnvHasher.Finish(), nameHashed);
+
+	MemoryStreamFixedExternal crc32Stream(crc32str, strlen(crc32str), strlen(crc32str));
+	UTest(Equal, Hash::HashMemoryStream<Hash::CRC32Hasher>(crc32Stream), 0xD85554CE);
+	MemoryStreamFile crc32File(crc32Stream, FileProcModes::Read);
+	auto crc32FileHash = Hash::HashFile<Hash::CRC32Hasher>(crc32File);
+	UTest(true, crc32FileHash);
+	UTest(Equal, *crc32FileHash, 0xD85554CE);
+
+	constexpr ui8 fastName[] = "Test Name";
+	constexpr ui64 fastNameHashedCT = Hash::FastHashCT<Hash::Precision::P64>(fastName);
+	UTest(Equal, fastNameHashedCT, Hash::FastHash<Hash::Precision::P64>(fastName, CountOf(fastName)));
+	Hash::Hash128 fastName128 = Hash::FastHash<Hash::Precision::P128>(fastName, CountOf(fastName));
+	UTest(NotEqual, fastName128.high, fastName128.low);
+	UTest(Equal, fastName128.low, fastNameHashedCT);
+
+	TestFastHashes<Hash::Precision::P32>();
+	TestFastHashes<Hash::Precision::P64>();
+	TestFastHashes<Hash::Precision::P128>();
+
     TestIntegerHashes<Hash::Precision::P64, ui8>();
 	TestIntegerHashes<Hash::Precision::P32, ui8>();
 	TestIntegerHashes<Hash::Precision::P32, ui16>();
@@ -445,6 +558,13 @@ static void HashFuncsTest()
 	TestIntegerHashes<Hash::Precision::P32, i64>();
 	TestIntegerHashes<Hash::Precision::P64, i64>();
 
+	TestIntegerBatchHashes<Hash::Precision::P32, ui32>();
+	TestIntegerBatchHashes<Hash::Precision::P64, ui64>();
+	TestIntegerBatchHashes<Hash::Precision::P32, i32>();
+	TestIntegerBatchHashes<Hash::Precision::P64, i64>();
+	TestIntegerBatchHashes<Hash::Precision::P32, ui16>();
+	TestIntegerBatchHashes<Hash::Precision::P64, ui32>();
+
 	UnitTestsLogger::Message("finished hash tests\n");
 }
 WARNING_POP
@@ -1436,6 +1556,46 @@ static void TestMemoryMappedFile(const FilePath &folderForTests)
     UnitTestsLogger::Message("finished memory mapped file tests\n");
 }
 
+static void ParallelHashingTests(const FilePath &folderForTests)
+{
+	const char *crc32str = "Skellig Peaceful Theme.mp3";
+	ui32 crc32First = Hash::CRC32(reinterpret_cast<const ui8 *>(crc32str), 8);
+	ui32 crc32Second = Hash::CRC32(reinterpret_cast<const ui8 *>(crc32str) + 8, strlen(crc32str) - 8);
+	UTest(Equal, Hash::CRC32Combine(crc32First, crc32Second, strlen(crc32str) - 8), 0xD85554CE);
+	UTest(Equal, Hash::CRC32Combine(crc32First, 0, 0), crc32First);
+
+	std::vector<ui8> source(Hash::CRC32ParallelChunkLength * 2 + 12345);
+	ui32 state = 1;
+	for (ui8 &value : source)
+	{
+		state = state * 1664525u + 1013904223u;
+		value = static_cast<ui8>(state >> 24);
+	}
+
+	UTest(Equal, Hash::CRC32Parallel(source.data(), source.size(), 3), Hash::CRC32(source.data(), source.size()));
+	UTest(Equal, Hash::CRC32Parallel(source.data(), 1000), Hash::CRC32(source.data(), 1000));
+
+	constexpr uiw leafLength = 1 << 16;
+	ui64 treeHash = Hash::FastHashTree<Hash::Precision::P64>(source.data(), source.size(), leafLength);
+	UTest(Equal, Hash::FastHashTreeParallel<Hash::Precision::P64>(source.data(), source.size(), leafLength, 3), treeHash);
+	UTest(NotEqual, Hash::FastHashTree<Hash::Precision::P64>(source.data(), source.size(), leafLength * 2), treeHash);
+	UTest(NotEqual, Hash::FastHash<Hash::Precision::P64>(source.data(), source.size()), treeHash);
+
+	File file = File(folderForTests / TSTR("parallelHashing.bin"), FileOpenMode::CreateAlways, FileProcModes::ReadWrite);
+	UTest(true, file);
+	auto fileCRC32 = Hash::CRC32Parallel(file);
+	UTest(Equal, fileCRC32.Unwrap(), Hash::CRC32(source.data(), 0));
+	UTest(true, file.Write(source.data(), 100000));
+	UTest(true, file.Flush());
+	fileCRC32 = Hash::CRC32Parallel(file);
+	UTest(Equal, fileCRC32.Unwrap(), Hash::CRC32(source.data(), 100000));
+	auto fileTreeHash = Hash::FastHashTreeParallel<Hash::Precision::P128>(file, 4096);
+	UTest(Equal, fileTreeHash.Unwrap(), Hash::FastHashTree<Hash::Precision::P128>(source.data(), 100000, 4096));
+	file.Close();
+
+	UnitTestsLogger::Message("finished parallel hashing tests\n");
+}
+
 namespace
 {
 	TimeDifference GlobalTimeDifferenceTest(15.5_ms);
@@ -1932,6 +2092,7 @@ static void DoTests(int argc, char **argv)
 #endif
     TestFileSystem(folderForTests);
     TestMemoryMappedFile(folderForTests);
+    ParallelHashingTests(folderForTests);
     TimeMomentTests();
     DataHolderTests();
     MemoryStreamTests();
@@ -1940,6 +2101,7 @@ static void DoTests(int argc, char **argv)
 	TypeTests();
     MathLibTests();
     UniqueIdManagerTests();
+    FlatHashMapTests();
 	LoggerTests();
     MTTests();
 	PrintSystemInfo();
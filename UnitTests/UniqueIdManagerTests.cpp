@@ -2,6 +2,218 @@
 
 using namespace StdLib;
 
+static void ConcurrentUniqueIdManagerTests()
+{
+    constexpr ui32 threadsCount = 8;
+    constexpr ui32 idsPerThread = 20'000;
+
+    ConcurrentUniqueIdManager manager;
+    std::vector<std::vector<ui32>> threadIds(threadsCount);
+
+    // every thread allocates its own ids, frees half of them and allocates them again, so the freed ids
+    // are claimed by the other threads too
+    auto work = [&manager, &threadIds](ui32 threadIndex)
+    {
+        std::vector<ui32> &ids = threadIds[threadIndex];
+        for (ui32 index = 0; index < idsPerThread; ++index)
+        {
+            ids.push_back(manager.Allocate());
+        }
+        for (ui32 index = 0; index < idsPerThread; index += 2)
+        {
+            bool result = manager.Free(ids[index]);
+            ASSUME(result);
+        }
+        for (ui32 index = 0; index < idsPerThread; index += 2)
+        {
+            ids[index] = manager.Allocate();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (ui32 threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+    {
+        threads.emplace_back(work, threadIndex);
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::unordered_set<ui32> allIds;
+    for (const std::vector<ui32> &ids : threadIds)
+    {
+        for (ui32 id : ids)
+        {
+            ASSUME(id != ConcurrentUniqueIdManager::invalidId);
+            bool isInserted = allIds.insert(id).second;
+            ASSUME(isInserted);
+            ASSUME(manager.IsAllocated(id));
+        }
+    }
+
+    // the masks of the levels above must not lose any free ids, after freeing everything the ids are handed out densely again
+    for (ui32 id : allIds)
+    {
+        bool result = manager.Free(id);
+        ASSUME(result);
+    }
+    for (ui32 id = 0; id < threadsCount * idsPerThread; ++id)
+    {
+        ui32 allocated = manager.Allocate();
+        ASSUME(allocated == id);
+    }
+
+    bool result = manager.Allocate(5'000'000);
+    ASSUME(result);
+    result = manager.Allocate(5'000'000);
+    ASSUME(result == false);
+    ASSUME(manager.IsAllocated(5'000'000));
+    result = manager.Free(5'000'000);
+    ASSUME(result);
+    result = manager.Free(5'000'000);
+    ASSUME(result == false);
+    result = manager.Free(100'000'000);
+    ASSUME(result == false);
+}
+
+static void UniqueIdManagerEnumerationTests()
+{
+    UniqueIdManager manager;
+    ASSUME(manager.begin() == manager.end());
+
+    // the ids are spread over all levels, including the last id before invalidId
+    std::vector<ui32> ids = {0, 63, 64, 4095, 4096, 262'143, 262'144, 16'777'216, 1'073'741'823, 1'073'741'824, 3'000'000'000, UniqueIdManager::invalidId - 1};
+    std::mt19937 generator(123);
+    for (ui32 index = 0; index < 2'000; ++index)
+    {
+        ids.push_back(generator() % 100'000);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    for (ui32 id : ids)
+    {
+        bool result = manager.Allocate(id);
+        ASSUME(result);
+    }
+
+    std::vector<ui32> iterated(manager.begin(), manager.end());
+    ASSUME(iterated == ids);
+
+    std::vector<ui32> visited;
+    manager.ForEachAllocated([&visited](ui32 id) { visited.push_back(id); });
+    ASSUME(visited == ids);
+
+    // the freed parts are skipped, the ids can be freed while iterating
+    for (ui32 id : manager)
+    {
+        if (id % 2)
+        {
+            bool result = manager.Free(id);
+            ASSUME(result);
+        }
+    }
+    ids.erase(std::remove_if(ids.begin(), ids.end(), [](ui32 id) { return id % 2 != 0; }), ids.end());
+    iterated.assign(manager.begin(), manager.end());
+    ASSUME(iterated == ids);
+
+    for (ui32 id : ids)
+    {
+        bool result = manager.Free(id);
+        ASSUME(result);
+    }
+    ASSUME(manager.begin() == manager.end());
+    visited.clear();
+    manager.ForEachAllocated([&visited](ui32 id) { visited.push_back(id); });
+    ASSUME(visited.empty());
+
+    // a full word
+    for (ui32 index = 0; index < 130; ++index)
+    {
+        ui32 allocated = manager.Allocate();
+        ASSUME(allocated == index);
+    }
+    iterated.assign(manager.begin(), manager.end());
+    ASSUME(iterated.size() == 130 && iterated.back() == 129);
+}
+
+static void UniqueIdManagerShrinkTests()
+{
+    constexpr ui32 blockSize = 64 * 64;
+
+    UniqueIdManager manager;
+    const uiw emptyUsage = manager.MemoryUsage();
+    ASSUME(emptyUsage == sizeof(UniqueIdManager));
+
+    auto allocateRange = [&manager](ui32 from, ui32 to)
+    {
+        for (ui32 index = from; index < to; ++index)
+        {
+            ui32 allocated = manager.Allocate();
+            ASSUME(allocated == index);
+        }
+    };
+
+    auto freeRange = [&manager](ui32 from, ui32 to)
+    {
+        for (ui32 index = from; index < to; ++index)
+        {
+            bool result = manager.Free(index);
+            ASSUME(result);
+        }
+    };
+
+    allocateRange(0, blockSize * 8);
+    const uiw fullUsage = manager.MemoryUsage();
+    ASSUME(fullUsage > emptyUsage);
+
+    // the levels aren't released until ShrinkToFit, the levels that still have allocated ids are kept
+    freeRange(0, blockSize + 5);
+    freeRange(blockSize + 6, blockSize * 8);
+    ASSUME(manager.MemoryUsage() == fullUsage);
+    manager.ShrinkToFit();
+    const uiw singleBlockUsage = manager.MemoryUsage();
+    ASSUME(singleBlockUsage > emptyUsage && singleBlockUsage < fullUsage);
+    ASSUME(manager.IsAllocated(blockSize + 5));
+    std::vector<ui32> allocatedIds(manager.begin(), manager.end());
+    ASSUME(allocatedIds == std::vector<ui32>{blockSize + 5});
+    allocateRange(0, 1);
+    freeRange(0, 1);
+
+    freeRange(blockSize + 5, blockSize + 6);
+    manager.ShrinkToFit();
+    ASSUME(manager.MemoryUsage() == emptyUsage);
+    ASSUME(manager.begin() == manager.end());
+    allocateRange(0, 1);
+    freeRange(0, 1);
+    manager.ShrinkToFit();
+
+    // with the automatic release, the free blocks are kept until there are more of them than the threshold
+    manager.AutoShrinkSet(2);
+    allocateRange(0, blockSize * 8);
+    ASSUME(manager.MemoryUsage() == fullUsage);
+    freeRange(0, blockSize * 2);
+    ASSUME(manager.MemoryUsage() == fullUsage);
+    freeRange(blockSize * 2, blockSize * 3);
+    ASSUME(manager.MemoryUsage() < fullUsage);
+
+    // allocating and freeing around the boundary of a block doesn't release it
+    manager.ShrinkToFit();
+    const uiw shrunkUsage = manager.MemoryUsage();
+    for (ui32 index = 0; index < 10; ++index)
+    {
+        allocateRange(0, 1);
+        freeRange(0, 1);
+    }
+    ASSUME(manager.MemoryUsage() > shrunkUsage);
+
+    manager.AutoShrinkSet(std::nullopt);
+    freeRange(blockSize * 3, blockSize * 8);
+    ASSUME(manager.MemoryUsage() > emptyUsage);
+    manager.AutoShrinkSet(0);
+    ASSUME(manager.MemoryUsage() == emptyUsage);
+}
+
 void UniqueIdManagerTests()
 {
     ui32 requestSize = 1'000;
@@ -123,5 +335,9 @@ void UniqueIdManagerTests()
         ASSUME(result == false);
     }
 
+    UniqueIdManagerEnumerationTests();
+    UniqueIdManagerShrinkTests();
+    ConcurrentUniqueIdManagerTests();
+
     UnitTestsLogger::Message("finished unique id manager tests\n");
 }
\ No newline at end of file